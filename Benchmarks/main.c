@@ -0,0 +1,290 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <time.h>
+#include "SqliteWrapper.h"
+
+#define BENCHMARK_DISK_DB "bench.db"
+#define BENCHMARK_MEMORY_DB ":memory:"
+
+#define BENCHMARK_TABLE_ROWS 10000
+#define BENCHMARK_INSERT_OPS 20000
+#define BENCHMARK_LOOKUP_OPS 50000
+#define BENCHMARK_SCAN_OPS 50
+#define BENCHMARK_CALLBACK_OPS 50
+#define BENCHMARK_FORMAT_OPS 100000
+#define BENCHMARK_IMPORT_OPS 20
+#define BENCHMARK_EXPORT_OPS 50
+#define BENCHMARK_MAP_PAGE_ROWS 256
+#define BENCHMARK_WARMUP_OPS 100
+
+// Single measured operation, returns false on error
+typedef bool (*BenchmarkOperation)(sqlite3 *db, uint32_t iteration);
+
+typedef struct Benchmark {
+    const char *name;
+    BenchmarkOperation operation;
+    uint32_t ops;
+    uint32_t itemsPerOp;    // rows processed by one operation
+} Benchmark;
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+static volatile uint64_t allocationCount = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    allocationCount++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static char *importCsv = NULL;
+static size_t importCsvSize = 0;
+
+static uint64_t benchmarkClockNanos(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+static int compareNanos(const void *first, const void *second) {
+    uint64_t a = *(const uint64_t *) first;
+    uint64_t b = *(const uint64_t *) second;
+    return (a > b) - (a < b);
+}
+
+static bool insertRow(sqlite3 *db, uint32_t iteration) {
+    return executeUpdate(db, "INSERT INTO bench_insert VALUES (NULL, :value, :data, :amount)",
+                         SQL_PARAM_MAP("value", (int) iteration, "data", "benchmark row text", "amount", iteration * 0.25)) == SQLITE_OK;
+}
+
+static bool pointLookup(sqlite3 *db, uint32_t iteration) {
+    ResultSet *rs = executeQuery(db, "SELECT id, value, data FROM bench_data WHERE id = :id", SQL_PARAM_MAP("id", (int) (iteration % BENCHMARK_TABLE_ROWS) + 1));
+    bool isFound = rs != NULL && nextResultSet(rs) && rsGetInt(rs, "value") >= 0 && rsGetString(rs, "data") != NULL;
+    resultSetDelete(rs);
+    return isFound;
+}
+
+static bool fullScan(sqlite3 *db, uint32_t iteration) {
+    ResultSet *rs = executeQuery(db, "SELECT id, value, data, amount FROM bench_data", NULL);
+    if (rs == NULL) return false;
+    int valueColumn = rsColumnIndex(rs, "value");
+    int amountColumn = rsColumnIndex(rs, "amount");
+    int64_t valueSum = 0;
+    double amountSum = 0;
+    while (nextResultSet(rs)) {
+        valueSum += rsGetI64ByIndex(rs, valueColumn);
+        amountSum += rsGetDoubleByIndex(rs, amountColumn);
+    }
+    resultSetDelete(rs);
+    return valueSum > 0 && amountSum > 0;
+}
+
+typedef struct BenchRow {
+    int id;
+    int64_t value;
+    char data[32];
+    double amount;
+} BenchRow;
+
+static const RowField benchRowFields[] = {
+        ROW_FIELD(BenchRow, id, "id"),
+        ROW_FIELD(BenchRow, value, "value"),
+        ROW_TEXT_FIELD(BenchRow, data, "data"),
+        ROW_FIELD(BenchRow, amount, "amount"),
+};
+static const RowMapping benchRowMapping = ROW_MAPPING(BenchRow, benchRowFields);
+
+static bool mappedScan(sqlite3 *db, uint32_t iteration) {
+    ResultSet *rs = executeQuery(db, "SELECT id, value, data, amount FROM bench_data", NULL);
+    if (rs == NULL) return false;
+    static BenchRow rows[BENCHMARK_MAP_PAGE_ROWS];
+    uint32_t rowCount;
+    uint32_t totalRows = 0;
+    int64_t valueSum = 0;
+    int rc;
+    while ((rc = rsMapRows(rs, &benchRowMapping, rows, BENCHMARK_MAP_PAGE_ROWS, NULL, &rowCount)) == SQLITE_OK && rowCount > 0) {
+        for (uint32_t i = 0; i < rowCount; i++) {
+            valueSum += rows[i].value;
+        }
+        totalRows += rowCount;
+    }
+    resultSetDelete(rs);
+    return rc == SQLITE_OK && totalRows == BENCHMARK_TABLE_ROWS && valueSum > 0;
+}
+
+static bool insertStructRows(sqlite3 *db, uint32_t iteration) {
+    static BenchRow rows[BENCHMARK_TABLE_ROWS];
+    if (rows[0].value == 0) {
+        for (uint32_t i = 0; i < BENCHMARK_TABLE_ROWS; i++) {
+            rows[i] = (BenchRow) {.value = i + 1, .amount = i * 0.5};
+            snprintf(rows[i].data, sizeof(rows[i].data), "struct_%u", i);
+        }
+    }
+    BatchStats stats;
+    int rc = executeBatchStructUpdate(db, "INSERT INTO bench_import VALUES (NULL, :value, :data, :amount)",
+                                      &benchRowMapping, rows, BENCHMARK_TABLE_ROWS, &(BatchOptions) {.commitRows = BENCHMARK_TABLE_ROWS}, &stats);
+    return rc == SQLITE_OK && stats.rowsWritten == BENCHMARK_TABLE_ROWS;
+}
+
+static bool callbackScan(sqlite3 *db, uint32_t iteration) {
+    ResultSet *rs = executeCallbackQuery(db, "SELECT id, value, data, amount FROM bench_data", NULL);
+    bool isValid = rs != NULL && rs->rowCount == BENCHMARK_TABLE_ROWS;
+    resultSetDelete(rs);
+    return isValid;
+}
+
+static bool formatNamedQuery(sqlite3 *db, uint32_t iteration) {
+    QueryString *query = namedQueryString("SELECT * FROM bench_data WHERE id = :id AND value > :value AND data <> :data",
+                                          SQL_PARAM_MAP("id", (int) iteration, "value", 10, "data", "text"));
+    bool isValid = query != NULL && query->size > 0;
+    deleteQueryString(query);
+    return isValid;
+}
+
+static bool importRows(sqlite3 *db, uint32_t iteration) {
+    ImportStats stats;
+    int rc = sqliteImportBuffer(db, importCsv, importCsvSize, "bench_import", &(ImportOptions) {.isEmptyNull = true}, &stats);
+    return rc == SQLITE_OK && stats.rowsImported == BENCHMARK_TABLE_ROWS;
+}
+
+static int discardExport(void *context, const char *data, size_t size) {
+    *(uint64_t *) context += size;
+    return SQLITE_OK;
+}
+
+static bool exportRows(sqlite3 *db, uint32_t iteration) {
+    ResultSet *rs = executeQuery(db, "SELECT id, value, data, amount FROM bench_data", NULL);
+    uint64_t size = 0;
+    ExportStats stats;
+    int rc = rsExportToSink(rs, discardExport, &size, &(ExportOptions) {.format = iteration % 2 == 0 ? EXPORT_CSV : EXPORT_JSON_LINES}, &stats);
+    resultSetDelete(rs);
+    return rc == SQLITE_OK && stats.rowsExported == BENCHMARK_TABLE_ROWS && size > 0;
+}
+
+static bool prepareImportCsv(void) {
+    if (importCsv != NULL) return true;
+    size_t capacity = (size_t) BENCHMARK_TABLE_ROWS * 64;
+    importCsv = malloc(capacity);
+    if (importCsv == NULL) return false;
+    for (uint32_t i = 0; i < BENCHMARK_TABLE_ROWS; i++) {
+        importCsvSize += (size_t) snprintf(importCsv + importCsvSize, capacity - importCsvSize,
+                                           ",%" PRIu32 ",\"benchmark, row text\",%.2f\n", i, i * 0.25);
+    }
+    return true;
+}
+
+static bool prepareDb(sqlite3 *db) {
+    executeUpdate(db, "DROP TABLE IF EXISTS bench_insert", NULL);
+    executeUpdate(db, "DROP TABLE IF EXISTS bench_data", NULL);
+    executeUpdate(db, "DROP TABLE IF EXISTS bench_import", NULL);
+    int rc = executeUpdate(db, "CREATE TABLE bench_insert(id INTEGER PRIMARY KEY, value INTEGER, data TEXT, amount DOUBLE)", NULL);
+    if (rc != SQLITE_OK) return false;
+    rc = executeUpdate(db, "CREATE TABLE bench_data(id INTEGER PRIMARY KEY, value INTEGER, data TEXT, amount DOUBLE)", NULL);
+    if (rc != SQLITE_OK) return false;
+    rc = executeUpdate(db, "CREATE TABLE bench_import(id INTEGER PRIMARY KEY, value INTEGER, data TEXT, amount DOUBLE)", NULL);
+    if (rc != SQLITE_OK || !prepareImportCsv()) return false;
+
+    executeUpdate(db, "BEGIN", NULL);
+    for (uint32_t i = 0; i < BENCHMARK_TABLE_ROWS; i++) {
+        rc = executeUpdate(db, "INSERT INTO bench_data VALUES (NULL, :value, :data, :amount)",
+                           SQL_PARAM_MAP("value", (int) i, "data", "benchmark row text", "amount", i * 0.5 + 1));
+        if (rc != SQLITE_OK) return false;
+    }
+    return executeUpdate(db, "COMMIT", NULL) == SQLITE_OK;
+}
+
+static bool runBenchmark(sqlite3 *db, const Benchmark *benchmark) {
+    uint64_t *latencies = malloc(sizeof(uint64_t) * benchmark->ops);
+    if (latencies == NULL) return false;
+
+    for (uint32_t i = 0; i < BENCHMARK_WARMUP_OPS && i < benchmark->ops; i++) {
+        if (!benchmark->operation(db, i)) {
+            printf("%-24s FAILED: %s\n", benchmark->name, sqlite3_errmsg(db));
+            free(latencies);
+            return false;
+        }
+    }
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    uint64_t allocationsBefore = allocationCount;
+#endif
+    uint64_t totalStart = benchmarkClockNanos();
+    for (uint32_t i = 0; i < benchmark->ops; i++) {
+        uint64_t start = benchmarkClockNanos();
+        benchmark->operation(db, i);
+        latencies[i] = benchmarkClockNanos() - start;
+    }
+    uint64_t totalNanos = benchmarkClockNanos() - totalStart;
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    double allocationsPerOp = (double) (allocationCount - allocationsBefore) / benchmark->ops;
+#else
+    double allocationsPerOp = -1;
+#endif
+
+    qsort(latencies, benchmark->ops, sizeof(uint64_t), compareNanos);
+    double seconds = (double) totalNanos / 1e9;
+    printf("%-24s %12.0f ops/s %14.0f rows/s   p50 %10.2f us   p99 %10.2f us   %8.1f allocs/op\n",
+           benchmark->name,
+           benchmark->ops / seconds,
+           (double) benchmark->ops * benchmark->itemsPerOp / seconds,
+           latencies[benchmark->ops / 2] / 1000.0,
+           latencies[(uint32_t) (benchmark->ops * 0.99)] / 1000.0,
+           allocationsPerOp);
+    free(latencies);
+    return true;
+}
+
+static bool runBenchmarks(const char *dbName) {
+    sqlite3 *db = sqliteDbInit(dbName);
+    if (db == NULL || !prepareDb(db)) {
+        printf("Failed to prepare db: %s\n", dbName);
+        sqliteDbClose(db);
+        return false;
+    }
+
+    static const Benchmark benchmarks[] = {
+            {"executeUpdate insert", insertRow, BENCHMARK_INSERT_OPS, 1},
+            {"executeQuery lookup", pointLookup, BENCHMARK_LOOKUP_OPS, 1},
+            {"nextResultSet scan", fullScan, BENCHMARK_SCAN_OPS, BENCHMARK_TABLE_ROWS},
+            {"rsMapRows scan", mappedScan, BENCHMARK_SCAN_OPS, BENCHMARK_TABLE_ROWS},
+            {"executeCallbackQuery", callbackScan, BENCHMARK_CALLBACK_OPS, BENCHMARK_TABLE_ROWS},
+            {"namedQueryString", formatNamedQuery, BENCHMARK_FORMAT_OPS, 1},
+            {"sqliteImportBuffer", importRows, BENCHMARK_IMPORT_OPS, BENCHMARK_TABLE_ROWS},
+            {"executeBatchStructUpdate", insertStructRows, BENCHMARK_IMPORT_OPS, BENCHMARK_TABLE_ROWS},
+            {"rsExportToSink", exportRows, BENCHMARK_EXPORT_OPS, BENCHMARK_TABLE_ROWS},
+    };
+
+    printf("\n[%s]\n", dbName);
+    bool isSuccess = true;
+    for (uint32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        isSuccess &= runBenchmark(db, &benchmarks[i]);
+    }
+    sqliteDbClose(db);
+    return isSuccess;
+}
+
+int main(int argc, char *argv[]) {
+    printf("SQLite %s\n", sqlite3_libversion());
+    bool isSuccess = runBenchmarks(BENCHMARK_MEMORY_DB);
+    isSuccess &= runBenchmarks(argc > 1 ? argv[1] : BENCHMARK_DISK_DB);
+    if (argc <= 1) {
+        remove(BENCHMARK_DISK_DB);
+    }
+    free(importCsv);
+    return isSuccess ? 0 : 1;
+}
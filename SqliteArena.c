@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+#include "SqliteArena.h"
+
+#define ALIGN_SIZE(size) (((size) + SQLITE_ARENA_ALIGNMENT - 1) & ~(SQLITE_ARENA_ALIGNMENT - 1))
+
+static SqliteArenaBlock *newArenaBlock(size_t capacity);
+static bool isLastAllocation(SqliteArena *arena, void *ptr, size_t oldSize);
+
+
+SqliteArena *newSqliteArena(size_t blockSize) {
+    SqliteArena *arena = calloc(1, sizeof(struct SqliteArena));
+    if (arena == NULL) return NULL;
+    arena->blockSize = blockSize > 0 ? blockSize : SQLITE_ARENA_DEFAULT_BLOCK_SIZE;
+    return arena;
+}
+
+void *sqliteArenaAlloc(SqliteArena *arena, size_t size) {
+    if (arena == NULL) return malloc(size);
+    size_t alignedSize = ALIGN_SIZE(size > 0 ? size : 1);
+
+    SqliteArenaBlock *block = arena->current;
+    while (block != NULL && block->capacity - block->size < alignedSize) {
+        block = block->next;    // blocks after current one are empty after reset
+    }
+
+    if (block == NULL) {
+        block = newArenaBlock(alignedSize > arena->blockSize ? alignedSize : arena->blockSize);
+        if (block == NULL) return NULL;
+        if (arena->current != NULL) {   // insert after current, so free blocks are still reachable
+            block->next = arena->current->next;
+            arena->current->next = block;
+        } else {
+            arena->blocks = block;
+        }
+    }
+
+    void *ptr = block->data + block->size;
+    block->size += alignedSize;
+    arena->current = block;
+    arena->lastAllocation = ptr;
+    arena->allocatedBytes += alignedSize;
+    return ptr;
+}
+
+void *sqliteArenaCalloc(SqliteArena *arena, size_t size) {
+    if (arena == NULL) return calloc(1, size);
+    void *ptr = sqliteArenaAlloc(arena, size);
+    if (ptr != NULL) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void *sqliteArenaRealloc(SqliteArena *arena, void *ptr, size_t oldSize, size_t newSize) {
+    if (arena == NULL) return realloc(ptr, newSize);
+    if (ptr == NULL) return sqliteArenaAlloc(arena, newSize);
+    if (newSize <= oldSize) return ptr;
+
+    if (isLastAllocation(arena, ptr, oldSize)) {
+        size_t growSize = ALIGN_SIZE(newSize) - ALIGN_SIZE(oldSize);
+        SqliteArenaBlock *block = arena->current;
+        if (block->capacity - block->size >= growSize) {
+            block->size += growSize;
+            arena->allocatedBytes += growSize;
+            return ptr;
+        }
+    }
+
+    void *newPtr = sqliteArenaAlloc(arena, newSize);
+    if (newPtr != NULL) {
+        memcpy(newPtr, ptr, oldSize);
+    }
+    return newPtr;
+}
+
+void sqliteArenaFree(SqliteArena *arena, void *ptr) {
+    if (arena == NULL) {
+        free(ptr);
+    }
+}
+
+char *sqliteArenaStrdup(SqliteArena *arena, const char *str) {
+    size_t size = strlen(str) + 1;
+    char *copy = sqliteArenaAlloc(arena, size);
+    if (copy != NULL) {
+        memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+void sqliteArenaReset(SqliteArena *arena) {
+    if (arena == NULL) return;
+    for (SqliteArenaBlock *block = arena->blocks; block != NULL; block = block->next) {
+        block->size = 0;
+    }
+    arena->current = arena->blocks;
+    arena->lastAllocation = NULL;
+    arena->allocatedBytes = 0;
+}
+
+void deleteSqliteArena(SqliteArena *arena) {
+    if (arena != NULL) {
+        SqliteArenaBlock *block = arena->blocks;
+        while (block != NULL) {
+            SqliteArenaBlock *next = block->next;
+            free(block);
+            block = next;
+        }
+        free(arena);
+    }
+}
+
+static SqliteArenaBlock *newArenaBlock(size_t capacity) {
+    SqliteArenaBlock *block = malloc(sizeof(struct SqliteArenaBlock) + capacity);
+    if (block == NULL) return NULL;
+    block->next = NULL;
+    block->size = 0;
+    block->capacity = capacity;
+    return block;
+}
+
+static bool isLastAllocation(SqliteArena *arena, void *ptr, size_t oldSize) {
+    SqliteArenaBlock *block = arena->current;
+    return ptr == arena->lastAllocation && block != NULL && (char *) ptr + ALIGN_SIZE(oldSize) == block->data + block->size;
+}
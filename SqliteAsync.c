@@ -0,0 +1,423 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include "SqliteWrapper.h"
+
+#define ASYNC_PARAM_NAMES_CAPACITY 8
+#define ASYNC_NUMBER_BUFFER_SIZE 32
+
+struct AsyncRequest {
+    bool isQuery;
+    const char *sql;
+    uint32_t paramCount;
+    const char **paramNames;
+    DbValue *paramValues;
+    AsyncCompletion completion;
+    AsyncResult result;
+    struct AsyncRequest *next;
+};
+
+static AsyncRequest *newAsyncRequest(const char *sql, str_DbValueMap *queryParams, bool isQuery);
+static uint64_t submitRequest(SqliteAsync *async, AsyncRequest *request, AsyncCompletion completion, void *userData);
+static void *runAsyncWorker(void *arg);
+static AsyncRequest *executeUpdateGroup(SqliteAsync *async, AsyncRequest *request);
+static bool isGroupedUpdate(const AsyncRequest *request);
+static void executeRequest(SqliteAsync *async, AsyncRequest *request);
+static ResultSet *materializeResultSet(ResultSet *rows, int *rc);
+static void completeRequest(SqliteAsync *async, AsyncRequest *request);
+static AsyncRequest *takeResult(SqliteAsync *async, uint64_t id);
+
+
+SqliteAsync *newSqliteAsync(const char *dbName, const AsyncOptions *options) {
+    SqliteAsync *async = calloc(1, sizeof(struct SqliteAsync));
+    if (async == NULL) return NULL;
+
+    SqliteOpenOptions openOptions = options != NULL && options->openOptions != NULL ? *options->openOptions : (SqliteOpenOptions) {0};
+    openOptions.openFlags |= SQLITE_OPEN_NOMUTEX;
+    async->db = sqliteDbInitWithOptions(dbName, &openOptions);
+    if (async->db == NULL) {
+        free(async);
+        return NULL;
+    }
+    async->nextId = 1;
+    async->notify = options != NULL ? options->notify : NULL;
+    async->notifyContext = options != NULL ? options->notifyContext : NULL;
+    pthread_mutex_init(&async->mutex, NULL);
+    pthread_cond_init(&async->requestAdded, NULL);
+    pthread_cond_init(&async->resultAdded, NULL);
+
+    if (pthread_create(&async->worker, NULL, runAsyncWorker, async) != 0) {
+        pthread_cond_destroy(&async->resultAdded);
+        pthread_cond_destroy(&async->requestAdded);
+        pthread_mutex_destroy(&async->mutex);
+        sqliteDbClose(async->db);
+        free(async);
+        return NULL;
+    }
+    return async;
+}
+
+uint64_t sqliteAsyncQuery(SqliteAsync *async, const char *sql, str_DbValueMap *queryParams, AsyncCompletion completion, void *userData) {
+    if (async == NULL || sql == NULL) return 0;
+    return submitRequest(async, newAsyncRequest(sql, queryParams, true), completion, userData);
+}
+
+uint64_t sqliteAsyncUpdate(SqliteAsync *async, const char *sql, str_DbValueMap *queryParams, AsyncCompletion completion, void *userData) {
+    if (async == NULL || sql == NULL) return 0;
+    return submitRequest(async, newAsyncRequest(sql, queryParams, false), completion, userData);
+}
+
+bool sqliteAsyncPoll(SqliteAsync *async, AsyncResult *result) {
+    return sqliteAsyncWait(async, 0, result, 0);
+}
+
+bool sqliteAsyncWait(SqliteAsync *async, uint64_t id, AsyncResult *result, uint32_t timeoutMs) {
+    if (async == NULL || result == NULL) return false;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);   // default condition variable clock
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long) (timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&async->mutex);
+    AsyncRequest *request;
+    while ((request = takeResult(async, id)) == NULL && timeoutMs > 0) {
+        if (pthread_cond_timedwait(&async->resultAdded, &async->mutex, &deadline) == ETIMEDOUT) {
+            request = takeResult(async, id);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&async->mutex);
+
+    if (request == NULL) return false;
+    *result = request->result;
+    free(request);
+    return true;
+}
+
+void deleteSqliteAsync(SqliteAsync *async) {
+    if (async == NULL) return;
+    pthread_mutex_lock(&async->mutex);
+    async->isStopping = true;
+    pthread_cond_signal(&async->requestAdded);
+    pthread_mutex_unlock(&async->mutex);
+    pthread_join(async->worker, NULL);
+
+    AsyncRequest *request = async->resultHead;
+    while (request != NULL) {
+        AsyncRequest *next = request->next;
+        resultSetDelete(request->result.resultSet);
+        free(request);
+        request = next;
+    }
+    pthread_cond_destroy(&async->resultAdded);
+    pthread_cond_destroy(&async->requestAdded);
+    pthread_mutex_destroy(&async->mutex);
+    sqliteDbClose(async->db);
+    free(async);
+}
+
+// Sql, parameter names and values are copied to single block after request.
+// Map can't be iterated, so names are taken from sql
+static AsyncRequest *newAsyncRequest(const char *sql, str_DbValueMap *queryParams, bool isQuery) {
+    const char *names[SQLITE_ASYNC_MAX_PARAMS];
+    DbValue values[SQLITE_ASYNC_MAX_PARAMS];
+    uint32_t paramCount = 0;
+    size_t sqlSize = strlen(sql) + 1;
+    size_t payloadSize = sqlSize;
+
+    Vector sqlParamNames = NULL;
+    if (queryParams != NULL && str_DbValueMapSize(queryParams) > 0) {
+        sqlParamNames = getVectorInstance(ASYNC_PARAM_NAMES_CAPACITY);
+        if (sqlParamNames == NULL) return NULL;
+        deleteQueryString(nativeQueryString(sql, sqlParamNames));
+    }
+
+    bool isValid = true;
+    for (uint32_t i = 0; i < getVectorSize(sqlParamNames) && isValid; i++) {
+        const char *name = vectorGet(sqlParamNames, i);
+        if (!str_DbValueMapContains(queryParams, (char *) name)) continue;   // bound as NULL
+        isValid = paramCount < SQLITE_ASYNC_MAX_PARAMS;
+        if (!isValid) break;
+
+        DbValue value = str_DbValueMapGet(queryParams, (char *) name);
+        payloadSize += strlen(name) + 1;
+        if (value.type == DB_VALUE_TEXT && DB_VALUE_AS_STR(value) != NULL) {
+            payloadSize += strlen(DB_VALUE_AS_STR(value)) + 1;
+        } else if (value.type == DB_VALUE_BLOB && DB_VALUE_AS_BLOB(value) != NULL) {
+            payloadSize += value.length;
+        }
+        names[paramCount] = name;
+        values[paramCount] = value;
+        paramCount++;
+    }
+
+    AsyncRequest *request = isValid ? malloc(sizeof(struct AsyncRequest) + (sizeof(DbValue) + sizeof(char *)) * paramCount + payloadSize) : NULL;
+    if (request != NULL) {
+        *request = (AsyncRequest) {.isQuery = isQuery, .paramCount = paramCount};
+        request->paramValues = (DbValue *) (request + 1);
+        request->paramNames = (const char **) (request->paramValues + paramCount);
+        char *payload = (char *) (request->paramNames + paramCount);
+        request->sql = memcpy(payload, sql, sqlSize);
+        payload += sqlSize;
+
+        for (uint32_t i = 0; i < paramCount; i++) {
+            size_t nameSize = strlen(names[i]) + 1;
+            request->paramNames[i] = memcpy(payload, names[i], nameSize);
+            payload += nameSize;
+
+            DbValue value = values[i];
+            if (value.type == DB_VALUE_TEXT && DB_VALUE_AS_STR(value) != NULL) {
+                size_t valueSize = strlen(DB_VALUE_AS_STR(value)) + 1;
+                value.as.strValue = memcpy(payload, DB_VALUE_AS_STR(value), valueSize);
+                payload += valueSize;
+            } else if (value.type == DB_VALUE_BLOB && DB_VALUE_AS_BLOB(value) != NULL) {
+                value.as.blobValue = memcpy(payload, DB_VALUE_AS_BLOB(value), value.length);
+                payload += value.length;
+            }
+            request->paramValues[i] = value;
+        }
+    }
+
+    for (uint32_t i = 0; i < getVectorSize(sqlParamNames); i++) {
+        free(vectorGet(sqlParamNames, i));
+    }
+    if (sqlParamNames != NULL) {
+        vectorDelete(sqlParamNames);
+    }
+    return request;
+}
+
+static uint64_t submitRequest(SqliteAsync *async, AsyncRequest *request, AsyncCompletion completion, void *userData) {
+    if (request == NULL) return 0;
+    request->completion = completion;
+    request->result.userData = userData;
+
+    pthread_mutex_lock(&async->mutex);
+    uint64_t id = async->isStopping ? 0 : async->nextId++;
+    if (id != 0) {
+        request->result.id = id;
+        if (async->requestTail != NULL) {
+            async->requestTail->next = request;
+        } else {
+            async->requestHead = request;
+        }
+        async->requestTail = request;
+        pthread_cond_signal(&async->requestAdded);
+    }
+    pthread_mutex_unlock(&async->mutex);
+
+    if (id == 0) {
+        free(request);
+    }
+    return id;
+}
+
+// All queued requests are taken at once, so lock is held once per burst
+static void *runAsyncWorker(void *arg) {
+    SqliteAsync *async = (SqliteAsync *) arg;
+    for (;;) {
+        pthread_mutex_lock(&async->mutex);
+        while (async->requestHead == NULL && !async->isStopping) {
+            pthread_cond_wait(&async->requestAdded, &async->mutex);
+        }
+        AsyncRequest *request = async->requestHead;
+        async->requestHead = NULL;
+        async->requestTail = NULL;
+        pthread_mutex_unlock(&async->mutex);
+        if (request == NULL) break;     // stopped and drained
+
+        while (request != NULL) {
+            AsyncRequest *next = executeUpdateGroup(async, request);
+            if (next == request) {
+                next = request->next;
+                request->next = NULL;
+                executeRequest(async, request);
+                completeRequest(async, request);
+            }
+            request = next;
+        }
+    }
+    return NULL;
+}
+
+// Consecutive updates of the burst are committed by single transaction, so fsync is done once per group.
+// Each update has own savepoint, failed one is rolled back alone. Results are completed after commit.
+// Returns next not executed request, same request when there is nothing to group
+static AsyncRequest *executeUpdateGroup(SqliteAsync *async, AsyncRequest *request) {
+    AsyncRequest *end = request;
+    while (end != NULL && isGroupedUpdate(end)) {
+        end = end->next;
+    }
+    if (end == request || end == request->next || sqlite3_get_autocommit(async->db) == 0) return request;
+
+    int rc = sqliteBeginTransaction(async->db, TRANSACTION_IMMEDIATE);
+    for (AsyncRequest *update = request; update != end && rc == SQLITE_OK; update = update->next) {
+        rc = sqliteBeginTransaction(async->db, TRANSACTION_IMMEDIATE);
+        if (rc != SQLITE_OK) break;
+        executeRequest(async, update);
+        rc = update->result.rc == SQLITE_OK ? sqliteCommitTransaction(async->db) : sqliteRollbackTransaction(async->db);
+        if (sqlite3_get_autocommit(async->db) != 0) {     // sqlite has rolled back whole transaction on error
+            rc = update->result.rc != SQLITE_OK ? update->result.rc : SQLITE_ABORT;
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqliteCommitTransaction(async->db);
+    }
+    if (rc != SQLITE_OK && sqlite3_get_autocommit(async->db) == 0) {
+        executeUpdate(async->db, "ROLLBACK", NULL);     // wrapper transaction state is reset on next begin
+    }
+
+    while (request != end) {
+        AsyncRequest *next = request->next;
+        request->next = NULL;
+        if (rc != SQLITE_OK && request->result.rc == SQLITE_OK) {   // rolled back or not executed
+            request->result.rc = rc;
+            request->result.changes = 0;
+        }
+        completeRequest(async, request);
+        request = next;
+    }
+    return end;
+}
+
+// Transaction control and statements that can't run inside transaction are executed alone
+static bool isGroupedUpdate(const AsyncRequest *request) {
+    static const char *const keywords[] = {"INSERT", "REPLACE", "UPDATE", "DELETE"};
+    if (request->isQuery) return false;
+    const char *sql = request->sql;
+    while (isspace((unsigned char) *sql)) {
+        sql++;
+    }
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        size_t length = strlen(keywords[i]);
+        if (sqlite3_strnicmp(sql, keywords[i], (int) length) == 0 && !isalnum((unsigned char) sql[length]) && sql[length] != '_') {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void executeRequest(SqliteAsync *async, AsyncRequest *request) {
+    str_DbValueMap *queryParams = NEW_SQL_PARAM_MAP(SQLITE_ASYNC_MAX_PARAMS);
+    for (uint32_t i = 0; i < request->paramCount; i++) {
+        str_DbValueMapAdd(queryParams, (char *) request->paramNames[i], request->paramValues[i]);
+    }
+
+    AsyncResult *result = &request->result;
+    if (request->isQuery) {
+        ResultSet *rows = executeQuery(async->db, request->sql, queryParams);
+        if (rows == NULL) {
+            result->rc = sqlite3_errcode(async->db);
+            result->rc = result->rc != SQLITE_OK ? result->rc : SQLITE_ERROR;
+            return;
+        }
+        result->resultSet = materializeResultSet(rows, &result->rc);
+        resultSetDelete(rows);
+    } else {
+        result->rc = executeUpdate(async->db, request->sql, queryParams);
+        result->changes = sqlite3_changes(async->db);
+        result->lastInsertRowId = sqlite3_last_insert_rowid(async->db);
+    }
+}
+
+// Rows are copied with types and sizes to callback result set, which doesn't depend on worker connection.
+// Doubles are formatted with round trip precision, blobs are copied as is
+static ResultSet *materializeResultSet(ResultSet *rows, int *rc) {
+    ResultSet *resultSet = newSqliteResultSet(NULL, NULL);
+    sqlite3_stmt *stmt = rows->stmt;
+    int columnCount = sqlite3_column_count(stmt);
+    size_t columnSize = sizeof(char *) * 2 + sizeof(uint32_t) + sizeof(DbValueType) + ASYNC_NUMBER_BUFFER_SIZE;
+    char **columns = columnCount > 0 ? malloc(columnSize * columnCount) : NULL;   // names, row values, lengths, types, numbers
+    if (resultSet == NULL || (columnCount > 0 && columns == NULL)) {
+        free(columns);
+        resultSetDelete(resultSet);
+        *rc = SQLITE_NOMEM;
+        return NULL;
+    }
+
+    char **names = columns;
+    char **values = columns + columnCount;
+    uint32_t *lengths = (uint32_t *) (values + columnCount);
+    DbValueType *types = (DbValueType *) (lengths + columnCount);
+    char *numbers = (char *) (types + columnCount);
+    for (int i = 0; i < columnCount; i++) {
+        names[i] = (char *) sqlite3_column_name(stmt, i);
+    }
+    *rc = SQLITE_OK;
+    while (nextResultSet(rows)) {
+        for (int i = 0; i < columnCount; i++) {
+            types[i] = rsGetColumnTypeByIndex(rows, i);
+            if (types[i] == DB_VALUE_REAL) {
+                values[i] = numbers + i * ASYNC_NUMBER_BUFFER_SIZE;
+                sqlite3_snprintf(ASYNC_NUMBER_BUFFER_SIZE, values[i], "%!.17g", sqlite3_column_double(stmt, i));
+                lengths[i] = (uint32_t) strlen(values[i]);
+                continue;
+            }
+            values[i] = (char *) sqlite3_column_text(stmt, i);
+            lengths[i] = (uint32_t) sqlite3_column_bytes(stmt, i);
+        }
+        if (columnCount > 0 && !resultSetAppendTypedRow(resultSet, columnCount, values, lengths, types, names)) {
+            *rc = SQLITE_NOMEM;
+            break;
+        }
+    }
+    free(columns);
+
+    if (*rc == SQLITE_OK && rows->stepResult != SQLITE_DONE) {
+        *rc = rows->stepResult;
+    }
+    if (*rc != SQLITE_OK) {
+        resultSetDelete(resultSet);
+        return NULL;
+    }
+    return resultSet;
+}
+
+static void completeRequest(SqliteAsync *async, AsyncRequest *request) {
+    if (request->completion != NULL) {
+        request->completion(request->result.userData, &request->result);
+        free(request);
+        return;
+    }
+
+    pthread_mutex_lock(&async->mutex);
+    if (async->resultTail != NULL) {
+        async->resultTail->next = request;
+    } else {
+        async->resultHead = request;
+    }
+    async->resultTail = request;
+    pthread_cond_broadcast(&async->resultAdded);
+    pthread_mutex_unlock(&async->mutex);
+
+    if (async->notify != NULL) {
+        async->notify(async->notifyContext);
+    }
+}
+
+// Called under mutex
+static AsyncRequest *takeResult(SqliteAsync *async, uint64_t id) {
+    AsyncRequest *prev = NULL;
+    for (AsyncRequest *request = async->resultHead; request != NULL; prev = request, request = request->next) {
+        if (id != 0 && request->result.id != id) continue;
+        if (prev != NULL) {
+            prev->next = request->next;
+        } else {
+            async->resultHead = request->next;
+        }
+        if (async->resultTail == request) {
+            async->resultTail = prev;
+        }
+        request->next = NULL;
+        return request;
+    }
+    return NULL;
+}
@@ -0,0 +1,198 @@
+#include "SqliteWrapper.h"
+#include "SqliteClock.h"
+
+typedef struct BatchRowArray {
+    str_DbValueMap **rows;
+    uint32_t rowCount;
+} BatchRowArray;
+
+typedef struct BatchStructArray {
+    const char *rows;
+    uint32_t rowCount;
+    const RowMapping *mapping;
+    StructBinding binding;      // resolved on first row
+    bool isBindingResolved;
+} BatchStructArray;
+
+typedef struct BatchMapSource {
+    BatchRowSupplier nextRow;
+    void *context;
+} BatchMapSource;
+
+// Returns next row or NULL when there are no more rows
+typedef const void *(*BatchNextRow)(void *source, uint64_t rowIndex);
+typedef int (*BatchBindRow)(SqliteStatement *statement, void *source, const void *row);
+
+static int runBatch(sqlite3 *db, const char *sql, BatchNextRow nextRow, BatchBindRow bindRow, void *source, const BatchOptions *options, BatchStats *stats);
+static str_DbValueMap *nextArrayRow(void *context, uint64_t rowIndex);
+static const void *nextMapRow(void *source, uint64_t rowIndex);
+static int bindMapRow(SqliteStatement *statement, void *source, const void *row);
+static const void *nextStructRow(void *source, uint64_t rowIndex);
+static int bindStructRow(SqliteStatement *statement, void *source, const void *row);
+static int executeBatchRow(SqliteStatement *statement, BatchBindRow bindRow, void *source, const void *row);
+static bool isBatchComplete(const BatchOptions *options, uint32_t batchRows, uint64_t batchStartMicros);
+static bool isBatchIntervalElapsed(const BatchOptions *options, uint64_t batchStartMicros);
+static int commitBatch(sqlite3 *db, bool isOwnTransaction, uint32_t batchRows, uint64_t batchStartMicros, BatchStats *stats);
+
+
+int executeBatchUpdate(sqlite3 *db, const char *sql, str_DbValueMap **rows, uint32_t rowCount, const BatchOptions *options, BatchStats *stats) {
+    BatchRowArray rowArray = {.rows = rows, .rowCount = rowCount};
+    return executeBatchUpdateFrom(db, sql, nextArrayRow, &rowArray, options, stats);
+}
+
+int executeBatchUpdateFrom(sqlite3 *db, const char *sql, BatchRowSupplier nextRow, void *context, const BatchOptions *options, BatchStats *stats) {
+    if (nextRow == NULL) {
+        if (stats != NULL) {
+            *stats = (BatchStats) {0};
+        }
+        return SQLITE_MISUSE;
+    }
+    BatchMapSource source = {.nextRow = nextRow, .context = context};
+    return runBatch(db, sql, nextMapRow, bindMapRow, &source, options, stats);
+}
+
+int executeBatchStructUpdate(sqlite3 *db, const char *sql, const RowMapping *mapping, const void *rows, uint32_t rowCount, const BatchOptions *options, BatchStats *stats) {
+    if (mapping == NULL || (rows == NULL && rowCount > 0)) {
+        if (stats != NULL) {
+            *stats = (BatchStats) {0};
+        }
+        return SQLITE_MISUSE;
+    }
+    BatchStructArray source = {.rows = rows, .rowCount = rowCount, .mapping = mapping};
+    return runBatch(db, sql, nextStructRow, bindStructRow, &source, options, stats);
+}
+
+static int runBatch(sqlite3 *db, const char *sql, BatchNextRow nextRow, BatchBindRow bindRow, void *source, const BatchOptions *options, BatchStats *stats) {
+    BatchOptions batchOptions = options != NULL ? *options : (BatchOptions) {.commitRows = SQLITE_BATCH_DEFAULT_COMMIT_ROWS};
+    BatchStats batchStats = {0};
+    if (stats != NULL) {
+        *stats = batchStats;
+    }
+
+    SqliteStatement *statement = sqliteAcquireStatement(db, sql);
+    if (statement == NULL) {
+        int rc = sqlite3_errcode(db);
+        return rc != SQLITE_OK ? rc : SQLITE_MISUSE;
+    }
+    if (statement->tailSql != NULL) {   // only first statement would be executed for each row
+        sqliteStatementRelease(statement);
+        return SQLITE_MISUSE;
+    }
+
+    bool isOwnTransaction = sqlite3_get_autocommit(db) != 0;   // inside user transaction rows are only executed
+    uint32_t batchRows = 0;
+    uint64_t batchStartMicros = 0;
+    uint64_t rowIndex = 0;
+    int rc = SQLITE_OK;
+
+    while (true) {
+        if (batchRows > 0 && isBatchIntervalElapsed(&batchOptions, batchStartMicros)) {   // supplier can block until next row
+            rc = commitBatch(db, isOwnTransaction, batchRows, batchStartMicros, &batchStats);
+            batchRows = 0;
+            if (rc != SQLITE_OK) break;
+        }
+        const void *row = nextRow(source, rowIndex);
+        if (row == NULL) break;
+        if (row == SQLITE_BATCH_ROW_PENDING) continue;
+
+        if (batchRows == 0) {
+            batchStartMicros = sqliteClockMicros();
+            rc = isOwnTransaction ? executeUpdate(db, "BEGIN", NULL) : SQLITE_OK;
+            if (rc != SQLITE_OK) break;
+        }
+
+        rc = executeBatchRow(statement, bindRow, source, row);
+        if (rc != SQLITE_OK) break;
+        batchRows++;
+        rowIndex++;
+
+        if (isBatchComplete(&batchOptions, batchRows, batchStartMicros)) {
+            rc = commitBatch(db, isOwnTransaction, batchRows, batchStartMicros, &batchStats);
+            batchRows = 0;
+            if (rc != SQLITE_OK) break;
+        }
+    }
+
+    if (rc == SQLITE_OK && batchRows > 0) {
+        rc = commitBatch(db, isOwnTransaction, batchRows, batchStartMicros, &batchStats);
+    } else if (rc != SQLITE_OK && isOwnTransaction && sqlite3_get_autocommit(db) == 0) {
+        executeUpdate(db, "ROLLBACK", NULL);
+    }
+
+    sqliteStatementRelease(statement);
+    if (stats != NULL) {
+        *stats = batchStats;
+    }
+    return rc;
+}
+
+static str_DbValueMap *nextArrayRow(void *context, uint64_t rowIndex) {
+    BatchRowArray *rowArray = (BatchRowArray *) context;
+    return rowIndex < rowArray->rowCount ? rowArray->rows[rowIndex] : NULL;
+}
+
+static const void *nextMapRow(void *source, uint64_t rowIndex) {
+    BatchMapSource *mapSource = (BatchMapSource *) source;
+    return mapSource->nextRow(mapSource->context, rowIndex);
+}
+
+static int bindMapRow(SqliteStatement *statement, void *source, const void *row) {
+    return sqliteStatementBind(statement, (str_DbValueMap *) row, false);
+}
+
+static const void *nextStructRow(void *source, uint64_t rowIndex) {
+    BatchStructArray *structArray = (BatchStructArray *) source;
+    return rowIndex < structArray->rowCount ? structArray->rows + rowIndex * structArray->mapping->structSize : NULL;
+}
+
+// Statement is the same for whole batch, so parameter indexes are resolved once
+static int bindStructRow(SqliteStatement *statement, void *source, const void *row) {
+    BatchStructArray *structArray = (BatchStructArray *) source;
+    if (!structArray->isBindingResolved) {
+        int rc = sqliteStructBindingInit(&structArray->binding, statement, structArray->mapping);
+        if (rc != SQLITE_OK) return rc;
+        structArray->isBindingResolved = true;
+    }
+    return sqliteStatementBindStruct(statement, &structArray->binding, row);
+}
+
+static int executeBatchRow(SqliteStatement *statement, BatchBindRow bindRow, void *source, const void *row) {
+    int rc = bindRow(statement, source, row);    // row is stepped before next one is requested
+    if (rc == SQLITE_OK) {
+        rc = sqliteStatementStep(statement);
+        rc = rc == SQLITE_DONE || rc == SQLITE_ROW ? SQLITE_OK : rc;    // 'RETURNING' clause can produce rows
+    }
+    sqlite3_reset(statement->stmt);
+    return rc;
+}
+
+static bool isBatchComplete(const BatchOptions *options, uint32_t batchRows, uint64_t batchStartMicros) {
+    if (options->commitRows > 0 && batchRows >= options->commitRows) {
+        return true;
+    }
+    return isBatchIntervalElapsed(options, batchStartMicros);
+}
+
+static bool isBatchIntervalElapsed(const BatchOptions *options, uint64_t batchStartMicros) {
+    return options->commitIntervalMs > 0 && (sqliteClockMicros() - batchStartMicros) >= (uint64_t) options->commitIntervalMs * 1000;
+}
+
+static int commitBatch(sqlite3 *db, bool isOwnTransaction, uint32_t batchRows, uint64_t batchStartMicros, BatchStats *stats) {
+    if (isOwnTransaction) {
+        int rc = executeUpdate(db, "COMMIT", NULL);
+        if (rc != SQLITE_OK) {
+            executeUpdate(db, "ROLLBACK", NULL);
+            return rc;
+        }
+    }
+
+    uint64_t batchMicros = sqliteClockMicros() - batchStartMicros;
+    stats->rowsWritten += batchRows;
+    stats->batchCount++;
+    stats->lastBatchMicros = batchMicros;
+    stats->totalBatchMicros += batchMicros;
+    if (batchMicros > stats->maxBatchMicros) {
+        stats->maxBatchMicros = batchMicros;
+    }
+    return SQLITE_OK;
+}
@@ -0,0 +1,107 @@
+#include "SqliteBlob.h"
+
+#define BLOB_MAIN_DB "main"
+
+
+SqliteBlob *sqliteBlobOpen(sqlite3 *db, const char *table, const char *column, int64_t rowId, bool isWritable) {
+    if (db == NULL || table == NULL || column == NULL) return NULL;
+    SqliteBlob *blob = calloc(1, sizeof(struct SqliteBlob));
+    if (blob == NULL) return NULL;
+
+    int rc = sqlite3_blob_open(db, BLOB_MAIN_DB, table, column, rowId, isWritable ? 1 : 0, &blob->handle);
+    if (rc != SQLITE_OK) {
+        sqlite3_blob_close(blob->handle);   // handle is set to NULL or must be closed on error
+        free(blob);
+        return NULL;
+    }
+    blob->db = db;
+    blob->size = (uint32_t) sqlite3_blob_bytes(blob->handle);
+    return blob;
+}
+
+int sqliteBlobReopen(SqliteBlob *blob, int64_t rowId) {
+    if (blob == NULL) return SQLITE_MISUSE;
+    int rc = sqlite3_blob_reopen(blob->handle, rowId);
+    blob->size = rc == SQLITE_OK ? (uint32_t) sqlite3_blob_bytes(blob->handle) : 0;
+    blob->position = 0;
+    return rc;
+}
+
+int sqliteBlobRead(SqliteBlob *blob, void *buffer, uint32_t length, uint32_t *readLength) {
+    *readLength = 0;
+    if (blob == NULL || buffer == NULL) return SQLITE_MISUSE;
+    uint32_t available = blob->size - blob->position;
+    length = length < available ? length : available;
+    if (length == 0) return SQLITE_OK;
+
+    int rc = sqlite3_blob_read(blob->handle, buffer, (int) length, (int) blob->position);
+    if (rc == SQLITE_OK) {
+        blob->position += length;
+        *readLength = length;
+    }
+    return rc;
+}
+
+int sqliteBlobWrite(SqliteBlob *blob, const void *data, uint32_t length) {
+    if (blob == NULL || data == NULL) return SQLITE_MISUSE;
+    if (length == 0) return SQLITE_OK;
+    int rc = sqlite3_blob_write(blob->handle, data, (int) length, (int) blob->position);
+    if (rc == SQLITE_OK) {
+        blob->position += length;
+    }
+    return rc;
+}
+
+int sqliteBlobSeek(SqliteBlob *blob, uint32_t position) {
+    if (blob == NULL || position > blob->size) return SQLITE_RANGE;
+    blob->position = position;
+    return SQLITE_OK;
+}
+
+int sqliteBlobReadTo(SqliteBlob *blob, BlobChunkSink sink, void *context) {
+    if (blob == NULL || sink == NULL) return SQLITE_MISUSE;
+    uint32_t remaining = blob->size - blob->position;
+    uint32_t bufferSize = remaining < SQLITE_BLOB_CHUNK_SIZE ? remaining : SQLITE_BLOB_CHUNK_SIZE;
+    if (bufferSize == 0) return SQLITE_OK;
+    void *buffer = malloc(bufferSize);
+    if (buffer == NULL) return SQLITE_NOMEM;
+
+    int rc;
+    for (;;) {
+        uint32_t readLength;
+        rc = sqliteBlobRead(blob, buffer, bufferSize, &readLength);
+        if (rc != SQLITE_OK || readLength == 0) break;
+        rc = sink(context, buffer, readLength);
+        if (rc != SQLITE_OK) break;
+    }
+    free(buffer);
+    return rc;
+}
+
+int sqliteBlobWriteFrom(SqliteBlob *blob, BlobChunkSource source, void *context) {
+    if (blob == NULL || source == NULL) return SQLITE_MISUSE;
+    uint32_t remaining = blob->size - blob->position;
+    uint32_t bufferSize = remaining < SQLITE_BLOB_CHUNK_SIZE ? remaining : SQLITE_BLOB_CHUNK_SIZE;
+    if (bufferSize == 0) return SQLITE_OK;
+    void *buffer = malloc(bufferSize);
+    if (buffer == NULL) return SQLITE_NOMEM;
+
+    int rc;
+    for (;;) {
+        uint32_t capacity = blob->size - blob->position;
+        uint32_t size = 0;
+        rc = source(context, buffer, capacity < bufferSize ? capacity : bufferSize, &size);
+        if (rc != SQLITE_OK || size == 0) break;
+        rc = sqliteBlobWrite(blob, buffer, size);
+        if (rc != SQLITE_OK || blob->position == blob->size) break;
+    }
+    free(buffer);
+    return rc;
+}
+
+int sqliteBlobClose(SqliteBlob *blob) {
+    if (blob == NULL) return SQLITE_OK;
+    int rc = sqlite3_blob_close(blob->handle);
+    free(blob);
+    return rc;
+}
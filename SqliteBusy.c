@@ -0,0 +1,110 @@
+#include "SqliteConnection.h"
+#include "SqliteClock.h"
+
+static const uint64_t HISTOGRAM_BOUNDS_MICROS[SQLITE_BUSY_HISTOGRAM_BUCKETS - 1] = {100, 1000, 10000, 100000, 1000000, 10000000};
+
+static int busyHandler(void *context, int count);
+static uint64_t backoffDelayMicros(const BusyPolicy *policy, int count);
+static void finishBusyWait(BusyState *busy);
+
+
+int sqliteSetBusyPolicy(sqlite3 *db, const BusyPolicy *policy) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+    BusyState *busy = &connection->busyState;
+    busy->policy = policy != NULL ? *policy : (BusyPolicy) {.timeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS};
+    if (busy->policy.initialDelayMicros == 0) {
+        busy->policy.initialDelayMicros = SQLITE_BUSY_INITIAL_DELAY_MICROS;
+    }
+    if (busy->policy.maxDelayMicros == 0) {
+        busy->policy.maxDelayMicros = SQLITE_BUSY_MAX_DELAY_MICROS;
+    }
+    return sqlite3_busy_handler(db, busyHandler, connection);
+}
+
+BusyStats sqliteGetBusyStats(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return (BusyStats) {0};
+    finishBusyWait(&connection->busyState);   // lock was acquired after last retry
+    return connection->busyState.stats;
+}
+
+void sqliteResetBusyStats(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL) {
+        connection->busyState.stats = (BusyStats) {0};
+        connection->busyState.isWaitPending = false;
+    }
+}
+
+// Called by sqlite with 'count' of previous calls for the same lock, returning 0 gives up with SQLITE_BUSY
+static int busyHandler(void *context, int count) {
+    SqliteConnection *connection = (SqliteConnection *) context;
+    BusyState *busy = &connection->busyState;
+    uint64_t nowMicros = sqliteClockMicros();
+    if (count == 0) {
+        finishBusyWait(busy);
+        busy->stats.waitCount++;
+        busy->waitStartMicros = nowMicros;
+        busy->waitMicros = 0;
+        busy->isWaitPending = true;
+    }
+
+    uint64_t deadlineMicros = busy->waitStartMicros + (uint64_t) busy->policy.timeoutMs * 1000;
+    DeadlineState *queryDeadlines[] = {connection->activeDeadline, &connection->deadlineState};
+    bool isDeadlineTripped = false;
+    for (size_t i = 0; i < sizeof(queryDeadlines) / sizeof(queryDeadlines[0]); i++) {
+        DeadlineState *queryDeadline = queryDeadlines[i];
+        if (queryDeadline != NULL && queryDeadline->isArmed && queryDeadline->deadlineMicros > 0 && queryDeadline->deadlineMicros < deadlineMicros) {
+            deadlineMicros = queryDeadline->deadlineMicros;     // busy result is reported as SQLITE_DEADLINE_EXCEEDED
+        }
+        isDeadlineTripped = isDeadlineTripped || sqliteDeadlineCheck(queryDeadline) != SQLITE_OK;
+    }
+    if (isDeadlineTripped || nowMicros >= deadlineMicros) {
+        busy->stats.timeoutCount++;
+        finishBusyWait(busy);
+        return 0;
+    }
+
+    uint64_t delayMicros = backoffDelayMicros(&busy->policy, count);
+    if (delayMicros > deadlineMicros - nowMicros) {
+        delayMicros = deadlineMicros - nowMicros;
+    }
+    sqlite3_vfs *vfs = sqlite3_vfs_find(NULL);
+    vfs->xSleep(vfs, (int) delayMicros);
+
+    uint64_t sleptMicros = sqliteClockMicros() - nowMicros;
+    busy->stats.retryCount++;
+    busy->stats.totalWaitMicros += sleptMicros;
+    busy->waitMicros += sleptMicros;
+    if (connection->queryStats != NULL) {
+        connection->queryStats->busyWaitMicros += sleptMicros;  // attributed to active statements in queryStatsEnd()
+    }
+    return 1;
+}
+
+// Exponential delay with "equal jitter": at least half of it is kept, so the wait still grows with retries
+static uint64_t backoffDelayMicros(const BusyPolicy *policy, int count) {
+    uint64_t delayMicros = policy->maxDelayMicros;
+    if (count < 32 && ((uint64_t) policy->initialDelayMicros << count) < delayMicros) {
+        delayMicros = (uint64_t) policy->initialDelayMicros << count;
+    }
+    if (policy->isJitterDisabled || delayMicros < 2) return delayMicros;
+
+    uint32_t random;
+    sqlite3_randomness(sizeof(random), &random);
+    return delayMicros / 2 + random % (delayMicros / 2 + 1);
+}
+
+static void finishBusyWait(BusyState *busy) {
+    if (!busy->isWaitPending) return;
+    busy->isWaitPending = false;
+    if (busy->waitMicros > busy->stats.maxWaitMicros) {
+        busy->stats.maxWaitMicros = busy->waitMicros;
+    }
+    int bucket = 0;
+    while (bucket < SQLITE_BUSY_HISTOGRAM_BUCKETS - 1 && busy->waitMicros >= HISTOGRAM_BOUNDS_MICROS[bucket]) {
+        bucket++;
+    }
+    busy->stats.waitHistogram[bucket]++;
+}
@@ -0,0 +1,30 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <time.h>
+#include "sqlite3.h"
+#include "SqliteClock.h"
+
+#define UNIX_EPOCH_JULIAN_DAY_MILLIS 210866760000000LL
+
+
+uint64_t sqliteClockMicros(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec time;
+    if (clock_gettime(CLOCK_MONOTONIC, &time) == 0) {
+        return (uint64_t) time.tv_sec * 1000000 + (uint64_t) time.tv_nsec / 1000;
+    }
+#endif
+    // fallback to the vfs clock, millisecond resolution only
+    sqlite3_vfs *vfs = sqlite3_vfs_find(NULL);
+    sqlite3_int64 julianDayMillis = 0;
+    if (vfs != NULL && vfs->iVersion >= 2 && vfs->xCurrentTimeInt64 != NULL) {
+        vfs->xCurrentTimeInt64(vfs, &julianDayMillis);
+    }
+    return julianDayMillis > UNIX_EPOCH_JULIAN_DAY_MILLIS ? (uint64_t) (julianDayMillis - UNIX_EPOCH_JULIAN_DAY_MILLIS) * 1000 : 0;
+}
+
+uint64_t sqliteClockMillis(void) {
+    return sqliteClockMicros() / 1000;
+}
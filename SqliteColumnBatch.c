@@ -0,0 +1,218 @@
+#include "SqliteColumnBatch.h"
+
+static bool initBatchColumns(ColumnBatch *batch, sqlite3_stmt *stmt);
+static bool isSameColumns(ColumnBatch *batch, sqlite3_stmt *stmt, uint32_t columnCount);
+static bool initColumnType(ColumnVector *vector, DbValueType type, uint32_t rowCapacity);
+static bool appendColumnValue(ColumnVector *vector, sqlite3_stmt *stmt, int column, uint32_t row, uint32_t rowCapacity);
+static bool appendColumnBytes(ColumnVector *vector, const void *value, uint32_t length, uint32_t row);
+static DbValueType toDbValueType(int columnType);
+static void deleteBatchColumns(ColumnBatch *batch);
+
+
+ColumnBatch *newColumnBatch(uint32_t rowCapacity) {
+    if (rowCapacity < 1) return NULL;
+    ColumnBatch *batch = calloc(1, sizeof(struct ColumnBatch));
+    if (batch == NULL) return NULL;
+    batch->rowCapacity = rowCapacity;
+    return batch;
+}
+
+uint32_t rsFetchColumnBatch(ResultSet *resultSet, ColumnBatch *batch) {
+    if (resultSet == NULL || batch == NULL) return 0;
+    batch->rowCount = 0;
+    if (resultSet->stmt == NULL) return 0;  // only prepared statement result set is supported
+    if (!initBatchColumns(batch, resultSet->stmt)) return 0;
+
+    uint32_t nullBitmapSize = (batch->rowCapacity + 7) / 8;
+    for (uint32_t i = 0; i < batch->columnCount; i++) {
+        memset(batch->columns[i].nullBitmap, 0, nullBitmapSize);
+        batch->columns[i].type = DB_VALUE_NULL;     // each batch takes type from own values, buffers are kept
+    }
+
+    while (batch->rowCount < batch->rowCapacity) {
+        sqlite3_stmt *stmt = resultSet->stmt;
+        if (!resultSet->isRowPending && !nextResultSet(resultSet)) break;   // statement is released at the end
+        resultSet->isRowPending = true;     // stepped row is fetched again by next call if it can't be stored
+
+        for (uint32_t i = 0; i < batch->columnCount; i++) {
+            if (!appendColumnValue(&batch->columns[i], stmt, (int) i, batch->rowCount, batch->rowCapacity)) {
+                resultSet->stepResult = SQLITE_NOMEM;
+                return batch->rowCount;
+            }
+        }
+        resultSet->isRowPending = false;
+        batch->rowCount++;
+    }
+    return batch->rowCount;
+}
+
+int columnBatchGetColumnIndex(ColumnBatch *batch, const char *columnName) {
+    for (uint32_t i = 0; i < batch->columnCount; i++) {
+        if (strcmp(batch->columns[i].name, columnName) == 0) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+void deleteColumnBatch(ColumnBatch *batch) {
+    if (batch != NULL) {
+        deleteBatchColumns(batch);
+        free(batch);
+    }
+}
+
+static bool isSameColumns(ColumnBatch *batch, sqlite3_stmt *stmt, uint32_t columnCount) {
+    if (batch->columns == NULL || batch->columnCount != columnCount) return false;
+    for (uint32_t i = 0; i < columnCount; i++) {
+        if (strcmp(batch->columns[i].name, sqlite3_column_name(stmt, (int) i)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool initBatchColumns(ColumnBatch *batch, sqlite3_stmt *stmt) {
+    uint32_t columnCount = (uint32_t) sqlite3_column_count(stmt);
+    if (isSameColumns(batch, stmt, columnCount)) {  // next batch of same query, reuse buffers
+        return true;
+    }
+
+    deleteBatchColumns(batch);
+    batch->columns = calloc(columnCount, sizeof(struct ColumnVector));
+    if (batch->columns == NULL) return false;
+    batch->columnCount = columnCount;
+
+    for (uint32_t i = 0; i < columnCount; i++) {
+        ColumnVector *vector = &batch->columns[i];
+        vector->name = strdup(sqlite3_column_name(stmt, (int) i));   // statement can be finalized before batch is read
+        vector->type = DB_VALUE_NULL;
+        vector->nullBitmap = calloc((batch->rowCapacity + 7) / 8, sizeof(uint8_t));
+        if (vector->name == NULL || vector->nullBitmap == NULL) {
+            deleteBatchColumns(batch);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Buffers of previous batches are reused, so column type can change between batches without reallocation
+static bool initColumnType(ColumnVector *vector, DbValueType type, uint32_t rowCapacity) {
+    switch (type) {
+        case DB_VALUE_INT:
+            if (vector->intValues == NULL) {
+                vector->intValues = calloc(rowCapacity, sizeof(int64_t));
+            }
+            if (vector->intValues == NULL) return false;
+            break;
+        case DB_VALUE_REAL:
+            if (vector->doubleValues == NULL) {
+                vector->doubleValues = calloc(rowCapacity, sizeof(double));
+            }
+            if (vector->doubleValues == NULL) return false;
+            break;
+        case DB_VALUE_TEXT:
+        case DB_VALUE_BLOB:
+            if (vector->offsets == NULL) {
+                vector->offsets = calloc(rowCapacity + 1, sizeof(uint32_t));
+            }
+            if (vector->bytes == NULL) {
+                vector->bytes = malloc(SQLITE_COLUMN_BATCH_DEFAULT_BYTES);
+                vector->bytesCapacity = vector->bytes != NULL ? SQLITE_COLUMN_BATCH_DEFAULT_BYTES : 0;
+            }
+            if (vector->offsets == NULL || vector->bytes == NULL) return false;
+            break;
+        default:
+            break;
+    }
+    vector->type = type;
+    return true;
+}
+
+static bool appendColumnValue(ColumnVector *vector, sqlite3_stmt *stmt, int column, uint32_t row, uint32_t rowCapacity) {
+    int columnType = sqlite3_column_type(stmt, column);
+    if (vector->type == DB_VALUE_NULL && columnType != SQLITE_NULL) {
+        if (!initColumnType(vector, toDbValueType(columnType), rowCapacity)) {
+            return false;
+        }
+        if (vector->type == DB_VALUE_TEXT || vector->type == DB_VALUE_BLOB) {  // previous rows in this batch can be only NULL
+            memset(vector->offsets, 0, sizeof(uint32_t) * (row + 1));
+        }
+    }
+
+    if (columnType == SQLITE_NULL) {
+        vector->nullBitmap[row >> 3] |= (uint8_t) (1 << (row & 7));
+    }
+
+    switch (vector->type) {
+        case DB_VALUE_INT:
+            vector->intValues[row] = sqlite3_column_int64(stmt, column);
+            return true;
+        case DB_VALUE_REAL:
+            vector->doubleValues[row] = sqlite3_column_double(stmt, column);
+            return true;
+        case DB_VALUE_TEXT: {
+            const unsigned char *value = sqlite3_column_text(stmt, column);
+            return appendColumnBytes(vector, value, (uint32_t) sqlite3_column_bytes(stmt, column), row);
+        }
+        case DB_VALUE_BLOB: {
+            const void *value = sqlite3_column_blob(stmt, column);
+            return appendColumnBytes(vector, value, (uint32_t) sqlite3_column_bytes(stmt, column), row);
+        }
+        default:
+            return true;
+    }
+}
+
+static bool appendColumnBytes(ColumnVector *vector, const void *value, uint32_t length, uint32_t row) {
+    uint32_t offset = row > 0 ? vector->offsets[row] : 0;
+    if (length > UINT32_MAX - offset) return false;
+    uint32_t newSize = offset + length;
+    if (newSize > vector->bytesCapacity) {
+        uint32_t newCapacity = vector->bytesCapacity;
+        while (newCapacity < newSize) {
+            newCapacity = newCapacity <= UINT32_MAX / 2 ? newCapacity * 2 : UINT32_MAX;
+        }
+        uint8_t *bytes = realloc(vector->bytes, newCapacity);
+        if (bytes == NULL) return false;
+        vector->bytes = bytes;
+        vector->bytesCapacity = newCapacity;
+    }
+
+    if (length > 0) {
+        memcpy(vector->bytes + offset, value, length);
+    }
+    vector->offsets[row] = offset;
+    vector->offsets[row + 1] = newSize;
+    return true;
+}
+
+static DbValueType toDbValueType(int columnType) {
+    switch (columnType) {
+        case SQLITE_INTEGER:
+            return DB_VALUE_INT;
+        case SQLITE_FLOAT:
+            return DB_VALUE_REAL;
+        case SQLITE_BLOB:
+            return DB_VALUE_BLOB;
+        case SQLITE_TEXT:
+            return DB_VALUE_TEXT;
+        default:
+            return DB_VALUE_NULL;
+    }
+}
+
+static void deleteBatchColumns(ColumnBatch *batch) {
+    for (uint32_t i = 0; i < batch->columnCount && batch->columns != NULL; i++) {
+        ColumnVector *vector = &batch->columns[i];
+        free((char *) vector->name);
+        free(vector->intValues);
+        free(vector->doubleValues);
+        free(vector->offsets);
+        free(vector->bytes);
+        free(vector->nullBitmap);
+    }
+    free(batch->columns);
+    batch->columns = NULL;
+    batch->columnCount = 0;
+}
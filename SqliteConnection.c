@@ -0,0 +1,110 @@
+#include "SqliteConnection.h"
+#include "SqliteClock.h"
+
+#define REMOVED_DB ((sqlite3 *) &removedDbMarker)     // keeps probe chain of other handles after unregister
+
+// Open addressing table by db handle. Slots are written only under registry mutex, lookups are lock free and compare
+// only handles, so connection of other db is never read while it can be unregistered and freed on another thread
+static sqlite3 *dbs[SQLITE_MAX_CONNECTIONS];
+static SqliteConnection *connections[SQLITE_MAX_CONNECTIONS];
+static const char removedDbMarker;
+
+static uint32_t connectionSlot(sqlite3 *db);
+static void deleteSqliteConnection(SqliteConnection *connection);
+
+
+SqliteConnection *sqliteConnectionRegister(sqlite3 *db) {
+    if (db == NULL) return NULL;
+    SqliteConnection *connection = calloc(1, sizeof(struct SqliteConnection));
+    if (connection == NULL) return NULL;
+    connection->db = db;
+    connection->statementCache = newStatementCache(SQLITE_STATEMENT_CACHE_DEFAULT_CAPACITY);
+    if (connection->statementCache == NULL) {
+        deleteSqliteConnection(connection);
+        return NULL;
+    }
+
+    sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+    sqlite3_mutex_enter(mutex);
+    uint32_t slot = connectionSlot(db);
+    for (uint32_t i = 0; i < SQLITE_MAX_CONNECTIONS; i++, slot = (slot + 1) % SQLITE_MAX_CONNECTIONS) {
+        sqlite3 *slotDb = __atomic_load_n(&dbs[slot], __ATOMIC_RELAXED);
+        if (slotDb == NULL || slotDb == REMOVED_DB) {
+            __atomic_store_n(&connections[slot], connection, __ATOMIC_RELAXED);
+            __atomic_store_n(&dbs[slot], db, __ATOMIC_RELEASE);    // connection is visible before its handle
+            sqlite3_mutex_leave(mutex);
+            return connection;
+        }
+    }
+    sqlite3_mutex_leave(mutex);
+
+    deleteSqliteConnection(connection);   // no free slots
+    return NULL;
+}
+
+SqliteConnection *sqliteConnectionOf(sqlite3 *db) {
+    if (db == NULL) return NULL;
+    uint32_t slot = connectionSlot(db);
+    for (uint32_t i = 0; i < SQLITE_MAX_CONNECTIONS; i++, slot = (slot + 1) % SQLITE_MAX_CONNECTIONS) {
+        sqlite3 *slotDb = __atomic_load_n(&dbs[slot], __ATOMIC_ACQUIRE);
+        if (slotDb == db) return __atomic_load_n(&connections[slot], __ATOMIC_RELAXED);
+        if (slotDb == NULL) return NULL;
+    }
+    return NULL;
+}
+
+void sqliteConnectionUnregister(sqlite3 *db) {
+    if (db == NULL) return;
+    SqliteConnection *connection = NULL;
+    sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+    sqlite3_mutex_enter(mutex);
+    uint32_t slot = connectionSlot(db);
+    for (uint32_t i = 0; i < SQLITE_MAX_CONNECTIONS; i++, slot = (slot + 1) % SQLITE_MAX_CONNECTIONS) {
+        sqlite3 *slotDb = __atomic_load_n(&dbs[slot], __ATOMIC_RELAXED);
+        if (slotDb == db) {
+            connection = __atomic_load_n(&connections[slot], __ATOMIC_RELAXED);
+            __atomic_store_n(&dbs[slot], REMOVED_DB, __ATOMIC_RELEASE);
+            __atomic_store_n(&connections[slot], NULL, __ATOMIC_RELAXED);
+            break;
+        }
+        if (slotDb == NULL) break;
+    }
+    sqlite3_mutex_leave(mutex);
+    deleteSqliteConnection(connection);
+}
+
+SqliteStatement *sqliteAcquireStatement(sqlite3 *db, const char *sql) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    StatementCache *cache = connection != NULL ? connection->statementCache : NULL;
+    QueryStatsRegistry *queryStats = connection != NULL ? connection->queryStats : NULL;
+    SqliteStatement *statement = statementCacheAcquire(cache, sql);
+    if (statement != NULL) {
+        queryStatsBegin(queryStats, statement, false, 0);
+        return statement;
+    }
+
+    bool isStatsEnabled = queryStats != NULL && queryStats->isEnabled;
+    uint64_t prepareStartMicros = isStatsEnabled ? sqliteClockMicros() : 0;
+    statement = newSqliteStatement(db, sql);
+    if (statement == NULL) return NULL;
+    statement->isInUse = true;
+    statementCachePut(cache, statement);
+    queryStatsBegin(queryStats, statement, true, isStatsEnabled ? sqliteClockMicros() - prepareStartMicros : 0);
+    return statement;
+}
+
+static uint32_t connectionSlot(sqlite3 *db) {
+    uint64_t key = (uint64_t) (uintptr_t) db >> 4;    // allocation alignment bits are always zero
+    return (uint32_t) ((key * 0x9E3779B97F4A7C15ull) >> 32) % SQLITE_MAX_CONNECTIONS;
+}
+
+static void deleteSqliteConnection(SqliteConnection *connection) {
+    if (connection != NULL) {
+        sqlite3_busy_handler(connection->db, NULL, NULL);     // handler context is released, db can still be used until close
+        sqlite3_progress_handler(connection->db, 0, NULL, NULL);     // deadline handler context is released too
+        deleteStatementCache(connection->statementCache);
+        deleteQueryStatsRegistry(connection->queryStats);
+        deleteSchemaCache(connection->schemaCache);
+        free(connection);
+    }
+}
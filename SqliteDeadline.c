@@ -0,0 +1,109 @@
+#include "SqliteConnection.h"
+#include "SqliteClock.h"
+
+static void armDeadline(DeadlineState *state, SqliteConnection *connection);
+static int deadlineProgressHandler(void *context);
+
+
+int sqliteSetDeadline(sqlite3 *db, const QueryDeadline *deadline) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+    sqliteDeadlineDisarm(&connection->deadlineState);   // previous deadline is replaced
+    return sqliteDeadlineInit(&connection->deadlineState, db, deadline);
+}
+
+void sqliteClearDeadline(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL) {
+        sqliteDeadlineDisarm(&connection->deadlineState);
+    }
+}
+
+int sqliteDeadlineInit(DeadlineState *state, sqlite3 *db, const QueryDeadline *deadline) {
+    *state = (DeadlineState) {.db = db};
+    if (deadline == NULL) return SQLITE_OK;
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+    if (sqliteIsCancelled(deadline->cancelToken)) return SQLITE_QUERY_CANCELLED;
+
+    state->deadlineMicros = deadline->timeoutMs > 0 ? sqliteClockMicros() + (uint64_t) deadline->timeoutMs * 1000 : 0;
+    state->cancelToken = deadline->cancelToken;
+    armDeadline(state, connection);
+    return SQLITE_OK;
+}
+
+DeadlineState *sqliteDeadlineEnter(DeadlineState *state) {
+    if (state == NULL || !state->isArmed) return NULL;
+    DeadlineState *previous = state->connection->activeDeadline;
+    state->connection->activeDeadline = state;
+    return previous;
+}
+
+void sqliteDeadlineLeave(DeadlineState *state, DeadlineState *previous) {
+    if (state == NULL || !state->isArmed || state->connection->activeDeadline != state) return;     // not entered
+    state->connection->activeDeadline = previous;
+}
+
+void sqliteDeadlineDisarm(DeadlineState *state) {
+    if (state == NULL || !state->isArmed) return;
+    state->isArmed = false;
+    SqliteConnection *connection = state->connection;
+    if (connection->activeDeadline == state) {
+        connection->activeDeadline = NULL;
+    }
+    if (--connection->armedDeadlineCount == 0) {
+        sqlite3_progress_handler(connection->db, 0, NULL, NULL);
+    }
+}
+
+int sqliteDeadlineCheck(DeadlineState *state) {
+    if (state == NULL || !state->isArmed) return SQLITE_OK;
+    if (state->interruptCode == SQLITE_OK) {
+        if (sqliteIsCancelled(state->cancelToken)) {
+            state->interruptCode = SQLITE_QUERY_CANCELLED;
+        } else if (state->deadlineMicros > 0 && sqliteClockMicros() >= state->deadlineMicros) {
+            state->interruptCode = SQLITE_DEADLINE_EXCEEDED;
+        }
+    }
+    return state->interruptCode;
+}
+
+int sqliteDeadlineErrorCode(sqlite3 *db, int rc) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return rc;
+    DeadlineState *active = connection->activeDeadline;
+    if (active != NULL && active->isArmed && active->interruptCode != SQLITE_OK) return active->interruptCode;
+    if (!connection->deadlineState.isArmed || connection->deadlineState.interruptCode == SQLITE_OK) return rc;
+    return connection->deadlineState.interruptCode;
+}
+
+void sqliteCancel(SqliteCancelToken *token) {
+    if (token != NULL) {
+        __atomic_store_n(&token->isCancelled, 1, __ATOMIC_RELEASE);
+    }
+}
+
+bool sqliteIsCancelled(SqliteCancelToken *token) {
+    return token != NULL && __atomic_load_n(&token->isCancelled, __ATOMIC_ACQUIRE) != 0;
+}
+
+void sqliteCancelTokenReset(SqliteCancelToken *token) {
+    if (token != NULL) {
+        __atomic_store_n(&token->isCancelled, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// Handler is installed only while any deadline is armed, so connection without deadline has no per instruction callback
+static void armDeadline(DeadlineState *state, SqliteConnection *connection) {
+    state->connection = connection;
+    state->isArmed = true;
+    if (connection->armedDeadlineCount++ == 0) {
+        sqlite3_progress_handler(connection->db, SQLITE_DEADLINE_PROGRESS_OPS, deadlineProgressHandler, connection);
+    }
+}
+
+// Non zero result interrupts statement with SQLITE_INTERRUPT, statement is reset on release and can be executed again
+static int deadlineProgressHandler(void *context) {
+    SqliteConnection *connection = (SqliteConnection *) context;
+    return sqliteDeadlineCheck(connection->activeDeadline) != SQLITE_OK || sqliteDeadlineCheck(&connection->deadlineState) != SQLITE_OK;
+}
@@ -0,0 +1,321 @@
+#include <math.h>
+#include "SqliteExport.h"
+#include "SqliteQuery.h"
+#include "SqliteClock.h"
+
+#ifdef SQLITE_EXPORT_HAS_FD
+    #include <errno.h>
+    #include <unistd.h>
+#endif
+
+#define EXPORT_NUMBER_BUFFER_SIZE 32
+#define EXPORT_QUOTE '"'
+
+typedef struct Exporter {
+    char *buffer;
+    size_t size;
+    size_t capacity;
+    ExportSink sink;
+    void *context;
+    ExportOptions options;
+    ExportStats stats;
+    int errorCode;
+    QueryString *jsonKeys;      // '{"name":' for first column, ',"name":' for others
+    uint32_t *jsonKeyOffsets;
+} Exporter;
+
+static int exportRows(Exporter *exporter, sqlite3_stmt *stmt, ResultSet *resultSet);
+static bool prepareJsonKeys(Exporter *exporter, sqlite3_stmt *stmt, int columnCount);
+static void exportCsvHeader(Exporter *exporter, sqlite3_stmt *stmt, int columnCount);
+static void exportCsvValue(Exporter *exporter, sqlite3_stmt *stmt, int column);
+static void exportJsonValue(Exporter *exporter, sqlite3_stmt *stmt, int column);
+static void appendCsvText(Exporter *exporter, const char *value, size_t length);
+static void appendJsonText(Exporter *exporter, const char *value, size_t length);
+static void appendHex(Exporter *exporter, const uint8_t *value, size_t length);
+static uint32_t formatInt64(char *buffer, int64_t value);
+static void appendBytes(Exporter *exporter, const char *data, size_t length);
+static void appendChar(Exporter *exporter, char value);
+static void flushExporter(Exporter *exporter);
+
+
+int rsExportToSink(ResultSet *resultSet, ExportSink sink, void *context, const ExportOptions *options, ExportStats *stats) {
+    if (stats != NULL) {
+        *stats = (ExportStats) {0};
+    }
+    if (resultSet == NULL || sink == NULL) return SQLITE_MISUSE;
+    if (resultSet->stmt == NULL) {
+        return resultSet->columnNames != NULL || resultSet->stepResult != SQLITE_DONE ? SQLITE_MISUSE : SQLITE_OK;
+    }
+
+    Exporter exporter = {.sink = sink, .context = context, .options = options != NULL ? *options : (ExportOptions) {0}};
+    exporter.options.delimiter = exporter.options.delimiter != '\0' ? exporter.options.delimiter : ',';
+    exporter.capacity = exporter.options.bufferSize > 0 ? exporter.options.bufferSize : SQLITE_EXPORT_DEFAULT_BUFFER_SIZE;
+    exporter.buffer = malloc(exporter.capacity);
+    if (exporter.buffer == NULL) return SQLITE_NOMEM;
+
+    uint64_t startMicros = sqliteClockMicros();
+    int rc = exportRows(&exporter, resultSet->stmt, resultSet);
+    if (rc == SQLITE_OK) {
+        flushExporter(&exporter);
+        rc = exporter.errorCode;
+    }
+    free(exporter.buffer);
+    deleteQueryString(exporter.jsonKeys);
+    free(exporter.jsonKeyOffsets);
+
+    exporter.stats.elapsedMicros = sqliteClockMicros() - startMicros;
+    if (stats != NULL) {
+        *stats = exporter.stats;
+    }
+    return rc;
+}
+
+#ifdef SQLITE_EXPORT_HAS_FD
+static int writeToFd(void *context, const char *data, size_t size) {
+    int fd = *(int *) context;
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return SQLITE_IOERR;
+        }
+        data += written;
+        size -= (size_t) written;
+    }
+    return SQLITE_OK;
+}
+
+int rsExportToFd(ResultSet *resultSet, int fd, const ExportOptions *options, ExportStats *stats) {
+    if (fd < 0) return SQLITE_MISUSE;
+    return rsExportToSink(resultSet, writeToFd, &fd, options, stats);
+}
+#endif
+
+static int exportRows(Exporter *exporter, sqlite3_stmt *stmt, ResultSet *resultSet) {
+    int columnCount = sqlite3_column_count(stmt);
+    bool isJson = exporter->options.format == EXPORT_JSON_LINES;
+    if (isJson && !prepareJsonKeys(exporter, stmt, columnCount)) return SQLITE_NOMEM;
+    if (!isJson && exporter->options.hasHeader) {
+        exportCsvHeader(exporter, stmt, columnCount);
+    }
+
+    while (exporter->errorCode == SQLITE_OK && nextResultSet(resultSet)) {     // statement is released at the end
+        for (int i = 0; i < columnCount; i++) {
+            if (isJson) {
+                uint32_t keyOffset = exporter->jsonKeyOffsets[i];
+                appendBytes(exporter, exporter->jsonKeys->value + keyOffset, exporter->jsonKeyOffsets[i + 1] - keyOffset);
+                exportJsonValue(exporter, stmt, i);
+            } else {
+                if (i > 0) {
+                    appendChar(exporter, exporter->options.delimiter);
+                }
+                exportCsvValue(exporter, stmt, i);
+            }
+        }
+        if (isJson) {
+            appendChar(exporter, '}');
+        }
+        appendChar(exporter, '\n');
+        exporter->stats.rowsExported++;
+    }
+
+    if (exporter->errorCode != SQLITE_OK) return exporter->errorCode;
+    return resultSet->stepResult == SQLITE_DONE ? SQLITE_OK : resultSet->stepResult;
+}
+
+// Escaped keys are formatted once per export
+static bool prepareJsonKeys(Exporter *exporter, sqlite3_stmt *stmt, int columnCount) {
+    exporter->jsonKeys = newQueryString();
+    exporter->jsonKeyOffsets = malloc(sizeof(uint32_t) * (columnCount + 1));
+    if (exporter->jsonKeys == NULL || exporter->jsonKeyOffsets == NULL) return false;
+
+    QueryString *keys = exporter->jsonKeys;
+    for (int i = 0; i < columnCount; i++) {
+        exporter->jsonKeyOffsets[i] = keys->size;
+        const char *name = sqlite3_column_name(stmt, i);
+        if (name == NULL) return false;
+        queryStringAppend(keys, i == 0 ? "{\"" : ",\"", 2);
+        for (const char *c = name; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\') {
+                queryStringAppendChar(keys, '\\');
+            }
+            queryStringAppendChar(keys, (unsigned char) *c < 0x20 ? ' ' : *c);
+        }
+        queryStringAppend(keys, "\":", 2);
+    }
+    exporter->jsonKeyOffsets[columnCount] = keys->size;
+    return true;
+}
+
+static void exportCsvHeader(Exporter *exporter, sqlite3_stmt *stmt, int columnCount) {
+    for (int i = 0; i < columnCount; i++) {
+        if (i > 0) {
+            appendChar(exporter, exporter->options.delimiter);
+        }
+        const char *name = sqlite3_column_name(stmt, i);
+        appendCsvText(exporter, name, name != NULL ? strlen(name) : 0);
+    }
+    appendChar(exporter, '\n');
+}
+
+static void exportCsvValue(Exporter *exporter, sqlite3_stmt *stmt, int column) {
+    char number[EXPORT_NUMBER_BUFFER_SIZE];
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER:
+            appendBytes(exporter, number, formatInt64(number, sqlite3_column_int64(stmt, column)));
+            break;
+        case SQLITE_FLOAT:
+            sqlite3_snprintf(sizeof(number), number, "%!.17g", sqlite3_column_double(stmt, column));
+            appendBytes(exporter, number, strlen(number));
+            break;
+        case SQLITE_TEXT:
+            appendCsvText(exporter, (const char *) sqlite3_column_text(stmt, column), (size_t) sqlite3_column_bytes(stmt, column));
+            break;
+        case SQLITE_BLOB:
+            appendHex(exporter, sqlite3_column_blob(stmt, column), (size_t) sqlite3_column_bytes(stmt, column));
+            break;
+        default:
+            break;  // NULL is empty field
+    }
+}
+
+static void exportJsonValue(Exporter *exporter, sqlite3_stmt *stmt, int column) {
+    char number[EXPORT_NUMBER_BUFFER_SIZE];
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER:
+            appendBytes(exporter, number, formatInt64(number, sqlite3_column_int64(stmt, column)));
+            break;
+        case SQLITE_FLOAT: {
+            double value = sqlite3_column_double(stmt, column);
+            if (isnan(value) || isinf(value)) {
+                appendBytes(exporter, "null", 4);  // NaN and infinity are not valid JSON numbers
+                break;
+            }
+            sqlite3_snprintf(sizeof(number), number, "%!.17g", value);
+            appendBytes(exporter, number, strlen(number));
+            break;
+        }
+        case SQLITE_TEXT:
+            appendChar(exporter, EXPORT_QUOTE);
+            appendJsonText(exporter, (const char *) sqlite3_column_text(stmt, column), (size_t) sqlite3_column_bytes(stmt, column));
+            appendChar(exporter, EXPORT_QUOTE);
+            break;
+        case SQLITE_BLOB:
+            appendChar(exporter, EXPORT_QUOTE);
+            appendHex(exporter, sqlite3_column_blob(stmt, column), (size_t) sqlite3_column_bytes(stmt, column));
+            appendChar(exporter, EXPORT_QUOTE);
+            break;
+        default:
+            appendBytes(exporter, "null", 4);
+            break;
+    }
+}
+
+// Field is quoted only when it contains delimiter, quote or line break
+static void appendCsvText(Exporter *exporter, const char *value, size_t length) {
+    char delimiter = exporter->options.delimiter;
+    size_t index = 0;
+    while (index < length && value[index] != delimiter && value[index] != EXPORT_QUOTE && value[index] != '\n' && value[index] != '\r') {
+        index++;
+    }
+    if (index == length) {
+        appendBytes(exporter, value, length);
+        return;
+    }
+
+    appendChar(exporter, EXPORT_QUOTE);
+    size_t runStart = 0;
+    for (; index < length; index++) {
+        if (value[index] == EXPORT_QUOTE) {
+            appendBytes(exporter, value + runStart, index + 1 - runStart);
+            runStart = index;   // quote is written twice
+        }
+    }
+    appendBytes(exporter, value + runStart, length - runStart);
+    appendChar(exporter, EXPORT_QUOTE);
+}
+
+static void appendJsonText(Exporter *exporter, const char *value, size_t length) {
+    static const char hexDigits[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char) value[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        appendBytes(exporter, value + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': appendBytes(exporter, "\\\"", 2); break;
+            case '\\': appendBytes(exporter, "\\\\", 2); break;
+            case '\n': appendBytes(exporter, "\\n", 2); break;
+            case '\r': appendBytes(exporter, "\\r", 2); break;
+            case '\t': appendBytes(exporter, "\\t", 2); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0x0F]};
+                appendBytes(exporter, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    appendBytes(exporter, value + runStart, length - runStart);
+}
+
+static void appendHex(Exporter *exporter, const uint8_t *value, size_t length) {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < length; i++) {
+        char hex[2] = {hexDigits[value[i] >> 4], hexDigits[value[i] & 0x0F]};
+        appendBytes(exporter, hex, sizeof(hex));
+    }
+}
+
+// Digits are written from the end of local buffer, then moved to the start
+static uint32_t formatInt64(char *buffer, int64_t value) {
+    char digits[EXPORT_NUMBER_BUFFER_SIZE];
+    uint32_t position = sizeof(digits);
+    uint64_t magnitude = value < 0 ? (uint64_t) 0 - (uint64_t) value : (uint64_t) value;
+    do {
+        digits[--position] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[--position] = '-';
+    }
+    uint32_t length = (uint32_t) sizeof(digits) - position;
+    memcpy(buffer, digits + position, length);
+    return length;
+}
+
+// Values larger than buffer are passed by buffer sized parts
+static void appendBytes(Exporter *exporter, const char *data, size_t length) {
+    while (length > 0 && exporter->errorCode == SQLITE_OK) {
+        if (exporter->size == exporter->capacity) {
+            flushExporter(exporter);
+            continue;
+        }
+        size_t available = exporter->capacity - exporter->size;
+        size_t chunk = length < available ? length : available;
+        memcpy(exporter->buffer + exporter->size, data, chunk);
+        exporter->size += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+static void appendChar(Exporter *exporter, char value) {
+    if (exporter->size == exporter->capacity) {
+        flushExporter(exporter);
+    }
+    if (exporter->errorCode == SQLITE_OK) {
+        exporter->buffer[exporter->size++] = value;
+    }
+}
+
+static void flushExporter(Exporter *exporter) {
+    if (exporter->size == 0 || exporter->errorCode != SQLITE_OK) return;
+    exporter->errorCode = exporter->sink(exporter->context, exporter->buffer, exporter->size);
+    if (exporter->errorCode == SQLITE_OK) {
+        exporter->stats.bytesWritten += exporter->size;     // failed buffer is not counted as written
+    }
+    exporter->stats.flushCount++;
+    exporter->size = 0;
+}
@@ -0,0 +1,698 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "SqliteImport.h"
+#include "SqliteWrapper.h"
+#include "SqliteClock.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define IMPORT_HAS_MMAP
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#ifdef SQLITE_WRAPPER_THREADS
+    #include <pthread.h>
+    #define IMPORT_PIPELINE_BATCHES 3   // one parsed ahead, one inserted, one carrying record tail
+#endif
+
+#define IMPORT_QUOTE '"'
+#define IMPORT_UTF8_BOM "\xEF\xBB\xBF"
+#define IMPORT_UTF8_BOM_LENGTH 3
+#define IMPORT_INITIAL_FIELDS 1024
+#define IMPORT_INITIAL_RECORDS 256
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+typedef struct ImportField {
+    uint32_t offset;
+    uint32_t length;
+    bool isQuoted;
+    bool hasEscapes;            // doubled quotes inside quoted field
+} ImportField;
+
+// Complete records parsed from one chunk, field offsets are relative to base
+typedef struct ImportBatch {
+    const char *base;           // mapped data or own buffer
+    char *buffer;               // stream data, starts with tail of previous batch
+    size_t bufferSize;
+    size_t bufferCapacity;
+    size_t parsedBytes;
+    ImportField *fields;
+    uint32_t fieldCount;
+    uint32_t fieldCapacity;
+    uint32_t *recordEnds;       // index after last field of each record
+    uint32_t recordCount;
+    uint32_t recordCapacity;
+    struct ImportBatch *next;
+} ImportBatch;
+
+typedef struct ImportSource {
+    const char *data;           // mapped file or caller buffer, NULL for stream
+    size_t size;
+    size_t offset;
+    FILE *file;
+    bool isFileEnd;
+    bool isStarted;
+    ImportBatch *carryBatch;    // incomplete stream record is copied to next batch
+    size_t carryOffset;
+    size_t carrySize;
+    char delimiter;
+    int errorCode;
+} ImportSource;
+
+typedef struct ImportContext {
+    sqlite3 *db;
+    const char *table;
+    ImportOptions options;
+    sqlite3_stmt *stmt;
+    int paramCount;
+    bool isHeaderPending;
+    bool isOwnTransaction;
+    uint32_t transactionRows;
+    uint64_t rowIndex;
+    char *unescapeBuffer;
+    size_t unescapeCapacity;
+    ImportStats stats;
+} ImportContext;
+
+typedef enum RecordState {
+    RECORD_COMPLETE,
+    RECORD_INCOMPLETE,
+    RECORD_NO_MEMORY
+} RecordState;
+
+static int runImport(sqlite3 *db, ImportSource *source, const char *table, const ImportOptions *options, ImportStats *stats);
+static int runSingleThreadImport(ImportContext *context, ImportSource *source);
+static bool isSourceDone(const ImportSource *source);
+static bool produceBatch(ImportSource *source, ImportBatch *batch);
+static bool produceMappedBatch(ImportSource *source, ImportBatch *batch);
+static bool produceStreamBatch(ImportSource *source, ImportBatch *batch);
+static bool reserveBatchBuffer(ImportBatch *batch, size_t capacity);
+static RecordState parseRecords(ImportBatch *batch, const char *data, size_t size, bool isEnd, char delimiter);
+static RecordState parseRecord(ImportBatch *batch, const char *data, const char **position, const char *end, bool isEnd, char delimiter);
+static ImportField *addField(ImportBatch *batch);
+static bool addRecord(ImportBatch *batch);
+static const char *findFieldEnd(const char *position, const char *end, char delimiter);
+static int insertBatch(ImportContext *context, const ImportBatch *batch);
+static int prepareInsert(ImportContext *context, const char *base, const ImportField *header, uint32_t columnCount);
+static void appendIdentifier(QueryString *sql, const char *name, uint32_t length);
+static int insertRecord(ImportContext *context, const char *base, const ImportField *fields, uint32_t fieldCount);
+static int bindField(ImportContext *context, int index, const char *base, const ImportField *field);
+static const char *unescapeField(ImportContext *context, const char *value, uint32_t *length);
+static int commitImport(ImportContext *context);
+static void deleteBatchBuffers(ImportBatch *batch);
+
+
+int sqliteImportFile(sqlite3 *db, const char *filePath, const char *table, const ImportOptions *options, ImportStats *stats) {
+    if (filePath == NULL) return SQLITE_MISUSE;
+    ImportReadMode readMode = options != NULL ? options->readMode : IMPORT_READ_AUTO;
+
+#ifdef IMPORT_HAS_MMAP
+    if (readMode != IMPORT_READ_STREAM) {
+        int fd = open(filePath, O_RDONLY);
+        if (fd < 0) return SQLITE_CANTOPEN;
+        struct stat fileStat;
+        bool isRegularFile = fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+        size_t size = isRegularFile ? (size_t) fileStat.st_size : 0;
+        void *data = isRegularFile && size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+
+        if (data != MAP_FAILED) {
+            posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+            int rc = sqliteImportBuffer(db, data, size, table, options, stats);
+            munmap(data, size);
+            return rc;
+        }
+        if (readMode == IMPORT_READ_MMAP) return SQLITE_IOERR;  // pipes and empty files can't be mapped
+    }
+#else
+    if (readMode == IMPORT_READ_MMAP) return SQLITE_IOERR;
+#endif
+
+    FILE *file = fopen(filePath, "rb");
+    if (file == NULL) return SQLITE_CANTOPEN;
+    int rc = sqliteImportStream(db, file, table, options, stats);
+    fclose(file);
+    return rc;
+}
+
+int sqliteImportStream(sqlite3 *db, FILE *file, const char *table, const ImportOptions *options, ImportStats *stats) {
+    if (file == NULL) return SQLITE_MISUSE;
+    ImportSource source = {.file = file};
+    return runImport(db, &source, table, options, stats);
+}
+
+int sqliteImportBuffer(sqlite3 *db, const char *data, size_t size, const char *table, const ImportOptions *options, ImportStats *stats) {
+    if (data == NULL && size > 0) return SQLITE_MISUSE;
+    ImportSource source = {.data = data != NULL ? data : "", .size = size};
+    if (size >= IMPORT_UTF8_BOM_LENGTH && memcmp(data, IMPORT_UTF8_BOM, IMPORT_UTF8_BOM_LENGTH) == 0) {
+        source.offset = IMPORT_UTF8_BOM_LENGTH;
+    }
+    return runImport(db, &source, table, options, stats);
+}
+
+#ifdef SQLITE_WRAPPER_THREADS
+typedef struct ImportPipeline {
+    ImportSource *source;
+    ImportBatch batches[IMPORT_PIPELINE_BATCHES];
+    ImportBatch *freeBatches;
+    ImportBatch *parsedHead;
+    ImportBatch *parsedTail;
+    bool isProducerDone;
+    bool isCancelled;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+} ImportPipeline;
+
+// Parser runs ahead of insert loop by up to two batches
+static void *runProducer(void *arg) {
+    ImportPipeline *pipeline = (ImportPipeline *) arg;
+    for (;;) {
+        pthread_mutex_lock(&pipeline->mutex);
+        while (pipeline->freeBatches == NULL && !pipeline->isCancelled) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+        }
+        ImportBatch *batch = pipeline->isCancelled ? NULL : pipeline->freeBatches;
+        if (batch != NULL) {
+            pipeline->freeBatches = batch->next;
+        }
+        pthread_mutex_unlock(&pipeline->mutex);
+        if (batch == NULL) break;
+
+        bool isProduced = !isSourceDone(pipeline->source) && produceBatch(pipeline->source, batch);
+        pthread_mutex_lock(&pipeline->mutex);
+        batch->next = NULL;
+        if (isProduced) {
+            if (pipeline->parsedTail != NULL) {
+                pipeline->parsedTail->next = batch;
+            } else {
+                pipeline->parsedHead = batch;
+            }
+            pipeline->parsedTail = batch;
+        } else {
+            batch->next = pipeline->freeBatches;
+            pipeline->freeBatches = batch;
+            pipeline->isProducerDone = true;
+        }
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->mutex);
+        if (!isProduced) break;
+    }
+    return NULL;
+}
+
+static int runPipelineImport(ImportContext *context, ImportSource *source) {
+    ImportPipeline pipeline = {.source = source};
+    for (uint32_t i = 0; i < IMPORT_PIPELINE_BATCHES; i++) {
+        pipeline.batches[i].next = pipeline.freeBatches;
+        pipeline.freeBatches = &pipeline.batches[i];
+    }
+    pthread_mutex_init(&pipeline.mutex, NULL);
+    pthread_cond_init(&pipeline.changed, NULL);
+
+    pthread_t producer;
+    int rc = SQLITE_OK;
+    if (pthread_create(&producer, NULL, runProducer, &pipeline) != 0) {
+        rc = runSingleThreadImport(context, source);
+    } else {
+        for (;;) {
+            pthread_mutex_lock(&pipeline.mutex);
+            while (pipeline.parsedHead == NULL && !pipeline.isProducerDone) {
+                pthread_cond_wait(&pipeline.changed, &pipeline.mutex);
+            }
+            ImportBatch *batch = pipeline.parsedHead;
+            if (batch != NULL) {
+                pipeline.parsedHead = batch->next;
+                pipeline.parsedTail = pipeline.parsedHead != NULL ? pipeline.parsedTail : NULL;
+            }
+            pthread_mutex_unlock(&pipeline.mutex);
+            if (batch == NULL) break;
+
+            rc = insertBatch(context, batch);
+            pthread_mutex_lock(&pipeline.mutex);
+            batch->next = pipeline.freeBatches;
+            pipeline.freeBatches = batch;
+            pipeline.isCancelled = rc != SQLITE_OK;
+            pthread_cond_broadcast(&pipeline.changed);
+            pthread_mutex_unlock(&pipeline.mutex);
+            if (rc != SQLITE_OK) break;
+        }
+        pthread_join(producer, NULL);
+        rc = rc == SQLITE_OK ? source->errorCode : rc;
+    }
+
+    for (uint32_t i = 0; i < IMPORT_PIPELINE_BATCHES; i++) {
+        deleteBatchBuffers(&pipeline.batches[i]);
+    }
+    pthread_cond_destroy(&pipeline.changed);
+    pthread_mutex_destroy(&pipeline.mutex);
+    return rc;
+}
+#endif
+
+static int runImport(sqlite3 *db, ImportSource *source, const char *table, const ImportOptions *options, ImportStats *stats) {
+    if (stats != NULL) {
+        *stats = (ImportStats) {0};
+    }
+    if (db == NULL || (table == NULL && (options == NULL || options->insertSql == NULL))) return SQLITE_MISUSE;
+
+    ImportContext context = {.db = db, .table = table, .options = options != NULL ? *options : (ImportOptions) {0}};
+    context.options.delimiter = context.options.delimiter != '\0' ? context.options.delimiter : ',';
+    context.options.commitRows = context.options.commitRows > 0 ? context.options.commitRows : SQLITE_IMPORT_DEFAULT_COMMIT_ROWS;
+    context.isHeaderPending = context.options.hasHeader;
+    context.isOwnTransaction = sqlite3_get_autocommit(db) != 0;   // inside user transaction rows are only inserted
+    source->delimiter = context.options.delimiter;
+    if (context.options.delimiter == IMPORT_QUOTE || context.options.delimiter == '\n' || context.options.delimiter == '\r') {
+        return SQLITE_MISUSE;
+    }
+
+    uint64_t startMicros = sqliteClockMicros();
+#ifdef SQLITE_WRAPPER_THREADS
+    int rc = context.options.useProducerThread ? runPipelineImport(&context, source) : runSingleThreadImport(&context, source);
+#else
+    int rc = runSingleThreadImport(&context, source);   // producer thread option is ignored
+#endif
+
+    if (rc == SQLITE_OK) {
+        rc = commitImport(&context);
+    } else {
+        context.stats.errorRow = context.rowIndex;
+        if (context.isOwnTransaction && sqlite3_get_autocommit(db) == 0) {
+            executeUpdate(db, "ROLLBACK", NULL);
+        }
+    }
+    sqlite3_finalize(context.stmt);
+    free(context.unescapeBuffer);
+
+    context.stats.elapsedMicros = sqliteClockMicros() - startMicros;
+    if (stats != NULL) {
+        *stats = context.stats;
+    }
+    return rc;
+}
+
+static int runSingleThreadImport(ImportContext *context, ImportSource *source) {
+    ImportBatch batch = {0};
+    int rc = SQLITE_OK;
+    while (rc == SQLITE_OK && !isSourceDone(source)) {
+        rc = produceBatch(source, &batch) ? insertBatch(context, &batch) : source->errorCode;
+    }
+    deleteBatchBuffers(&batch);
+    return rc;
+}
+
+static bool isSourceDone(const ImportSource *source) {
+    if (source->data != NULL) {
+        return source->offset >= source->size;
+    }
+    return source->isFileEnd && source->carrySize == 0;
+}
+
+static bool produceBatch(ImportSource *source, ImportBatch *batch) {
+    return source->data != NULL ? produceMappedBatch(source, batch) : produceStreamBatch(source, batch);
+}
+
+// Window is extended when it doesn't contain single complete record
+static bool produceMappedBatch(ImportSource *source, ImportBatch *batch) {
+    size_t available = source->size - source->offset;
+    size_t window = available < SQLITE_IMPORT_CHUNK_SIZE ? available : SQLITE_IMPORT_CHUNK_SIZE;
+    for (;;) {
+        if (window > UINT32_MAX) {
+            source->errorCode = SQLITE_TOOBIG;
+            return false;
+        }
+        bool isEnd = window == available;
+        if (parseRecords(batch, source->data + source->offset, window, isEnd, source->delimiter) == RECORD_NO_MEMORY) {
+            source->errorCode = SQLITE_NOMEM;
+            return false;
+        }
+        if (batch->parsedBytes > 0 || isEnd) break;
+        window = available - window > window ? window * 2 : available;
+    }
+    source->offset += batch->parsedBytes;
+    return true;
+}
+
+static bool produceStreamBatch(ImportSource *source, ImportBatch *batch) {
+    size_t carrySize = source->carrySize;
+    if (source->carryBatch == batch) {
+        memmove(batch->buffer, batch->buffer + source->carryOffset, carrySize);    // reserve below can move buffer
+    }
+    if (!reserveBatchBuffer(batch, carrySize + SQLITE_IMPORT_CHUNK_SIZE)) {
+        source->errorCode = SQLITE_NOMEM;
+        return false;
+    }
+    if (source->carryBatch != NULL && source->carryBatch != batch) {
+        memcpy(batch->buffer, source->carryBatch->buffer + source->carryOffset, carrySize);
+    }
+    batch->bufferSize = carrySize;
+
+    for (;;) {
+        if (!source->isFileEnd) {
+            size_t requested = batch->bufferCapacity - batch->bufferSize;
+            size_t readSize = fread(batch->buffer + batch->bufferSize, 1, requested, source->file);
+            batch->bufferSize += readSize;
+            if (readSize < requested) {
+                if (ferror(source->file)) {
+                    source->errorCode = SQLITE_IOERR;
+                    return false;
+                }
+                source->isFileEnd = true;
+            }
+        }
+
+        if (!source->isStarted && batch->bufferSize >= IMPORT_UTF8_BOM_LENGTH) {
+            source->isStarted = true;
+            if (memcmp(batch->buffer, IMPORT_UTF8_BOM, IMPORT_UTF8_BOM_LENGTH) == 0) {
+                batch->bufferSize -= IMPORT_UTF8_BOM_LENGTH;
+                memmove(batch->buffer, batch->buffer + IMPORT_UTF8_BOM_LENGTH, batch->bufferSize);
+            }
+        }
+
+        if (batch->bufferSize > UINT32_MAX) {
+            source->errorCode = SQLITE_TOOBIG;
+            return false;
+        }
+        if (parseRecords(batch, batch->buffer, batch->bufferSize, source->isFileEnd, source->delimiter) == RECORD_NO_MEMORY) {
+            source->errorCode = SQLITE_NOMEM;
+            return false;
+        }
+        if (batch->parsedBytes > 0 || source->isFileEnd) break;
+        if (!reserveBatchBuffer(batch, batch->bufferCapacity * 2)) {
+            source->errorCode = SQLITE_NOMEM;
+            return false;
+        }
+    }
+
+    source->carryBatch = batch;
+    source->carryOffset = batch->parsedBytes;
+    source->carrySize = batch->bufferSize - batch->parsedBytes;
+    return true;
+}
+
+static bool reserveBatchBuffer(ImportBatch *batch, size_t capacity) {
+    if (batch->bufferCapacity >= capacity) return true;
+    char *buffer = realloc(batch->buffer, capacity);
+    if (buffer == NULL) return false;
+    batch->buffer = buffer;
+    batch->bufferCapacity = capacity;
+    return true;
+}
+
+// Parses all complete records, incomplete tail is left for next chunk unless it is end of data
+static RecordState parseRecords(ImportBatch *batch, const char *data, size_t size, bool isEnd, char delimiter) {
+    batch->base = data;
+    batch->parsedBytes = 0;
+    batch->fieldCount = 0;
+    batch->recordCount = 0;
+
+    const char *position = data;
+    const char *end = data + size;
+    while (position < end) {
+        RecordState state = parseRecord(batch, data, &position, end, isEnd, delimiter);
+        if (state == RECORD_NO_MEMORY) return state;
+        if (state == RECORD_INCOMPLETE) break;
+        batch->parsedBytes = (size_t) (position - data);
+    }
+    return RECORD_COMPLETE;
+}
+
+static RecordState parseRecord(ImportBatch *batch, const char *data, const char **position, const char *end, bool isEnd, char delimiter) {
+    uint32_t firstField = batch->fieldCount;
+    const char *current = *position;
+    for (;;) {
+        ImportField *field = addField(batch);
+        if (field == NULL) return RECORD_NO_MEMORY;
+
+        if (current < end && *current == IMPORT_QUOTE) {
+            const char *start = ++current;
+            field->isQuoted = true;
+            for (;;) {
+                const char *quote = memchr(current, IMPORT_QUOTE, (size_t) (end - current));
+                if (quote == NULL || (quote + 1 == end && !isEnd)) {
+                    if (!isEnd) {
+                        batch->fieldCount = firstField;
+                        return RECORD_INCOMPLETE;
+                    }
+                    quote = quote != NULL ? quote : end;    // unterminated field is taken till the end of data
+                }
+                if (quote + 1 < end && quote[1] == IMPORT_QUOTE) {
+                    field->hasEscapes = true;
+                    current = quote + 2;
+                    continue;
+                }
+                field->offset = (uint32_t) (start - data);
+                field->length = (uint32_t) (quote - start);
+                current = quote < end ? quote + 1 : end;
+                break;
+            }
+            while (current < end && *current != delimiter && *current != '\n' && *current != '\r') {
+                current++;  // text after closing quote is ignored
+            }
+        } else {
+            const char *start = current;
+            current = findFieldEnd(current, end, delimiter);
+            field->offset = (uint32_t) (start - data);
+            field->length = (uint32_t) (current - start);
+        }
+
+        if (current == end) {
+            if (!isEnd) {
+                batch->fieldCount = firstField;
+                return RECORD_INCOMPLETE;
+            }
+            break;  // last record without line break
+        }
+        if (*current == delimiter) {
+            current++;
+            continue;
+        }
+        if (*current == '\r') {
+            if (current + 1 == end && !isEnd) {
+                batch->fieldCount = firstField;
+                return RECORD_INCOMPLETE;
+            }
+            current += current + 1 < end && current[1] == '\n' ? 2 : 1;
+        } else {
+            current++;
+        }
+        break;
+    }
+
+    *position = current;
+    const ImportField *first = &batch->fields[firstField];
+    if (batch->fieldCount - firstField == 1 && !first->isQuoted && first->length == 0) {
+        batch->fieldCount = firstField;     // blank line
+        return RECORD_COMPLETE;
+    }
+    return addRecord(batch) ? RECORD_COMPLETE : RECORD_NO_MEMORY;
+}
+
+static ImportField *addField(ImportBatch *batch) {
+    if (batch->fieldCount == batch->fieldCapacity) {
+        uint32_t capacity = batch->fieldCapacity > 0 ? batch->fieldCapacity * 2 : IMPORT_INITIAL_FIELDS;
+        ImportField *fields = realloc(batch->fields, sizeof(struct ImportField) * capacity);
+        if (fields == NULL) return NULL;
+        batch->fields = fields;
+        batch->fieldCapacity = capacity;
+    }
+    ImportField *field = &batch->fields[batch->fieldCount++];
+    *field = (ImportField) {0};
+    return field;
+}
+
+static bool addRecord(ImportBatch *batch) {
+    if (batch->recordCount == batch->recordCapacity) {
+        uint32_t capacity = batch->recordCapacity > 0 ? batch->recordCapacity * 2 : IMPORT_INITIAL_RECORDS;
+        uint32_t *recordEnds = realloc(batch->recordEnds, sizeof(uint32_t) * capacity);
+        if (recordEnds == NULL) return false;
+        batch->recordEnds = recordEnds;
+        batch->recordCapacity = capacity;
+    }
+    batch->recordEnds[batch->recordCount++] = batch->fieldCount;
+    return true;
+}
+
+// Word at a time search for delimiter or line break, quote inside unquoted field is plain text
+static const char *findFieldEnd(const char *position, const char *end, char delimiter) {
+    const uint64_t delimiters = SWAR_ONES * (uint8_t) delimiter;
+    const uint64_t lineFeeds = SWAR_ONES * (uint8_t) '\n';
+    const uint64_t carriageReturns = SWAR_ONES * (uint8_t) '\r';
+    while (end - position >= (ptrdiff_t) sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, position, sizeof(uint64_t));
+        uint64_t first = word ^ delimiters;
+        uint64_t second = word ^ lineFeeds;
+        uint64_t third = word ^ carriageReturns;
+        uint64_t zeroBytes = ((first - SWAR_ONES) & ~first) | ((second - SWAR_ONES) & ~second) | ((third - SWAR_ONES) & ~third);
+        if ((zeroBytes & SWAR_HIGHS) != 0) break;
+        position += sizeof(uint64_t);
+    }
+    while (position < end && *position != delimiter && *position != '\n' && *position != '\r') {
+        position++;
+    }
+    return position;
+}
+
+static int insertBatch(ImportContext *context, const ImportBatch *batch) {
+    uint32_t firstField = 0;
+    for (uint32_t record = 0; record < batch->recordCount; record++) {
+        const ImportField *fields = &batch->fields[firstField];
+        uint32_t fieldCount = batch->recordEnds[record] - firstField;
+        firstField = batch->recordEnds[record];
+
+        int rc;
+        if (context->isHeaderPending) {
+            context->isHeaderPending = false;
+            rc = prepareInsert(context, batch->base, fields, fieldCount);
+            if (rc != SQLITE_OK) return rc;
+            continue;
+        }
+        if (context->stmt == NULL) {
+            rc = prepareInsert(context, NULL, NULL, fieldCount);
+            if (rc != SQLITE_OK) return rc;
+        }
+        rc = insertRecord(context, batch->base, fields, fieldCount);
+        if (rc != SQLITE_OK) return rc;
+    }
+    context->stats.bytesParsed += batch->parsedBytes;
+    return SQLITE_OK;
+}
+
+// Generated INSERT lists header names as columns, without header values are inserted by table column order
+static int prepareInsert(ImportContext *context, const char *base, const ImportField *header, uint32_t columnCount) {
+    const char *insertSql = context->options.insertSql;
+    QueryString *sql = NULL;
+    if (insertSql == NULL) {
+        if (columnCount > SQLITE_IMPORT_MAX_COLUMNS) return SQLITE_TOOBIG;
+        sql = newQueryString();
+        if (sql == NULL) return SQLITE_NOMEM;
+        queryStringAppend(sql, "INSERT INTO ", 12);
+        appendIdentifier(sql, context->table, (uint32_t) strlen(context->table));
+        if (header != NULL) {
+            queryStringAppend(sql, " (", 2);
+            for (uint32_t i = 0; i < columnCount; i++) {
+                uint32_t length = header[i].length;
+                const char *name = header[i].hasEscapes ? unescapeField(context, base + header[i].offset, &length) : base + header[i].offset;
+                if (name == NULL) {
+                    deleteQueryString(sql);
+                    return SQLITE_NOMEM;
+                }
+                queryStringAppend(sql, i > 0 ? ", " : "", i > 0 ? 2 : 0);
+                appendIdentifier(sql, name, length);
+            }
+            queryStringAppendChar(sql, ')');
+        }
+        queryStringAppend(sql, " VALUES (", 9);
+        for (uint32_t i = 0; i < columnCount; i++) {
+            queryStringAppend(sql, i > 0 ? ", ?" : "?", i > 0 ? 3 : 1);
+        }
+        queryStringAppendChar(sql, ')');
+        insertSql = sql->value;
+    } else if (header != NULL) {
+        return SQLITE_OK;   // header is skipped, statement is prepared for first data record
+    }
+
+    int rc = sqlite3_prepare_v2(context->db, insertSql, -1, &context->stmt, NULL);
+    deleteQueryString(sql);
+    if (rc != SQLITE_OK) return rc;
+    context->paramCount = sqlite3_bind_parameter_count(context->stmt);
+    return SQLITE_OK;
+}
+
+static void appendIdentifier(QueryString *sql, const char *name, uint32_t length) {
+    queryStringAppendChar(sql, '"');
+    for (uint32_t i = 0; i < length; i++) {
+        if (name[i] == '"') {
+            queryStringAppendChar(sql, '"');
+        }
+        queryStringAppendChar(sql, name[i]);
+    }
+    queryStringAppendChar(sql, '"');
+}
+
+static int insertRecord(ImportContext *context, const char *base, const ImportField *fields, uint32_t fieldCount) {
+    context->rowIndex++;
+    if (fieldCount > (uint32_t) context->paramCount) return SQLITE_RANGE;
+    if (context->transactionRows == 0 && context->isOwnTransaction) {
+        int rc = executeUpdate(context->db, "BEGIN", NULL);
+        if (rc != SQLITE_OK) return rc;
+    }
+
+    sqlite3_stmt *stmt = context->stmt;
+    int rc = SQLITE_OK;
+    for (uint32_t i = 0; i < fieldCount && rc == SQLITE_OK; i++) {
+        rc = bindField(context, (int) i + 1, base, &fields[i]);
+    }
+    for (int i = (int) fieldCount + 1; i <= context->paramCount && rc == SQLITE_OK; i++) {
+        rc = sqlite3_bind_null(stmt, i);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_step(stmt);
+        rc = rc == SQLITE_DONE || rc == SQLITE_ROW ? SQLITE_OK : rc;
+    }
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_OK) return rc;
+
+    if (++context->transactionRows >= context->options.commitRows) {
+        return commitImport(context);
+    }
+    return SQLITE_OK;
+}
+
+// Plain fields are bound without copy, data outlives step
+static int bindField(ImportContext *context, int index, const char *base, const ImportField *field) {
+    const char *value = base + field->offset;
+    if (field->length == 0 && !field->isQuoted && context->options.isEmptyNull) {
+        return sqlite3_bind_null(context->stmt, index);
+    }
+    if (field->hasEscapes) {
+        uint32_t length = field->length;
+        value = unescapeField(context, value, &length);
+        if (value == NULL) return SQLITE_NOMEM;
+        return sqlite3_bind_text(context->stmt, index, value, (int) length, SQLITE_TRANSIENT);
+    }
+    return sqlite3_bind_text(context->stmt, index, value, (int) field->length, SQLITE_STATIC);
+}
+
+static const char *unescapeField(ImportContext *context, const char *value, uint32_t *length) {
+    if (context->unescapeCapacity < *length) {
+        char *buffer = realloc(context->unescapeBuffer, *length);
+        if (buffer == NULL) return NULL;
+        context->unescapeBuffer = buffer;
+        context->unescapeCapacity = *length;
+    }
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < *length; i++) {
+        context->unescapeBuffer[size++] = value[i];
+        if (value[i] == IMPORT_QUOTE && i + 1 < *length && value[i + 1] == IMPORT_QUOTE) {
+            i++;
+        }
+    }
+    *length = size;
+    return context->unescapeBuffer;
+}
+
+static int commitImport(ImportContext *context) {
+    if (context->transactionRows == 0) return SQLITE_OK;
+    if (context->isOwnTransaction) {
+        int rc = executeUpdate(context->db, "COMMIT", NULL);
+        if (rc != SQLITE_OK) return rc;
+    }
+    context->stats.rowsImported += context->transactionRows;
+    context->stats.batchCount++;
+    context->transactionRows = 0;
+    return SQLITE_OK;
+}
+
+static void deleteBatchBuffers(ImportBatch *batch) {
+    free(batch->buffer);
+    free(batch->fields);
+    free(batch->recordEnds);
+}
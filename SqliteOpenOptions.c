@@ -0,0 +1,76 @@
+#include "SqliteOpenOptions.h"
+
+#define PRAGMA_BUFFER_SIZE 64
+#define OPEN_MODE_FLAGS (SQLITE_OPEN_READONLY | SQLITE_OPEN_READWRITE)
+
+static const char *const JOURNAL_MODE_NAMES[] = {NULL, "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+static const char *const SYNCHRONOUS_NAMES[] = {NULL, "OFF", "NORMAL", "FULL", "EXTRA"};
+static const char *const TEMP_STORE_NAMES[] = {NULL, "FILE", "MEMORY"};
+
+static int execPragma(sqlite3 *db, const char *name, const char *value);
+static int execJournalModePragma(sqlite3 *db, const char *mode);
+static int execIntPragma(sqlite3 *db, const char *name, int64_t value);
+
+
+int sqliteOpenFlags(const SqliteOpenOptions *options) {
+    int flags = options != NULL ? options->openFlags : 0;
+    if ((flags & OPEN_MODE_FLAGS) == 0) {
+        flags |= SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    }
+    return flags;
+}
+
+int sqliteApplyOpenOptions(sqlite3 *db, const SqliteOpenOptions *options) {
+    if (db == NULL) return SQLITE_MISUSE;
+    if (options == NULL) return SQLITE_OK;
+
+    int rc = sqlite3_busy_timeout(db, (int) options->busyTimeoutMs);
+    if (rc == SQLITE_OK && options->pageSize > 0) {
+        rc = execIntPragma(db, "page_size", options->pageSize);
+    }
+    if (rc == SQLITE_OK && options->journalMode > DB_JOURNAL_DEFAULT && options->journalMode <= DB_JOURNAL_OFF) {
+        rc = execJournalModePragma(db, JOURNAL_MODE_NAMES[options->journalMode]);
+    }
+    if (rc == SQLITE_OK && options->synchronous > DB_SYNC_DEFAULT && options->synchronous <= DB_SYNC_EXTRA) {
+        rc = execPragma(db, "synchronous", SYNCHRONOUS_NAMES[options->synchronous]);
+    }
+    if (rc == SQLITE_OK && options->cacheSize != 0) {
+        rc = execIntPragma(db, "cache_size", options->cacheSize);
+    }
+    if (rc == SQLITE_OK && options->mmapSize > 0) {
+        rc = execIntPragma(db, "mmap_size", options->mmapSize);
+    }
+    if (rc == SQLITE_OK && options->tempStore > DB_TEMP_STORE_DEFAULT && options->tempStore <= DB_TEMP_STORE_MEMORY) {
+        rc = execPragma(db, "temp_store", TEMP_STORE_NAMES[options->tempStore]);
+    }
+    return rc;
+}
+
+static int execPragma(sqlite3 *db, const char *name, const char *value) {
+    char pragma[PRAGMA_BUFFER_SIZE];
+    snprintf(pragma, PRAGMA_BUFFER_SIZE, "PRAGMA %s=%s", name, value);
+    return sqlite3_exec(db, pragma, NULL, NULL, NULL);
+}
+
+// Mode that can't be applied is silently replaced, e.g. WAL for in-memory db, so returned mode is checked
+static int execJournalModePragma(sqlite3 *db, const char *mode) {
+    char pragma[PRAGMA_BUFFER_SIZE];
+    snprintf(pragma, PRAGMA_BUFFER_SIZE, "PRAGMA journal_mode=%s", mode);
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(db, pragma, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) return rc;
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        const char *appliedMode = (const char *) sqlite3_column_text(stmt, 0);
+        rc = appliedMode != NULL && sqlite3_stricmp(appliedMode, mode) == 0 ? SQLITE_OK : SQLITE_ERROR;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+static int execIntPragma(sqlite3 *db, const char *name, int64_t value) {
+    char pragma[PRAGMA_BUFFER_SIZE];
+    snprintf(pragma, PRAGMA_BUFFER_SIZE, "PRAGMA %s=%" PRId64, name, value);
+    return sqlite3_exec(db, pragma, NULL, NULL, NULL);
+}
@@ -0,0 +1,255 @@
+#include "SqliteWrapper.h"
+
+typedef struct ParallelScan {
+    SqlitePool *pool;
+    const char *sql;
+    str_DbValueMap *queryParams;
+    uint32_t batchRows;
+    PartitionScanCallback rowCallback;
+    ColumnBatchScanCallback batchCallback;
+    void *context;
+    pthread_mutex_t mutex;          // serializes batch callbacks and first error update
+    int rc;                         // first error of partitions
+    SqliteCancelToken cancelToken;  // interrupts other partitions after error
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    sqlite3_snapshot *snapshot;
+#endif
+} ParallelScan;
+
+typedef struct ScanPartition {
+    ParallelScan *scan;
+    uint32_t index;
+    int64_t fromKey;
+    int64_t toKey;
+    pthread_t thread;
+    bool isThreadStarted;
+} ScanPartition;
+
+static int runParallelScan(ParallelScan *scan, const ParallelScanOptions *options);
+static int queryKeyRange(sqlite3 *db, const ParallelScanOptions *options, int64_t *minKey, int64_t *maxKey, bool *isEmpty);
+static uint32_t splitKeyRange(ScanPartition *partitions, uint32_t partitionCount, int64_t minKey, int64_t maxKey);
+static void *runPartitionThread(void *arg);
+static void scanPartition(ScanPartition *partition, sqlite3 *db);
+static int executePartition(ScanPartition *partition, sqlite3 *db);
+static int bindPartitionBounds(SqliteStatement *statement, int64_t fromKey, int64_t toKey);
+static int deliverColumnBatches(ScanPartition *partition, ResultSet *resultSet);
+static void failParallelScan(ParallelScan *scan, int rc);
+
+
+int poolParallelScan(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams, const ParallelScanOptions *options,
+                     PartitionScanCallback callback, void *context) {
+    if (callback == NULL) return SQLITE_MISUSE;
+    ParallelScan scan = {.pool = pool, .sql = sql, .queryParams = queryParams, .rowCallback = callback, .context = context};
+    return runParallelScan(&scan, options);
+}
+
+int poolParallelScanBatches(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams, const ParallelScanOptions *options,
+                            ColumnBatchScanCallback callback, void *context) {
+    if (callback == NULL) return SQLITE_MISUSE;
+    ParallelScan scan = {.pool = pool, .sql = sql, .queryParams = queryParams, .batchCallback = callback, .context = context};
+    return runParallelScan(&scan, options);
+}
+
+// Caller connection opens read transaction first, so snapshot can't be checkpointed until all partitions are done
+static int runParallelScan(ParallelScan *scan, const ParallelScanOptions *options) {
+    if (scan->pool == NULL || scan->sql == NULL || options == NULL || options->table == NULL) return SQLITE_MISUSE;
+    uint32_t partitionCount = options->partitionCount > 0 && options->partitionCount < scan->pool->readerCount
+                              ? options->partitionCount
+                              : scan->pool->readerCount;    // each partition holds reader until scan end
+    if (partitionCount > SQLITE_PARALLEL_SCAN_MAX_PARTITIONS) {
+        partitionCount = SQLITE_PARALLEL_SCAN_MAX_PARTITIONS;
+    }
+    scan->batchRows = options->batchRows > 0 ? options->batchRows : SQLITE_PARALLEL_SCAN_BATCH_ROWS;
+
+    sqlite3 *leader = sqlitePoolAcquireReader(scan->pool);
+    int64_t minKey = 0;
+    int64_t maxKey = 0;
+    bool isEmpty = true;
+    int rc = executeUpdate(leader, "BEGIN", NULL);
+    if (rc == SQLITE_OK) {
+        rc = queryKeyRange(leader, options, &minKey, &maxKey, &isEmpty);
+    }
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_snapshot_get(leader, "main", &scan->snapshot);
+    }
+#endif
+
+    if (rc == SQLITE_OK && !isEmpty) {
+        pthread_mutex_init(&scan->mutex, NULL);
+        ScanPartition partitions[SQLITE_PARALLEL_SCAN_MAX_PARTITIONS];
+        partitionCount = splitKeyRange(partitions, partitionCount, minKey, maxKey);
+        for (uint32_t i = 1; i < partitionCount; i++) {
+            partitions[i].scan = scan;
+            partitions[i].isThreadStarted = pthread_create(&partitions[i].thread, NULL, runPartitionThread, &partitions[i]) == 0;
+        }
+        partitions[0].scan = scan;
+        scanPartition(&partitions[0], leader);
+
+        for (uint32_t i = 1; i < partitionCount; i++) {
+            if (partitions[i].isThreadStarted) {
+                pthread_join(partitions[i].thread, NULL);
+            } else {
+                scanPartition(&partitions[i], NULL);    // readers of finished partitions are already released
+            }
+        }
+        pthread_mutex_destroy(&scan->mutex);
+        rc = scan->rc;
+    }
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    sqlite3_snapshot_free(scan->snapshot);
+#endif
+    if (sqlite3_get_autocommit(leader) == 0) {
+        executeUpdate(leader, "COMMIT", NULL);
+    }
+    sqlitePoolRelease(scan->pool, leader);
+    return rc;
+}
+
+static int queryKeyRange(sqlite3 *db, const ParallelScanOptions *options, int64_t *minKey, int64_t *maxKey, bool *isEmpty) {
+    const char *keyColumn = options->keyColumn != NULL ? options->keyColumn : "rowid";
+    char *rangeSql = sqlite3_mprintf("SELECT min(\"%w\"), max(\"%w\") FROM \"%w\"", keyColumn, keyColumn, options->table);
+    if (rangeSql == NULL) return SQLITE_NOMEM;
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(db, rangeSql, -1, &stmt, NULL);
+    sqlite3_free(rangeSql);
+    if (rc != SQLITE_OK) return rc;
+
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *isEmpty = sqlite3_column_type(stmt, 0) == SQLITE_NULL;
+        *minKey = sqlite3_column_int64(stmt, 0);
+        *maxKey = sqlite3_column_int64(stmt, 1);
+        rc = SQLITE_OK;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Equal sized inclusive ranges, unsigned math doesn't overflow for whole int64 range
+static uint32_t splitKeyRange(ScanPartition *partitions, uint32_t partitionCount, int64_t minKey, int64_t maxKey) {
+    uint64_t span = (uint64_t) maxKey - (uint64_t) minKey;   // key count - 1
+    if (span < partitionCount - 1) {
+        partitionCount = (uint32_t) span + 1;
+    }
+    uint64_t keyCount = span < UINT64_MAX ? span + 1 : UINT64_MAX;
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < partitionCount; i++) {
+        partitions[i] = (ScanPartition) {.index = i, .fromKey = (int64_t) ((uint64_t) minKey + offset)};
+        offset += keyCount / partitionCount + (i < keyCount % partitionCount);
+        partitions[i].toKey = i + 1 < partitionCount ? (int64_t) ((uint64_t) minKey + offset - 1) : maxKey;
+    }
+    return partitionCount;
+}
+
+static void *runPartitionThread(void *arg) {
+    scanPartition((ScanPartition *) arg, NULL);
+    return NULL;
+}
+
+// Partition without 'db' takes own reader and opens shared snapshot in it
+static void scanPartition(ScanPartition *partition, sqlite3 *db) {
+    ParallelScan *scan = partition->scan;
+    sqlite3 *reader = db != NULL ? db : sqlitePoolAcquireReader(scan->pool);
+    int rc = db != NULL ? SQLITE_OK : executeUpdate(reader, "BEGIN", NULL);
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    if (rc == SQLITE_OK && db == NULL) {
+        rc = sqlite3_snapshot_open(reader, "main", scan->snapshot);
+    }
+#endif
+    DeadlineState scanDeadline;
+    if (rc == SQLITE_OK) {
+        rc = sqliteDeadlineInit(&scanDeadline, reader, &(QueryDeadline) {.cancelToken = &scan->cancelToken});
+    }
+    if (rc == SQLITE_OK) {
+        DeadlineState *previous = sqliteDeadlineEnter(&scanDeadline);
+        rc = executePartition(partition, reader);
+        sqliteDeadlineLeave(&scanDeadline, previous);
+        sqliteDeadlineDisarm(&scanDeadline);
+    }
+    if (rc != SQLITE_OK) {
+        failParallelScan(scan, rc);
+    }
+
+    if (db == NULL) {
+        if (sqlite3_get_autocommit(reader) == 0) {
+            executeUpdate(reader, "COMMIT", NULL);
+        }
+        sqlitePoolRelease(scan->pool, reader);
+    }
+}
+
+static int executePartition(ScanPartition *partition, sqlite3 *db) {
+    ParallelScan *scan = partition->scan;
+    SqliteStatement *statement = sqliteAcquireStatement(db, scan->sql);
+    if (statement == NULL) {
+        int rc = sqlite3_errcode(db);
+        return rc != SQLITE_OK ? rc : SQLITE_MISUSE;
+    }
+
+    int rc = sqliteStatementBind(statement, scan->queryParams, false);  // parameters are valid until scan end
+    if (rc == SQLITE_OK) {
+        rc = bindPartitionBounds(statement, partition->fromKey, partition->toKey);
+    }
+    ResultSet *resultSet = rc == SQLITE_OK ? newStatementResultSet(statement, NULL) : NULL;
+    if (resultSet == NULL) {
+        sqliteStatementRelease(statement);
+        return rc != SQLITE_OK ? rc : SQLITE_NOMEM;
+    }
+
+    rc = scan->rowCallback != NULL
+         ? scan->rowCallback(scan->context, partition->index, resultSet)
+         : deliverColumnBatches(partition, resultSet);
+    int stepResult = resultSet->stepResult;
+    if (rc == SQLITE_OK && stepResult != SQLITE_OK && stepResult != SQLITE_ROW && stepResult != SQLITE_DONE) {
+        rc = stepResult;
+    }
+    resultSetDelete(resultSet);
+    return rc;
+}
+
+static int bindPartitionBounds(SqliteStatement *statement, int64_t fromKey, int64_t toKey) {
+    bool isFromBound = false;
+    bool isToBound = false;
+    for (uint32_t i = 0; i < getVectorSize(statement->paramNames); i++) {
+        const char *paramName = vectorGet(statement->paramNames, i);
+        int rc = SQLITE_OK;
+        if (strcmp(paramName, SQLITE_SCAN_FROM_PARAM) == 0) {
+            rc = sqlite3_bind_int64(statement->stmt, (int) (i + 1), fromKey);
+            isFromBound = true;
+        } else if (strcmp(paramName, SQLITE_SCAN_TO_PARAM) == 0) {
+            rc = sqlite3_bind_int64(statement->stmt, (int) (i + 1), toKey);
+            isToBound = true;
+        }
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    return isFromBound && isToBound ? SQLITE_OK : SQLITE_RANGE;    // without bounds each partition would scan whole table
+}
+
+static int deliverColumnBatches(ScanPartition *partition, ResultSet *resultSet) {
+    ParallelScan *scan = partition->scan;
+    ColumnBatch *batch = newColumnBatch(scan->batchRows);
+    if (batch == NULL) return SQLITE_NOMEM;
+
+    int rc = SQLITE_OK;
+    while (rc == SQLITE_OK && !sqliteIsCancelled(&scan->cancelToken) && rsFetchColumnBatch(resultSet, batch) > 0) {
+        pthread_mutex_lock(&scan->mutex);
+        rc = scan->batchCallback(scan->context, partition->index, batch);
+        pthread_mutex_unlock(&scan->mutex);
+    }
+    deleteColumnBatch(batch);
+    return rc;
+}
+
+// Other partitions are interrupted by cancel token and report SQLITE_QUERY_CANCELLED, so first error is kept
+static void failParallelScan(ParallelScan *scan, int rc) {
+    pthread_mutex_lock(&scan->mutex);
+    if (scan->rc == SQLITE_OK) {
+        scan->rc = rc;
+    }
+    pthread_mutex_unlock(&scan->mutex);
+    sqliteCancel(&scan->cancelToken);
+}
@@ -0,0 +1,150 @@
+#include "SqliteWrapper.h"
+
+#define POOL_WRITER_SLOT 0
+#define POOL_FIRST_READER_SLOT 1
+#define POOL_MODE_FLAGS (SQLITE_OPEN_READONLY | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)
+
+static sqlite3 *acquirePoolSlot(SqlitePool *pool, uint32_t firstSlot, uint32_t slotCount);
+static sqlite3 *tryAcquirePoolSlot(SqlitePool *pool, uint32_t firstSlot, uint32_t slotCount, uint32_t startSlot);
+static void releasePoolConnection(void *context, sqlite3 *db);
+
+
+SqlitePool *newSqlitePool(const char *dbName, uint32_t readerCount) {
+    return newSqlitePoolWithOptions(dbName, readerCount, &(SqliteOpenOptions) {.busyTimeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS});
+}
+
+SqlitePool *newSqlitePoolWithOptions(const char *dbName, uint32_t readerCount, const SqliteOpenOptions *options) {
+    if (dbName == NULL || readerCount < 1 || readerCount >= SQLITE_MAX_CONNECTIONS || options == NULL) return NULL;
+    SqlitePool *pool = calloc(1, sizeof(struct SqlitePool));
+    if (pool == NULL) return NULL;
+
+    pool->slots = calloc(readerCount + 1, sizeof(struct SqlitePoolSlot));
+    if (pool->slots == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pool->readerCount = readerCount;
+    pthread_mutex_init(&pool->waitMutex, NULL);
+    pthread_cond_init(&pool->slotReleased, NULL);
+
+    // WAL mode is persistent and should be set before readers are opened
+    SqliteOpenOptions writerOptions = *options;
+    writerOptions.openFlags = (options->openFlags & ~POOL_MODE_FLAGS) | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    writerOptions.journalMode = DB_JOURNAL_WAL;
+    pool->slots[POOL_WRITER_SLOT].db = sqliteDbInitWithOptions(dbName, &writerOptions);
+    if (pool->slots[POOL_WRITER_SLOT].db == NULL) {
+        deleteSqlitePool(pool);
+        return NULL;
+    }
+
+    SqliteOpenOptions readerOptions = *options;
+    readerOptions.openFlags = (options->openFlags & ~POOL_MODE_FLAGS) | SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+    readerOptions.journalMode = DB_JOURNAL_DEFAULT;    // can't be changed by read only connection
+    readerOptions.pageSize = 0;
+    for (uint32_t i = 0; i < readerCount; i++) {
+        sqlite3 *reader = sqliteDbInitWithOptions(dbName, &readerOptions);
+        if (reader == NULL) {
+            deleteSqlitePool(pool);
+            return NULL;
+        }
+        pool->slots[POOL_FIRST_READER_SLOT + i].db = reader;
+    }
+    return pool;
+}
+
+sqlite3 *sqlitePoolAcquireReader(SqlitePool *pool) {
+    if (pool == NULL) return NULL;
+    return acquirePoolSlot(pool, POOL_FIRST_READER_SLOT, pool->readerCount);
+}
+
+sqlite3 *sqlitePoolAcquireWriter(SqlitePool *pool) {
+    if (pool == NULL) return NULL;
+    return acquirePoolSlot(pool, POOL_WRITER_SLOT, 1);
+}
+
+void sqlitePoolRelease(SqlitePool *pool, sqlite3 *db) {
+    if (pool == NULL || db == NULL) return;
+    for (uint32_t i = 0; i <= pool->readerCount; i++) {
+        if (pool->slots[i].db == db) {
+            __sync_lock_release(&pool->slots[i].isBusy);
+            break;
+        }
+    }
+
+    if (__sync_fetch_and_add(&pool->waiterCount, 0) > 0) {   // full barrier, slot release is visible to waiters
+        pthread_mutex_lock(&pool->waitMutex);
+        pthread_cond_broadcast(&pool->slotReleased);
+        pthread_mutex_unlock(&pool->waitMutex);
+    }
+}
+
+ResultSet *poolExecuteQuery(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams) {
+    sqlite3 *db = sqlitePoolAcquireReader(pool);
+    if (db == NULL) return NULL;
+
+    ResultSet *rs = executeQuery(db, sql, queryParams);
+    if (rs == NULL) {
+        sqlitePoolRelease(pool, db);
+        return NULL;
+    }
+    rs->releaseCallback = releasePoolConnection;
+    rs->releaseContext = pool;
+    return rs;
+}
+
+ResultSet *poolExecuteCallbackQuery(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams) {
+    sqlite3 *db = sqlitePoolAcquireReader(pool);
+    if (db == NULL) return NULL;
+    ResultSet *rs = executeCallbackQuery(db, sql, queryParams);     // values are copied, reader can be released
+    sqlitePoolRelease(pool, db);
+    return rs;
+}
+
+int poolExecuteUpdate(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams) {
+    sqlite3 *db = sqlitePoolAcquireWriter(pool);
+    if (db == NULL) return SQLITE_MISUSE;
+    int rc = executeUpdate(db, sql, queryParams);
+    sqlitePoolRelease(pool, db);
+    return rc;
+}
+
+void deleteSqlitePool(SqlitePool *pool) {
+    if (pool != NULL) {
+        for (uint32_t i = 0; i <= pool->readerCount; i++) {
+            sqliteDbClose(pool->slots[i].db);
+        }
+        pthread_cond_destroy(&pool->slotReleased);
+        pthread_mutex_destroy(&pool->waitMutex);
+        free(pool->slots);
+        free(pool);
+    }
+}
+
+static sqlite3 *acquirePoolSlot(SqlitePool *pool, uint32_t firstSlot, uint32_t slotCount) {
+    uint32_t startSlot = slotCount > 1 ? __sync_fetch_and_add(&pool->nextReader, 1) % slotCount : 0;  // spread readers between threads
+    sqlite3 *db = tryAcquirePoolSlot(pool, firstSlot, slotCount, startSlot);
+    if (db != NULL) return db;
+
+    pthread_mutex_lock(&pool->waitMutex);
+    __sync_fetch_and_add(&pool->waiterCount, 1);
+    while ((db = tryAcquirePoolSlot(pool, firstSlot, slotCount, startSlot)) == NULL) {
+        pthread_cond_wait(&pool->slotReleased, &pool->waitMutex);
+    }
+    __sync_fetch_and_sub(&pool->waiterCount, 1);
+    pthread_mutex_unlock(&pool->waitMutex);
+    return db;
+}
+
+static sqlite3 *tryAcquirePoolSlot(SqlitePool *pool, uint32_t firstSlot, uint32_t slotCount, uint32_t startSlot) {
+    for (uint32_t i = 0; i < slotCount; i++) {
+        SqlitePoolSlot *slot = &pool->slots[firstSlot + (startSlot + i) % slotCount];
+        if (__atomic_load_n(&slot->isBusy, __ATOMIC_RELAXED) == 0 && __sync_bool_compare_and_swap(&slot->isBusy, 0, 1)) {
+            return slot->db;
+        }
+    }
+    return NULL;
+}
+
+static void releasePoolConnection(void *context, sqlite3 *db) {
+    sqlitePoolRelease((SqlitePool *) context, db);
+}
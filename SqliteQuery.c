@@ -1,13 +1,16 @@
+#include <ctype.h>
 #include "SqliteQuery.h"
 
 #define DB_NAMED_PARAM_MAX_LENGTH 128
 #define DB_NULL_STR_VALUE "NULL"
 
-static char *allocateString(uint32_t capacity);
+static char *allocateString(SqliteArena *arena, uint32_t capacity);
 static void doubleStringCapacity(QueryString *str, uint32_t capacity);
 static QueryString *newQueryStringFromBuffer(char *buffer, uint32_t size, uint32_t capacity);
 static char *copyStringValue(QueryString *str, uint32_t size);
 static uint32_t substringParamName(char *buffer, const char *origString);
+static uint32_t findOrAddParamName(Vector paramNames, const char *paramName);
+static void appendBlobLiteral(QueryString *query, DbValue value);
 char *intToString(int64_t value, char* result, int base);
 
 
@@ -16,18 +19,23 @@ QueryString *newQueryString() {
 }
 
 QueryString *newQueryStringWithSize(uint32_t capacity) {
+    return newQueryStringWithArena(NULL, capacity);
+}
+
+QueryString *newQueryStringWithArena(SqliteArena *arena, uint32_t capacity) {
     if (capacity < 1) return NULL;
-    QueryString *str = malloc(sizeof(struct QueryString));
+    QueryString *str = sqliteArenaAlloc(arena, sizeof(struct QueryString));
     if (str == NULL) return NULL;
 
-    str->value = allocateString(capacity);
+    str->value = allocateString(arena, capacity);
     if (str->value == NULL) {
-        free(str);
+        sqliteArenaFree(arena, str);
         return NULL;
     }
 
     str->capacity = capacity;
     str->size = 0;
+    str->arena = arena;
     return str;
 }
 
@@ -40,6 +48,7 @@ QueryString *queryStringAppend(QueryString *str, const char* value, uint32_t val
 
     memcpy(str->value + str->size, value, valueLength);
     str->size += valueLength;
+    str->value[str->size] = '\0';
     return str;
 }
 
@@ -50,6 +59,7 @@ QueryString *queryStringAppendChar(QueryString *str, char charValue) {
     }
     str->value[str->size] = charValue;
     str->size++;
+    str->value[str->size] = '\0';
     return str;
 }
 
@@ -64,7 +74,7 @@ QueryString *queryStringOf(const char* format, ...) {
     va_end(args);
 
     if (capacity > formattedStrSize) {
-        QueryString *str = newQueryStringFromBuffer(buffer, formattedStrSize, capacity);
+        QueryString *str = newQueryStringFromBuffer(buffer, formattedStrSize, capacity - 1);   // last byte is for terminator
         if (str == NULL) {
             free(buffer);
             return NULL;
@@ -84,7 +94,7 @@ QueryString *queryStringOf(const char* format, ...) {
     va_end(args);
 
     QueryString *str = newQueryStringFromBuffer(buffer, formattedStrSize, formattedStrSize);
-    if (buffer == NULL) {
+    if (str == NULL) {
         free(buffer);
         return NULL;
     }
@@ -92,11 +102,16 @@ QueryString *queryStringOf(const char* format, ...) {
 }
 
 QueryString *namedQueryString(const char *sql, str_DbValueMap *queryParams) {
+    return namedQueryStringWithArena(NULL, sql, queryParams);
+}
+
+QueryString *namedQueryStringWithArena(SqliteArena *arena, const char *sql, str_DbValueMap *queryParams) {
     uint32_t sqlLength = sql != NULL ? strlen(sql) : 0;
     if (sql == 0) return NULL;
     char buffer[DB_NAMED_PARAM_MAX_LENGTH];
 
-    QueryString *query = newQueryStringWithSize((uint32_t) (sqlLength * 1.5));
+    QueryString *query = newQueryStringWithArena(arena, (uint32_t) (sqlLength * 1.5) + 1);
+    if (query == NULL) return NULL;
     const char *sqlStr = sql;
     while (*sqlStr != '\0') {
         if (*sqlStr == ':') {
@@ -124,10 +139,12 @@ QueryString *namedQueryString(const char *sql, str_DbValueMap *queryParams) {
                 }
                     break;
                 case DB_VALUE_BLOB:
+                    appendBlobLiteral(query, dbValue);
                     break;
             }
 
             sqlStr += paramLength;
+            continue;   // parameter can be at the end of sql
         }
 
         queryStringAppendChar(query, *sqlStr);
@@ -137,22 +154,70 @@ QueryString *namedQueryString(const char *sql, str_DbValueMap *queryParams) {
     return query;
 }
 
+QueryString *nativeQueryString(const char *sql, Vector paramNames) {
+    if (sql == NULL || paramNames == NULL) return NULL;
+    char buffer[DB_NAMED_PARAM_MAX_LENGTH + 1];
+
+    QueryString *query = newQueryStringWithSize(strlen(sql) + 1);
+    if (query == NULL) return NULL;
+    const char *sqlStr = sql;
+    char closingChar = '\0';    // end of quoted identifier, string literal or comment
+    while (*sqlStr != '\0') {
+        char charValue = *sqlStr;
+        if (closingChar != '\0') {    // copy literals and comments as is
+            if (closingChar == '*' && charValue == '*' && sqlStr[1] == '/') {
+                queryStringAppendChar(query, *sqlStr++);
+                charValue = *sqlStr;
+                closingChar = '\0';
+            } else if (closingChar != '*' && charValue == closingChar) {
+                closingChar = '\0';
+            }
+        } else if (charValue == '\'' || charValue == '"' || charValue == '`') {
+            closingChar = charValue;
+        } else if (charValue == '[') {
+            closingChar = ']';
+        } else if (charValue == '-' && sqlStr[1] == '-') {
+            closingChar = '\n';
+        } else if (charValue == '/' && sqlStr[1] == '*') {
+            queryStringAppendChar(query, *sqlStr++);
+            charValue = *sqlStr;
+            closingChar = '*';
+        } else if (charValue == ':') {
+            uint32_t paramLength = substringParamName(buffer, sqlStr + 1);
+            if (paramLength > 0) {  // replace named parameter with numbered '?NNN', same names share same index
+                uint32_t paramIndex = findOrAddParamName(paramNames, buffer);
+                char *indexAsStr = intToString(paramIndex + 1, buffer, 10);
+                queryStringAppendChar(query, '?');
+                queryStringAppend(query, indexAsStr, strlen(indexAsStr));
+                sqlStr += paramLength + 1;
+                continue;
+            }
+        }
+
+        queryStringAppendChar(query, charValue);
+        sqlStr++;
+    }
+
+    return query;
+}
+
 const char *queryStringGetValue(QueryString *str) {
     return str->value;
 }
 
 void deleteQueryString(QueryString *str) {
     if (str != NULL) {
-        free(str->value);
+        SqliteArena *arena = str->arena;
+        sqliteArenaFree(arena, str->value);
         str->value = NULL;
-        free(str);
+        sqliteArenaFree(arena, str);
     }
 }
 
-static char *allocateString(uint32_t capacity) {
-    char *data = malloc(capacity + 1);
+static char *allocateString(SqliteArena *arena, uint32_t capacity) {
+    char *data = sqliteArenaAlloc(arena, capacity + 1);
     if (data == NULL) return NULL;
-    memset(data, 0, capacity + 1);
+    data[0] = '\0';    // terminator is moved on append
     return data;
 }
 
@@ -162,8 +227,8 @@ static void doubleStringCapacity(QueryString *str, uint32_t capacity) {
         newCapacity = capacity;
     }
 
-    str->capacity = newCapacity;
     str->value = copyStringValue(str, newCapacity);
+    str->capacity = newCapacity;
 }
 
 static QueryString *newQueryStringFromBuffer(char *buffer, uint32_t size, uint32_t capacity) {
@@ -172,14 +237,12 @@ static QueryString *newQueryStringFromBuffer(char *buffer, uint32_t size, uint32
     str->value = buffer;
     str->size = size;
     str->capacity = capacity;
+    str->arena = NULL;
     return str;
 }
 
 static char *copyStringValue(QueryString *str, uint32_t size) {
-    char *data = allocateString(size);
-    memcpy(data, str->value, str->size);
-    free(str->value);
-    return data;
+    return sqliteArenaRealloc(str->arena, str->value, str->capacity + 1, size + 1);
 }
 
 static uint32_t substringParamName(char *buffer, const char *origString) {
@@ -198,6 +261,36 @@ static uint32_t substringParamName(char *buffer, const char *origString) {
     return i;
 }
 
+static uint32_t findOrAddParamName(Vector paramNames, const char *paramName) {
+    uint32_t paramCount = getVectorSize(paramNames);
+    for (uint32_t i = 0; i < paramCount; i++) {
+        if (strcmp(vectorGet(paramNames, i), paramName) == 0) {
+            return i;
+        }
+    }
+    vectorAdd(paramNames, strdup(paramName));
+    return paramCount;
+}
+
+// X'0A1B' literal, zero filled blob is formatted as zeroblob(N)
+static void appendBlobLiteral(QueryString *query, DbValue value) {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    const uint8_t *bytes = DB_VALUE_AS_BLOB(value);
+    if (bytes == NULL) {
+        char buffer[DB_NAMED_PARAM_MAX_LENGTH];
+        uint32_t length = snprintf(buffer, DB_NAMED_PARAM_MAX_LENGTH, "zeroblob(%" PRIu32 ")", value.length);
+        queryStringAppend(query, buffer, length);
+        return;
+    }
+
+    queryStringAppend(query, "X'", 2);
+    for (uint32_t i = 0; i < value.length; i++) {
+        queryStringAppendChar(query, hexDigits[bytes[i] >> 4]);
+        queryStringAppendChar(query, hexDigits[bytes[i] & 0x0F]);
+    }
+    queryStringAppendChar(query, '\'');
+}
+
 char *intToString(int64_t value, char* result, int base) {
     if (base < 2 || base > 36) {    // check that the base if valid
         *result = '\0';
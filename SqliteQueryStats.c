@@ -0,0 +1,268 @@
+#include "SqliteQueryStats.h"
+
+#define QUERY_PLAN_DETAIL_COLUMN 3
+
+static int traceCallback(unsigned int type, void *context, void *pointer, void *value);
+static QueryStatsExecution *findExecution(QueryStatsRegistry *registry, sqlite3_stmt *stmt);
+static QueryStatsExecution *findTracedExecution(QueryStatsRegistry *registry, sqlite3_stmt *stmt);
+static void completeExecution(QueryStatsExecution *execution);
+static QueryStatsEntry *findOrAddEntry(QueryStatsRegistry *registry, SqliteStatement *statement);
+static char *captureQueryPlan(sqlite3 *db, sqlite3_stmt *stmt);
+static void foldExecution(QueryStatsEntry *entry, sqlite3_stmt *stmt, const QueryExecution *execution);
+
+
+QueryStatsRegistry *newQueryStatsRegistry(sqlite3 *db) {
+    QueryStatsRegistry *registry = calloc(1, sizeof(struct QueryStatsRegistry));
+    if (registry == NULL) return NULL;
+    registry->db = db;
+    return registry;
+}
+
+int queryStatsEnable(QueryStatsRegistry *registry, const QueryStatsOptions *options) {
+    if (registry == NULL) return SQLITE_MISUSE;
+    registry->options = options != NULL ? *options : (QueryStatsOptions) {0};
+    int rc = sqlite3_trace_v2(registry->db, SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, traceCallback, registry);
+    registry->isEnabled = rc == SQLITE_OK;
+    return rc;
+}
+
+void queryStatsDisable(QueryStatsRegistry *registry) {
+    if (registry == NULL || !registry->isEnabled) return;
+    sqlite3_trace_v2(registry->db, 0, NULL, NULL);
+    registry->isEnabled = false;
+    for (uint32_t i = 0; i < SQLITE_QUERY_STATS_MAX_ACTIVE; i++) {
+        if (registry->active[i].stmt != NULL) {
+            completeExecution(&registry->active[i]);
+        }
+    }
+}
+
+void queryStatsBegin(QueryStatsRegistry *registry, SqliteStatement *statement, bool isPrepared, uint64_t prepareMicros) {
+    statement->queryStats = NULL;
+    if (registry == NULL || !registry->isEnabled) return;
+
+    QueryStatsExecution *execution = findExecution(registry, NULL);
+    QueryStatsEntry *entry = execution != NULL ? findOrAddEntry(registry, statement) : NULL;
+    if (entry == NULL) {
+        registry->droppedExecutions++;
+        return;
+    }
+
+    if (!entry->isPlanCaptured && registry->options.captureQueryPlan) {
+        entry->stats.queryPlan = captureQueryPlan(registry->db, statement->stmt);
+        entry->isPlanCaptured = true;
+    }
+    execution->stmt = statement->stmt;
+    execution->statement = statement;
+    execution->entry = entry;
+    execution->registry = registry;
+    execution->values = (QueryExecution) {.sql = entry->stats.sql, .isPrepared = isPrepared, .prepareMicros = prepareMicros};
+    execution->busyWaitStartMicros = registry->busyWaitMicros;
+    statement->queryStats = execution;
+}
+
+void queryStatsAddBoundBytes(SqliteStatement *statement, str_DbValueMap *queryParams) {
+    if (statement->queryStats == NULL || queryParams == NULL) return;
+    for (uint32_t i = 0; i < getVectorSize(statement->paramNames); i++) {
+        queryStatsAddBoundValue(statement, str_DbValueMapGetOrDefault(queryParams, vectorGet(statement->paramNames, i), DB_NULL_VALUE()));
+    }
+}
+
+void queryStatsAddBoundValue(SqliteStatement *statement, DbValue value) {
+    if (statement->queryStats == NULL) return;
+    uint64_t bytes = 0;
+    if (value.type == DB_VALUE_TEXT) {
+        bytes = value.as.strValue != NULL ? strlen(value.as.strValue) : 0;
+    } else if (value.type == DB_VALUE_BLOB) {
+        bytes = value.length;
+    } else if (value.type == DB_VALUE_INT || value.type == DB_VALUE_REAL) {
+        bytes = sizeof(int64_t);
+    }
+    statement->queryStats->values.bytesBound += bytes;
+}
+
+void queryStatsEnd(SqliteStatement *statement) {
+    QueryStatsExecution *execution = statement->queryStats;
+    if (execution == NULL) return;
+    sqlite3_reset(statement->stmt);     // profile is traced on reset, after last step
+    completeExecution(execution);
+}
+
+void queryStatsTailBegin(SqliteStatement *statement, sqlite3_stmt *stmt) {
+    if (statement->queryStats != NULL) {
+        statement->queryStats->tailStmt = stmt;
+    }
+}
+
+void queryStatsTailEnd(SqliteStatement *statement, sqlite3_stmt *stmt) {
+    QueryStatsExecution *execution = statement->queryStats;
+    if (execution == NULL || execution->tailStmt != stmt) return;
+    sqlite3_reset(stmt);
+    QueryStats *stats = &execution->entry->stats;
+    stats->fullScanSteps += (uint64_t) sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    stats->sortCount += (uint64_t) sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+    execution->tailStmt = NULL;
+}
+
+uint32_t queryStatsSnapshot(QueryStatsRegistry *registry, QueryStats *stats, uint32_t maxCount) {
+    if (registry == NULL) return 0;
+    uint32_t index = 0;
+    for (QueryStatsEntry *entry = registry->head; entry != NULL && index < maxCount && stats != NULL; entry = entry->next) {
+        stats[index++] = entry->stats;
+    }
+    return registry->templateCount;
+}
+
+void queryStatsReset(QueryStatsRegistry *registry) {
+    if (registry == NULL) return;
+    for (QueryStatsEntry *entry = registry->head; entry != NULL; entry = entry->next) {
+        entry->stats = (QueryStats) {.sql = entry->stats.sql, .queryPlan = entry->stats.queryPlan};
+    }
+    registry->droppedExecutions = 0;
+}
+
+void deleteQueryStatsRegistry(QueryStatsRegistry *registry) {
+    if (registry != NULL) {
+        queryStatsDisable(registry);
+        QueryStatsEntry *entry = registry->head;
+        while (entry != NULL) {
+            QueryStatsEntry *next = entry->next;
+            free((char *) entry->stats.sql);
+            free((char *) entry->stats.queryPlan);
+            free(entry);
+            entry = next;
+        }
+        free(registry);
+    }
+}
+
+static int traceCallback(unsigned int type, void *context, void *pointer, void *value) {
+    QueryStatsRegistry *registry = (QueryStatsRegistry *) context;
+    sqlite3_stmt *stmt = (sqlite3_stmt *) pointer;
+    QueryStatsExecution *execution = findTracedExecution(registry, stmt);
+    if (execution == NULL) return SQLITE_OK;    // statement is not executed by wrapper
+
+    if (type == SQLITE_TRACE_ROW) {
+        execution->values.rowsReturned++;
+    } else if (type == SQLITE_TRACE_PROFILE) {
+        execution->values.stepNanos += (uint64_t) *(sqlite3_int64 *) value;
+        if (!sqlite3_stmt_readonly(stmt)) {
+            execution->values.rowsChanged += (uint64_t) sqlite3_changes(registry->db);
+        }
+    }
+    return SQLITE_OK;
+}
+
+static QueryStatsExecution *findExecution(QueryStatsRegistry *registry, sqlite3_stmt *stmt) {
+    for (uint32_t i = 0; i < SQLITE_QUERY_STATS_MAX_ACTIVE; i++) {
+        if (registry->active[i].stmt == stmt) {
+            return &registry->active[i];
+        }
+    }
+    return NULL;
+}
+
+static QueryStatsExecution *findTracedExecution(QueryStatsRegistry *registry, sqlite3_stmt *stmt) {
+    for (uint32_t i = 0; i < SQLITE_QUERY_STATS_MAX_ACTIVE; i++) {
+        if (registry->active[i].stmt == stmt || registry->active[i].tailStmt == stmt) {
+            return &registry->active[i];
+        }
+    }
+    return NULL;
+}
+
+// Waits of statements stepped meanwhile on the same connection are included too, e.g. COMMIT inside open cursor
+static void completeExecution(QueryStatsExecution *execution) {
+    execution->values.busyWaitMicros = execution->registry->busyWaitMicros - execution->busyWaitStartMicros;
+    foldExecution(execution->entry, execution->stmt, &execution->values);
+    QueryStatsOptions *options = &execution->registry->options;
+    if (options->sink != NULL) {
+        options->sink(options->sinkContext, &execution->values);
+    }
+    execution->statement->queryStats = NULL;
+    *execution = (QueryStatsExecution) {0};
+}
+
+static QueryStatsEntry *findOrAddEntry(QueryStatsRegistry *registry, SqliteStatement *statement) {
+    QueryStatsEntry **bucket = &registry->buckets[statement->sqlHash % SQLITE_QUERY_STATS_MAX_TEMPLATES];
+    for (QueryStatsEntry *entry = *bucket; entry != NULL; entry = entry->bucketNext) {
+        if (entry->sqlHash == statement->sqlHash && strcmp(entry->stats.sql, statement->sql) == 0) {
+            return entry;
+        }
+    }
+    if (registry->templateCount >= SQLITE_QUERY_STATS_MAX_TEMPLATES) return NULL;
+
+    QueryStatsEntry *entry = calloc(1, sizeof(struct QueryStatsEntry));
+    if (entry == NULL) return NULL;
+    entry->stats.sql = strdup(statement->sql);
+    if (entry->stats.sql == NULL) {
+        free(entry);
+        return NULL;
+    }
+    entry->sqlHash = statement->sqlHash;
+    entry->bucketNext = *bucket;
+    *bucket = entry;
+
+    if (registry->tail != NULL) {
+        registry->tail->next = entry;
+    } else {
+        registry->head = entry;
+    }
+    registry->tail = entry;
+    registry->templateCount++;
+    return entry;
+}
+
+// Parameters are not bound yet, plan is built for unknown values
+static char *captureQueryPlan(sqlite3 *db, sqlite3_stmt *stmt) {
+    const char *nativeSql = sqlite3_sql(stmt);
+    QueryString *sql = newQueryString();
+    if (sql == NULL) return NULL;
+    queryStringAppend(sql, "EXPLAIN QUERY PLAN ", 19);
+    queryStringAppend(sql, nativeSql, (uint32_t) strlen(nativeSql));
+    sqlite3_stmt *planStmt = NULL;
+    int rc = sqlite3_prepare_v2(db, sql->value, (int) sql->size, &planStmt, NULL);
+    deleteQueryString(sql);
+    if (rc != SQLITE_OK) return NULL;
+
+    QueryString *plan = newQueryString();
+    while (plan != NULL && sqlite3_step(planStmt) == SQLITE_ROW) {
+        const char *detail = (const char *) sqlite3_column_text(planStmt, QUERY_PLAN_DETAIL_COLUMN);
+        if (detail == NULL) continue;
+        if (plan->size > 0) {
+            queryStringAppendChar(plan, '\n');
+        }
+        queryStringAppend(plan, detail, (uint32_t) strlen(detail));
+    }
+    sqlite3_finalize(planStmt);
+
+    char *planStr = plan != NULL ? strdup(plan->value) : NULL;
+    deleteQueryString(plan);
+    return planStr;
+}
+
+static void foldExecution(QueryStatsEntry *entry, sqlite3_stmt *stmt, const QueryExecution *execution) {
+    QueryStats *stats = &entry->stats;
+    stats->callCount++;
+    if (execution->isPrepared) {
+        stats->prepareCount++;
+        stats->totalPrepareMicros += execution->prepareMicros;
+        if (execution->prepareMicros > stats->maxPrepareMicros) {
+            stats->maxPrepareMicros = execution->prepareMicros;
+        }
+    }
+
+    stats->totalStepNanos += execution->stepNanos;
+    if (execution->stepNanos > stats->maxStepNanos) {
+        stats->maxStepNanos = execution->stepNanos;
+    }
+    stats->rowsReturned += execution->rowsReturned;
+    stats->rowsChanged += execution->rowsChanged;
+    stats->bytesBound += execution->bytesBound;
+    stats->totalBusyWaitMicros += execution->busyWaitMicros;
+    if (execution->busyWaitMicros > stats->maxBusyWaitMicros) {
+        stats->maxBusyWaitMicros = execution->busyWaitMicros;
+    }
+    stats->fullScanSteps += (uint64_t) sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    stats->sortCount += (uint64_t) sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+}
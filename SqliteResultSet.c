@@ -1,25 +1,41 @@
 #include "SqliteResultSet.h"
+#include "SqliteDeadline.h"
 
 #define NO_VALUE_INDEX (-1)
+#define NULL_VALUE_OFFSET UINT32_MAX
+#define VALUE_LENGTH_SIZE sizeof(uint32_t)
+#define VALUE_HEADER_SIZE (VALUE_LENGTH_SIZE + 1)     // type byte, then length
 
 static ResultSet *mapColumnNames(ResultSet *resultSet);
-static inline char *getValueStrFromRsVecByName(ResultSet *resultSet, const char *columnName);
-static inline char *getValueStrFromRsVecByIndex(ResultSet *resultSet, int columnIndex);
+static bool mapCallbackColumnNames(ResultSet *resultSet, int columnCount, char **columnNames);
+static bool ensureArenaCapacity(ResultSet *resultSet, uint32_t size);
+static bool ensureOffsetCapacity(ResultSet *resultSet, uint32_t size);
+
+static inline const char *getValueStrFromArenaByName(ResultSet *resultSet, const char *columnName);
+static inline const char *getValueStrFromArenaByIndex(ResultSet *resultSet, int columnIndex);
+static inline uint32_t getValueLengthFromArena(ResultSet *resultSet, const char *value);
+static inline DbValueType getValueTypeFromArena(const char *value);
+static inline int64_t valueStrToI64(const char *value);
+static inline double valueStrToDouble(const char *value);
 
 static inline int getIndexByColumnName(ResultSet *resultSet, const char *columnName);
 static const char *resultSetGetColumnName(ResultSet *resultSet, int column);
 
-static char *getColumnNameByIndex(ResultSet *resultSet, int columnIndex);
 static int resultSetColumnCount(ResultSet *resultSet);
+static void resultSetFinishStatement(ResultSet *resultSet);
+static bool stepResultSet(ResultSet *resultSet);
 
 
 ResultSet *newSqliteResultSet(sqlite3 *db, sqlite3_stmt *stmt) {
-    ResultSet *resultSet = malloc(sizeof(struct ResultSet));
+    return newSqliteResultSetWithArena(db, stmt, NULL);
+}
+
+ResultSet *newSqliteResultSetWithArena(sqlite3 *db, sqlite3_stmt *stmt, SqliteArena *arena) {
+    ResultSet *resultSet = sqliteArenaCalloc(arena, sizeof(struct ResultSet));
     if (resultSet == NULL) return NULL;
+    resultSet->arena = arena;
     resultSet->db = db;
     resultSet->stmt = stmt;
-    resultSet->columnMap = NULL;
-    resultSet->valueVec = NULL;
     resultSet->valueIndex = -1;
 
     if (stmt == NULL) {
@@ -28,84 +44,172 @@ ResultSet *newSqliteResultSet(sqlite3 *db, sqlite3_stmt *stmt) {
     return mapColumnNames(resultSet);
 }
 
+ResultSet *newStatementResultSet(SqliteStatement *statement, SqliteArena *arena) {
+    ResultSet *resultSet = sqliteArenaCalloc(arena, sizeof(struct ResultSet));
+    if (resultSet == NULL) return NULL;
+    resultSet->arena = arena;
+    resultSet->db = statement->db;
+    resultSet->stmt = statement->stmt;
+    resultSet->statement = statement;
+    resultSet->valueIndex = -1;
+    resultSet->columnMap = sqliteStatementColumnMap(statement);
+    resultSet->isColumnMapShared = true;
+    return resultSet;
+}
+
 bool nextResultSet(ResultSet *resultSet) {
     if (resultSet == NULL) return false;
+    if (resultSet->isRowPending) {
+        resultSet->isRowPending = false;
+        return true;
+    }
 
     if (resultSet->stmt != NULL) {
-        int rc = sqlite3_step(resultSet->stmt);
-        if (rc == SQLITE_ROW) {
-            return true;
-        }
-        sqlite3_finalize(resultSet->stmt);
-        return false;
+        return stepResultSet(resultSet);
     }
 
-    int valueVecLength = (int) getVectorSize(resultSet->valueVec);
-    if (resultSet->valueVec != NULL && resultSet->valueIndex < valueVecLength - 1) {
+    if (resultSet->valueIndex < (int) resultSet->rowCount - 1) {
         resultSet->valueIndex++;
         return true;
     }
     return false;
 }
 
+bool resultSetAppendRow(ResultSet *resultSet, int valueCount, char **values, char **columnNames) {
+    return resultSetAppendRowWithLengths(resultSet, valueCount, values, NULL, columnNames);
+}
+
+bool resultSetAppendRowWithLengths(ResultSet *resultSet, int valueCount, char **values, const uint32_t *lengths, char **columnNames) {
+    return resultSetAppendTypedRow(resultSet, valueCount, values, lengths, NULL, columnNames);
+}
+
+bool resultSetAppendTypedRow(ResultSet *resultSet, int valueCount, char **values, const uint32_t *lengths, const DbValueType *types, char **columnNames) {
+    if (valueCount <= 0) return false;      // column count is used as row size
+    if (resultSet->columnNames == NULL && !mapCallbackColumnNames(resultSet, valueCount, columnNames)) {
+        return false;
+    }
+    if ((uint32_t) valueCount != resultSet->columnCount) return false;
+
+    if (resultSet->rowCount >= (UINT32_MAX - resultSet->columnCount) / resultSet->columnCount) return false;
+    uint32_t rowOffset = resultSet->rowCount * resultSet->columnCount;
+    if (!ensureOffsetCapacity(resultSet, rowOffset + resultSet->columnCount)) {
+        return false;
+    }
+
+    for (int i = 0; i < valueCount; i++) {
+        if (values[i] == NULL) {
+            resultSet->valueOffsets[rowOffset + i] = NULL_VALUE_OFFSET;
+            continue;
+        }
+
+        // Value is stored after its type and length and terminated, so text is read in place and blob can contain zeros
+        size_t length = lengths != NULL ? lengths[i] : strlen(values[i]);
+        if (length >= NULL_VALUE_OFFSET - resultSet->arenaSize - VALUE_HEADER_SIZE - 1) return false;
+        uint32_t valueSize = VALUE_HEADER_SIZE + (uint32_t) length + 1;
+        if (!ensureArenaCapacity(resultSet, resultSet->arenaSize + valueSize)) {
+            return false;
+        }
+        char *value = resultSet->valueArena + resultSet->arenaSize;
+        uint32_t valueLength = (uint32_t) length;
+        value[0] = (char) (types != NULL ? types[i] : DB_VALUE_TEXT);
+        memcpy(value + 1, &valueLength, VALUE_LENGTH_SIZE);
+        memcpy(value + VALUE_HEADER_SIZE, values[i], length);
+        value[VALUE_HEADER_SIZE + length] = '\0';
+        resultSet->valueOffsets[rowOffset + i] = resultSet->arenaSize + VALUE_HEADER_SIZE;
+        resultSet->arenaSize += valueSize;
+    }
+    resultSet->rowCount++;
+    return true;
+}
+
+int rsColumnIndex(ResultSet *resultSet, const char *columnName) {
+    if (resultSet == NULL || columnName == NULL) return NO_VALUE_INDEX;
+    if (resultSet->stmt != NULL && resultSet->stepResult == SQLITE_OK && stepResultSet(resultSet)) {
+        resultSet->isRowPending = true;     // first row is returned by next nextResultSet() call
+    }
+    if (resultSet->columnMap == NULL) return NO_VALUE_INDEX;
+    return getIndexByColumnName(resultSet, columnName);
+}
+
 int rsGetInt(ResultSet *resultSet, const char *columnName) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_int(resultSet->stmt, getIndexByColumnName(resultSet, columnName));
     }
-    return (int) strtoimax(getValueStrFromRsVecByName(resultSet, columnName), NULL, 10);
+    return (int) valueStrToI64(getValueStrFromArenaByName(resultSet, columnName));
 }
 
 int64_t rsGetI64(ResultSet *resultSet, const char *columnName) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_int64(resultSet->stmt, getIndexByColumnName(resultSet, columnName));
     }
-    return strtoimax(getValueStrFromRsVecByName(resultSet, columnName), NULL, 10);
+    return valueStrToI64(getValueStrFromArenaByName(resultSet, columnName));
 }
 
 const char *rsGetString(ResultSet *resultSet, const char *columnName) {
     if (resultSet->stmt != NULL) {
         return (const char *) sqlite3_column_text(resultSet->stmt, getIndexByColumnName(resultSet, columnName));
     }
-    return getValueStrFromRsVecByName(resultSet, columnName);
+    return getValueStrFromArenaByName(resultSet, columnName);
 }
 
 double rsGetDouble(ResultSet *resultSet, const char *columnName) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_double(resultSet->stmt, getIndexByColumnName(resultSet, columnName));
     }
-    return strtod(getValueStrFromRsVecByName(resultSet, columnName), NULL);
+    return valueStrToDouble(getValueStrFromArenaByName(resultSet, columnName));
+}
+
+const void *rsGetBlob(ResultSet *resultSet, const char *columnName, uint32_t *length) {
+    return rsGetBlobByIndex(resultSet, getIndexByColumnName(resultSet, columnName), length);
 }
 
 int rsGetIntByIndex(ResultSet *resultSet, int columnIndex) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_int(resultSet->stmt, columnIndex);
     }
-    return (int) strtoimax(getValueStrFromRsVecByIndex(resultSet, columnIndex), NULL, 10);
+    return (int) valueStrToI64(getValueStrFromArenaByIndex(resultSet, columnIndex));
 }
 
 int64_t rsGetI64ByIndex(ResultSet *resultSet, int columnIndex) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_int64(resultSet->stmt, columnIndex);
     }
-    return strtoimax(getValueStrFromRsVecByIndex(resultSet, columnIndex), NULL, 10);
+    return valueStrToI64(getValueStrFromArenaByIndex(resultSet, columnIndex));
 }
 
 const char *rsGetStringByIndex(ResultSet *resultSet, int columnIndex) {
     if (resultSet->stmt != NULL) {
         return (const char *) sqlite3_column_text(resultSet->stmt, columnIndex);
     }
-    return getValueStrFromRsVecByIndex(resultSet, columnIndex);
+    return getValueStrFromArenaByIndex(resultSet, columnIndex);
 }
 
 double rsGetDoubleByIndex(ResultSet *resultSet, int columnIndex) {
     if (resultSet->stmt != NULL) {
         return sqlite3_column_double(resultSet->stmt, columnIndex);
     }
-    return strtod(getValueStrFromRsVecByIndex(resultSet, columnIndex), NULL);
+    return valueStrToDouble(getValueStrFromArenaByIndex(resultSet, columnIndex));
+}
+
+const void *rsGetBlobByIndex(ResultSet *resultSet, int columnIndex, uint32_t *length) {
+    if (resultSet->stmt != NULL) {
+        const void *value = sqlite3_column_blob(resultSet->stmt, columnIndex);
+        *length = (uint32_t) sqlite3_column_bytes(resultSet->stmt, columnIndex);     // called after blob, no conversion
+        return value;
+    }
+    const char *value = getValueStrFromArenaByIndex(resultSet, columnIndex);
+    *length = getValueLengthFromArena(resultSet, value);
+    return value;
 }
 
 DbValueType rsGetColumnType(ResultSet *resultSet, const char *columnName) {
-    int columnIndex = (long) hashMapGet(resultSet->columnMap, columnName);
+    return rsGetColumnTypeByIndex(resultSet, rsColumnIndex(resultSet, columnName));
+}
+
+DbValueType rsGetColumnTypeByIndex(ResultSet *resultSet, int columnIndex) {
+    if (resultSet->stmt == NULL) {  // callback values are received as text, unless row is appended with types
+        return getValueTypeFromArena(getValueStrFromArenaByIndex(resultSet, columnIndex));
+    }
     int columnType = sqlite3_column_type(resultSet->stmt, columnIndex);
     switch (columnType) {
         case SQLITE_INTEGER:
@@ -123,18 +227,22 @@ DbValueType rsGetColumnType(ResultSet *resultSet, const char *columnName) {
 
 void resultSetDelete(ResultSet *resultSet) {
     if (resultSet != NULL) {
-        for (uint32_t i = 0; i < getVectorSize(resultSet->valueVec); i++) {
-            HashMap valueMap = (HashMap) vectorGet(resultSet->valueVec, i);
-            HashMapIterator iterator = getHashMapIterator(valueMap);
-            while (hashMapHasNext(&iterator)) {
-                free((char *) iterator.key);
-                free((char *) iterator.value);
-            }
-            hashMapDelete(valueMap);
+        resultSetFinishStatement(resultSet);
+        if (resultSet->statement != NULL) {
+            sqliteStatementRelease(resultSet->statement);
+        } else {
+            sqlite3_finalize(resultSet->finishedStmt);
+        }
+        if (resultSet->releaseCallback != NULL) {
+            resultSet->releaseCallback(resultSet->releaseContext, resultSet->db);
         }
-        vectorDelete(resultSet->valueVec);
-        hashMapDelete(resultSet->columnMap);
-        free(resultSet);
+        if (resultSet->columnMap != NULL && !resultSet->isColumnMapShared) {
+            hashMapDelete(resultSet->columnMap);
+        }
+        sqliteArenaFree(resultSet->arena, resultSet->columnNames);
+        sqliteArenaFree(resultSet->arena, resultSet->valueOffsets);
+        sqliteArenaFree(resultSet->arena, resultSet->valueArena);
+        sqliteArenaFree(resultSet->arena, resultSet);
     }
 }
 
@@ -149,29 +257,103 @@ static ResultSet *mapColumnNames(ResultSet *resultSet) {
     return resultSet;
 }
 
-static inline char *getValueStrFromRsVecByName(ResultSet *resultSet, const char *columnName) {
-    HashMap valueMap = vectorGet(resultSet->valueVec, resultSet->valueIndex);
-    return (char *) hashMapGet(valueMap, columnName);
+// Column names are copied once to the single block: pointers followed by name strings
+static bool mapCallbackColumnNames(ResultSet *resultSet, int columnCount, char **columnNames) {
+    size_t namesSize = 0;
+    for (int i = 0; i < columnCount; i++) {
+        namesSize += strlen(columnNames[i]) + 1;
+    }
+
+    char **names = sqliteArenaAlloc(resultSet->arena, sizeof(char *) * columnCount + namesSize);
+    resultSet->columnMap = getHashMapInstance(columnCount * 2);
+    if (names == NULL || resultSet->columnMap == NULL) {
+        sqliteArenaFree(resultSet->arena, names);
+        if (resultSet->columnMap != NULL) {
+            hashMapDelete(resultSet->columnMap);
+            resultSet->columnMap = NULL;
+        }
+        return false;
+    }
+
+    char *namePtr = (char *) (names + columnCount);
+    for (int i = 0; i < columnCount; i++) {
+        size_t nameSize = strlen(columnNames[i]) + 1;
+        memcpy(namePtr, columnNames[i], nameSize);
+        names[i] = namePtr;
+        hashMapPut(resultSet->columnMap, names[i], (MapValueType) (long) i);
+        namePtr += nameSize;
+    }
+
+    resultSet->columnNames = names;
+    resultSet->columnCount = (uint32_t) columnCount;
+    return true;
 }
 
-static inline char *getValueStrFromRsVecByIndex(ResultSet *resultSet, int columnIndex) {
-    HashMap valueMap = vectorGet(resultSet->valueVec, resultSet->valueIndex);
-    return (char *) hashMapGet(valueMap, getColumnNameByIndex(resultSet, columnIndex));
+static bool ensureArenaCapacity(ResultSet *resultSet, uint32_t size) {
+    if (size <= resultSet->arenaCapacity) return true;
+    uint32_t newCapacity = resultSet->arenaCapacity > 0 ? resultSet->arenaCapacity * 2 : SQLITE_RESULT_SET_ARENA_SIZE;
+    while (newCapacity < size) {
+        if (newCapacity > UINT32_MAX / 2) return false;    // offsets are 32 bit
+        newCapacity *= 2;
+    }
+
+    char *arena = sqliteArenaRealloc(resultSet->arena, resultSet->valueArena, resultSet->arenaCapacity, newCapacity);
+    if (arena == NULL) return false;
+    resultSet->valueArena = arena;
+    resultSet->arenaCapacity = newCapacity;
+    return true;
 }
 
-static inline int getIndexByColumnName(ResultSet *resultSet, const char *columnName) {
-    MapEntry *entry = hashMapGetEntry(resultSet->columnMap, columnName);
-    return entry != NULL ? (long) entry->value : NO_VALUE_INDEX;
+static bool ensureOffsetCapacity(ResultSet *resultSet, uint32_t size) {
+    if (size <= resultSet->offsetCapacity) return true;
+    uint32_t newCapacity = resultSet->offsetCapacity > 0 ? resultSet->offsetCapacity * 2 : resultSet->columnCount * 16;
+    while (newCapacity < size) {
+        if (newCapacity > UINT32_MAX / 2) return false;    // offsets are 32 bit
+        newCapacity *= 2;
+    }
+
+    uint32_t *offsets = sqliteArenaRealloc(resultSet->arena, resultSet->valueOffsets, sizeof(uint32_t) * resultSet->offsetCapacity, sizeof(uint32_t) * newCapacity);
+    if (offsets == NULL) return false;
+    resultSet->valueOffsets = offsets;
+    resultSet->offsetCapacity = newCapacity;
+    return true;
 }
 
-static char *getColumnNameByIndex(ResultSet *resultSet, int columnIndex) {
-    HashMapIterator iterator = getHashMapIterator(resultSet->columnMap);
-    while (hashMapHasNext(&iterator)) {
-        if ((int) iterator.value == columnIndex) {
-            return (char *) iterator.key;
-        }
+static inline const char *getValueStrFromArenaByName(ResultSet *resultSet, const char *columnName) {
+    if (resultSet->columnMap == NULL) return NULL;  // empty result
+    return getValueStrFromArenaByIndex(resultSet, getIndexByColumnName(resultSet, columnName));
+}
+
+static inline const char *getValueStrFromArenaByIndex(ResultSet *resultSet, int columnIndex) {
+    if (resultSet->valueIndex < 0 || columnIndex < 0 || (uint32_t) columnIndex >= resultSet->columnCount) {
+        return NULL;
     }
-    return "";
+    uint32_t offset = resultSet->valueOffsets[resultSet->valueIndex * resultSet->columnCount + columnIndex];
+    return offset != NULL_VALUE_OFFSET ? resultSet->valueArena + offset : NULL;
+}
+
+static inline uint32_t getValueLengthFromArena(ResultSet *resultSet, const char *value) {
+    if (value == NULL) return 0;
+    uint32_t length;
+    memcpy(&length, value - VALUE_LENGTH_SIZE, VALUE_LENGTH_SIZE);     // arena offsets are not aligned
+    return length;
+}
+
+static inline DbValueType getValueTypeFromArena(const char *value) {
+    return value != NULL ? (DbValueType) value[-(int) VALUE_HEADER_SIZE] : DB_VALUE_NULL;
+}
+
+static inline int64_t valueStrToI64(const char *value) {
+    return value != NULL ? strtoimax(value, NULL, 10) : 0;
+}
+
+static inline double valueStrToDouble(const char *value) {
+    return value != NULL ? strtod(value, NULL) : 0.0;
+}
+
+static inline int getIndexByColumnName(ResultSet *resultSet, const char *columnName) {
+    MapEntry *entry = hashMapGetEntry(resultSet->columnMap, columnName);
+    return entry != NULL ? (long) entry->value : NO_VALUE_INDEX;
 }
 
 static const char *resultSetGetColumnName(ResultSet *resultSet, int column) {
@@ -181,3 +363,30 @@ static const char *resultSetGetColumnName(ResultSet *resultSet, int column) {
 static int resultSetColumnCount(ResultSet *resultSet) {
     return sqlite3_column_count(resultSet->stmt);
 }
+
+// Statement is kept until result set is deleted, so column map stays valid after the last row
+static void resultSetFinishStatement(ResultSet *resultSet) {
+    if (resultSet->stmt == NULL) return;
+    if (resultSet->statement != NULL) {
+        sqliteStatementFinish(resultSet->statement);
+    } else {
+        sqlite3_reset(resultSet->stmt);
+        resultSet->finishedStmt = resultSet->stmt;
+    }
+    resultSet->stmt = NULL;
+}
+
+static bool stepResultSet(ResultSet *resultSet) {
+    bool isFirstStep = resultSet->stepResult == SQLITE_OK;
+    int rc = resultSet->statement != NULL ? sqliteStatementStep(resultSet->statement) : sqlite3_step(resultSet->stmt);
+    resultSet->stepResult = rc;
+    if (rc == SQLITE_ROW) {
+        if (isFirstStep && resultSet->isColumnMapShared) {     // statement is re-prepared by first step after schema change
+            resultSet->columnMap = sqliteStatementColumnMap(resultSet->statement);
+        }
+        return true;
+    }
+    resultSet->stepResult = sqliteDeadlineResult(resultSet->db, rc);
+    resultSetFinishStatement(resultSet);
+    return false;
+}
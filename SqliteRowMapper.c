@@ -0,0 +1,275 @@
+#include "SqliteRowMapper.h"
+
+static int resolveFieldColumns(ResultSet *resultSet, const RowMapping *mapping, int *columns);
+static bool isFieldColumnsCached(SqliteStatement *statement, const RowMapping *mapping);
+static void cacheFieldColumns(ResultSet *resultSet, const RowMapping *mapping, const int *columns);
+static int mapCurrentRow(ResultSet *resultSet, const RowMapping *mapping, const int *columns, char *row, SqliteArena *arena);
+static void mapCursorField(sqlite3_stmt *stmt, const RowField *field, int column, char *target);
+static void mapCallbackField(ResultSet *resultSet, const RowField *field, int column, char *target);
+static bool mapTextField(const RowField *field, const char *value, uint32_t length, char *target, SqliteArena *arena);
+static int bindStructField(sqlite3_stmt *stmt, int paramIndex, const RowField *field, const char *source);
+
+
+int rsMapRows(ResultSet *resultSet, const RowMapping *mapping, void *rows, uint32_t maxRows, SqliteArena *arena, uint32_t *rowCount) {
+    *rowCount = 0;
+    if (resultSet == NULL || mapping == NULL || rows == NULL) return SQLITE_MISUSE;
+    if (resultSet->columnMap == NULL) return SQLITE_OK;     // no rows or cursor is already closed
+    int columns[SQLITE_ROW_MAPPER_MAX_FIELDS];
+    int rc = resolveFieldColumns(resultSet, mapping, columns);
+
+    char *row = rows;
+    while (rc == SQLITE_OK && *rowCount < maxRows && nextResultSet(resultSet)) {
+        rc = mapCurrentRow(resultSet, mapping, columns, row, arena);
+        if (rc == SQLITE_OK) {
+            (*rowCount)++;
+            row += mapping->structSize;
+        }
+    }
+    int stepResult = resultSet->stepResult;   // callback result set is never stepped
+    if (rc == SQLITE_OK && stepResult != SQLITE_OK && stepResult != SQLITE_ROW && stepResult != SQLITE_DONE) {
+        rc = stepResult;
+    }
+    return rc;
+}
+
+int rsMapRow(ResultSet *resultSet, const RowMapping *mapping, void *row, SqliteArena *arena) {
+    if (resultSet == NULL || mapping == NULL || row == NULL) return SQLITE_MISUSE;
+    int columns[SQLITE_ROW_MAPPER_MAX_FIELDS];
+    int rc = resolveFieldColumns(resultSet, mapping, columns);
+    return rc == SQLITE_OK ? mapCurrentRow(resultSet, mapping, columns, row, arena) : rc;
+}
+
+void freeMappedRows(const RowMapping *mapping, void *rows, uint32_t rowCount) {
+    if (mapping == NULL || rows == NULL) return;
+    char *row = rows;
+    for (uint32_t i = 0; i < rowCount; i++, row += mapping->structSize) {
+        for (uint32_t j = 0; j < mapping->fieldCount; j++) {
+            const RowField *field = &mapping->fields[j];
+            if (field->type == ROW_FIELD_STR) {
+                char **value = (char **) (row + field->offset);
+                free(*value);
+                *value = NULL;
+            }
+        }
+    }
+}
+
+int sqliteStructBindingInit(StructBinding *binding, SqliteStatement *statement, const RowMapping *mapping) {
+    if (binding == NULL || statement == NULL || mapping == NULL) return SQLITE_MISUSE;
+    uint32_t paramCount = (uint32_t) sqlite3_bind_parameter_count(statement->stmt);  // can be lower for multi statement sql
+    if (paramCount > getVectorSize(statement->paramNames)) {
+        paramCount = getVectorSize(statement->paramNames);
+    }
+    if (paramCount > SQLITE_ROW_MAPPER_MAX_FIELDS) return SQLITE_RANGE;
+
+    binding->mapping = mapping;
+    binding->paramCount = paramCount;
+    for (uint32_t i = 0; i < paramCount; i++) {
+        const char *paramName = vectorGet(statement->paramNames, i);
+        binding->fieldIndexes[i] = -1;
+        for (uint32_t j = 0; j < mapping->fieldCount; j++) {
+            if (strcmp(paramName, mapping->fields[j].columnName) == 0) {
+                binding->fieldIndexes[i] = (int) j;
+                break;
+            }
+        }
+    }
+    return SQLITE_OK;
+}
+
+int sqliteStatementBindStruct(SqliteStatement *statement, const StructBinding *binding, const void *row) {
+    if (statement == NULL || binding == NULL || row == NULL) return SQLITE_MISUSE;
+    for (uint32_t i = 0; i < binding->paramCount; i++) {
+        int fieldIndex = binding->fieldIndexes[i];
+        int rc = fieldIndex >= 0
+                 ? bindStructField(statement->stmt, (int) (i + 1), &binding->mapping->fields[fieldIndex], row)
+                 : sqlite3_bind_null(statement->stmt, (int) (i + 1));
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    return SQLITE_OK;
+}
+
+// Indexes are cached on wrapped statement for last used mapping, so cached statement resolves names once.
+// First lookup steps cursor to the first row, then re-prepare counter shows whether columns can differ
+static int resolveFieldColumns(ResultSet *resultSet, const RowMapping *mapping, int *columns) {
+    if (mapping->fieldCount > SQLITE_ROW_MAPPER_MAX_FIELDS) return SQLITE_RANGE;
+    for (uint32_t i = 0; i < mapping->fieldCount; i++) {
+        columns[i] = rsColumnIndex(resultSet, mapping->fields[i].columnName);
+        if (columns[i] < 0) return SQLITE_RANGE;
+
+        SqliteStatement *statement = resultSet->statement;
+        if (i > 0 || statement == NULL || resultSet->stmt == NULL) continue;
+        if (isFieldColumnsCached(statement, mapping)) {
+            memcpy(columns, statement->mappingColumns, sizeof(int) * mapping->fieldCount);
+            return SQLITE_OK;
+        }
+    }
+    cacheFieldColumns(resultSet, mapping, columns);
+    return SQLITE_OK;
+}
+
+// Fields array of stack or reused buffer can have the same address with other names, so cached column names are compared too
+static bool isFieldColumnsCached(SqliteStatement *statement, const RowMapping *mapping) {
+    if (statement->mappingKey != mapping->fields || statement->mappingFieldCount != mapping->fieldCount ||
+        statement->mappingPrepareCount != sqlite3_stmt_status(statement->stmt, SQLITE_STMTSTATUS_REPREPARE, 0)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < mapping->fieldCount; i++) {
+        const char *columnName = sqlite3_column_name(statement->stmt, statement->mappingColumns[i]);
+        if (columnName == NULL || strcmp(columnName, mapping->fields[i].columnName) != 0) return false;
+    }
+    return true;
+}
+
+static void cacheFieldColumns(ResultSet *resultSet, const RowMapping *mapping, const int *columns) {
+    SqliteStatement *statement = resultSet->statement;
+    if (statement == NULL || resultSet->stmt == NULL || mapping->fieldCount == 0) return;
+    int *mappingColumns = realloc(statement->mappingColumns, sizeof(int) * mapping->fieldCount);
+    if (mappingColumns == NULL) return;     // resolved again next time
+    memcpy(mappingColumns, columns, sizeof(int) * mapping->fieldCount);
+    statement->mappingColumns = mappingColumns;
+    statement->mappingKey = mapping->fields;     // mapping itself can be temporary, field names are checked on hit
+    statement->mappingFieldCount = mapping->fieldCount;
+    statement->mappingPrepareCount = sqlite3_stmt_status(statement->stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+}
+
+// Row is cleared first, so partially mapped row can be released on error
+static int mapCurrentRow(ResultSet *resultSet, const RowMapping *mapping, const int *columns, char *row, SqliteArena *arena) {
+    memset(row, 0, mapping->structSize);
+    sqlite3_stmt *stmt = resultSet->stmt;
+    for (uint32_t i = 0; i < mapping->fieldCount; i++) {
+        const RowField *field = &mapping->fields[i];
+        char *target = row + field->offset;
+        if (field->type < ROW_FIELD_STR) {
+            if (stmt != NULL) {
+                mapCursorField(stmt, field, columns[i], target);
+            } else {
+                mapCallbackField(resultSet, field, columns[i], target);
+            }
+            continue;
+        }
+
+        const char *value;
+        uint32_t length;
+        if (stmt != NULL) {
+            value = (const char *) sqlite3_column_text(stmt, columns[i]);
+            length = (uint32_t) sqlite3_column_bytes(stmt, columns[i]);     // called after text, no conversion
+        } else {
+            value = rsGetStringByIndex(resultSet, columns[i]);
+            length = value != NULL ? (uint32_t) strlen(value) : 0;
+        }
+        if (!mapTextField(field, value, length, target, arena)) {
+            if (arena == NULL) {
+                freeMappedRows(mapping, row, 1);
+            }
+            return SQLITE_NOMEM;
+        }
+    }
+    return SQLITE_OK;
+}
+
+// Direct column access for prepared statement cursor, no name lookup and getter dispatch
+static void mapCursorField(sqlite3_stmt *stmt, const RowField *field, int column, char *target) {
+    switch (field->type) {
+        case ROW_FIELD_BOOL:
+            *(bool *) target = sqlite3_column_int64(stmt, column) != 0;
+            break;
+        case ROW_FIELD_INT:
+            *(int *) target = sqlite3_column_int(stmt, column);
+            break;
+        case ROW_FIELD_U32:
+            *(uint32_t *) target = (uint32_t) sqlite3_column_int64(stmt, column);
+            break;
+        case ROW_FIELD_I64:
+            *(int64_t *) target = sqlite3_column_int64(stmt, column);
+            break;
+        case ROW_FIELD_FLOAT:
+            *(float *) target = (float) sqlite3_column_double(stmt, column);
+            break;
+        case ROW_FIELD_DOUBLE:
+            *(double *) target = sqlite3_column_double(stmt, column);
+            break;
+        default:
+            break;
+    }
+}
+
+static void mapCallbackField(ResultSet *resultSet, const RowField *field, int column, char *target) {
+    switch (field->type) {
+        case ROW_FIELD_BOOL:
+            *(bool *) target = rsGetI64ByIndex(resultSet, column) != 0;
+            break;
+        case ROW_FIELD_INT:
+            *(int *) target = rsGetIntByIndex(resultSet, column);
+            break;
+        case ROW_FIELD_U32:
+            *(uint32_t *) target = (uint32_t) rsGetI64ByIndex(resultSet, column);
+            break;
+        case ROW_FIELD_I64:
+            *(int64_t *) target = rsGetI64ByIndex(resultSet, column);
+            break;
+        case ROW_FIELD_FLOAT:
+            *(float *) target = (float) rsGetDoubleByIndex(resultSet, column);
+            break;
+        case ROW_FIELD_DOUBLE:
+            *(double *) target = rsGetDoubleByIndex(resultSet, column);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool mapTextField(const RowField *field, const char *value, uint32_t length, char *target, SqliteArena *arena) {
+    if (field->type == ROW_FIELD_TEXT) {
+        if (field->size == 0) return true;
+        if (length >= field->size) {
+            length = field->size - 1;
+            while (length > 0 && ((unsigned char) value[length] & 0xC0) == 0x80) {   // don't split UTF-8 sequence
+                length--;
+            }
+        }
+        if (length > 0) {
+            memcpy(target, value, length);
+        }
+        target[length] = '\0';
+        return true;
+    }
+
+    if (value == NULL) return true;     // pointer is already cleared
+    char *copy = sqliteArenaAlloc(arena, length + 1);
+    if (copy == NULL) return false;
+    memcpy(copy, value, length);
+    copy[length] = '\0';
+    *(char **) target = copy;
+    return true;
+}
+
+static int bindStructField(sqlite3_stmt *stmt, int paramIndex, const RowField *field, const char *source) {
+    const char *value = source + field->offset;
+    switch (field->type) {
+        case ROW_FIELD_BOOL:
+            return sqlite3_bind_int(stmt, paramIndex, *(const bool *) value ? 1 : 0);
+        case ROW_FIELD_INT:
+            return sqlite3_bind_int(stmt, paramIndex, *(const int *) value);
+        case ROW_FIELD_U32:
+            return sqlite3_bind_int64(stmt, paramIndex, *(const uint32_t *) value);
+        case ROW_FIELD_I64:
+            return sqlite3_bind_int64(stmt, paramIndex, *(const int64_t *) value);
+        case ROW_FIELD_FLOAT:
+            return sqlite3_bind_double(stmt, paramIndex, *(const float *) value);
+        case ROW_FIELD_DOUBLE:
+            return sqlite3_bind_double(stmt, paramIndex, *(const double *) value);
+        case ROW_FIELD_STR: {
+            const char *str = *(const char *const *) value;
+            return str != NULL ? sqlite3_bind_text(stmt, paramIndex, str, -1, SQLITE_STATIC) : sqlite3_bind_null(stmt, paramIndex);
+        }
+        case ROW_FIELD_TEXT: {
+            const char *end = memchr(value, '\0', field->size);    // array can be filled without terminator
+            return sqlite3_bind_text(stmt, paramIndex, value, end != NULL ? (int) (end - value) : (int) field->size, SQLITE_STATIC);
+        }
+        default:
+            return SQLITE_MISUSE;
+    }
+}
@@ -0,0 +1,257 @@
+#include "SqliteSchemaCache.h"
+
+#define TABLE_INFO_SQL "SELECT name, type, \"notnull\", pk FROM pragma_table_info(?1, ?2)"
+#define INDEX_LIST_SQL "SELECT name FROM pragma_index_list(?1, ?2)"
+#define DEFAULT_TABLE_COUNT 8
+
+static bool isSchemaChanged(SchemaCache *cache);
+static bool trackTableSchema(SchemaCache *cache, const char *tableName);
+static bool trackSchema(SchemaCache *cache, const char *schemaName, size_t nameLength);
+static int readSchemaVersion(sqlite3_stmt *stmt);
+static bool loadColumns(sqlite3 *db, SchemaTable *table);
+static bool loadIndexes(sqlite3 *db, SchemaTable *table);
+static sqlite3_stmt *prepareTableQuery(sqlite3 *db, const char *sql, const char *tableName);
+static char *copyColumnText(sqlite3_stmt *stmt, int column);
+
+
+SchemaCache *newSchemaCache(sqlite3 *db) {
+    SchemaCache *cache = calloc(1, sizeof(struct SchemaCache));
+    if (cache == NULL) return NULL;
+    cache->db = db;
+    cache->tableMap = getHashMapInstance(DEFAULT_TABLE_COUNT * 2);
+    cache->tables = getVectorInstance(DEFAULT_TABLE_COUNT);
+    if (cache->tableMap == NULL || cache->tables == NULL) {
+        deleteSchemaCache(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+const SchemaTable *schemaCacheGetTable(SchemaCache *cache, const char *tableName) {
+    if (cache == NULL || tableName == NULL) return NULL;
+    if (isSchemaChanged(cache)) {
+        schemaCacheClear(cache);
+    }
+    if (cache->tableMap == NULL && (cache->tableMap = getHashMapInstance(DEFAULT_TABLE_COUNT * 2)) == NULL) {
+        return NULL;
+    }
+
+    MapEntry *entry = hashMapGetEntry(cache->tableMap, tableName);
+    if (entry != NULL) {
+        return (const SchemaTable *) entry->value;
+    }
+
+    bool isTracked = trackTableSchema(cache, tableName);    // version is read before table, so concurrent change is not missed
+    SchemaTable *table = newSchemaTable(cache->db, tableName);
+    if (table == NULL) return NULL;
+    if (table->columnCount == 0 || !isTracked) {    // misses are not cached, so lookups of arbitrary names don't grow the cache
+        deleteSchemaTable(cache->missingTable);
+        cache->missingTable = table;
+        return table;
+    }
+    vectorAdd(cache->tables, table);
+    hashMapPut(cache->tableMap, table->name, (MapValueType) table);
+    return table;
+}
+
+int schemaTableColumnIndex(const SchemaTable *table, const char *columnName) {
+    if (table == NULL || table->columnMap == NULL || columnName == NULL) return -1;
+    MapEntry *entry = hashMapGetEntry(table->columnMap, columnName);
+    return entry != NULL ? (int) (long) entry->value : -1;
+}
+
+SchemaTable *newSchemaTable(sqlite3 *db, const char *tableName) {
+    if (db == NULL || tableName == NULL) return NULL;
+    SchemaTable *table = calloc(1, sizeof(struct SchemaTable));
+    if (table == NULL) return NULL;
+    table->name = strdup(tableName);
+    if (table->name == NULL || !loadColumns(db, table) || !loadIndexes(db, table)) {
+        deleteSchemaTable(table);
+        return NULL;
+    }
+    return table;
+}
+
+void deleteSchemaTable(SchemaTable *table) {
+    if (table != NULL) {
+        for (uint32_t i = 0; i < table->columnCount; i++) {
+            free(table->columns[i].name);
+            free(table->columns[i].declaredType);
+        }
+        for (uint32_t i = 0; i < table->indexCount; i++) {
+            free(table->indexNames[i]);
+        }
+        if (table->columnMap != NULL) {
+            hashMapDelete(table->columnMap);
+        }
+        free(table->columns);
+        free(table->indexNames);
+        free(table->name);
+        free(table);
+    }
+}
+
+void schemaCacheClear(SchemaCache *cache) {
+    if (cache == NULL) return;
+    for (uint32_t i = 0; i < getVectorSize(cache->tables); i++) {
+        deleteSchemaTable(vectorGet(cache->tables, i));
+    }
+    vectorClear(cache->tables);
+    deleteSchemaTable(cache->missingTable);
+    cache->missingTable = NULL;
+    if (cache->tableMap != NULL) {
+        hashMapDelete(cache->tableMap);
+    }
+    cache->tableMap = getHashMapInstance(DEFAULT_TABLE_COUNT * 2);     // recreated on next lookup if allocation fails
+}
+
+void deleteSchemaCache(SchemaCache *cache) {
+    if (cache != NULL) {
+        for (uint32_t i = 0; i < getVectorSize(cache->tables); i++) {
+            deleteSchemaTable(vectorGet(cache->tables, i));
+        }
+        vectorDelete(cache->tables);
+        deleteSchemaTable(cache->missingTable);
+        if (cache->tableMap != NULL) {
+            hashMapDelete(cache->tableMap);
+        }
+        for (uint32_t i = 0; i < cache->schemaCount; i++) {
+            sqlite3_finalize(cache->schemas[i].stmt);
+            free(cache->schemas[i].schemaName);
+        }
+        free(cache->schemas);
+        free(cache);
+    }
+}
+
+// Detached schema is changed once, then its tables are already dropped
+static bool isSchemaChanged(SchemaCache *cache) {
+    bool isChanged = false;
+    for (uint32_t i = 0; i < cache->schemaCount; i++) {
+        SchemaVersion *schema = &cache->schemas[i];
+        int version = readSchemaVersion(schema->stmt);
+        if (version != schema->version) {
+            schema->version = version;
+            isChanged = true;
+        }
+    }
+    return isChanged;
+}
+
+// Unqualified name is resolved in 'temp' before 'main', so new temp table hides cached one
+static bool trackTableSchema(SchemaCache *cache, const char *tableName) {
+    const char *separator = strchr(tableName, '.');
+    if (separator != NULL) {
+        return trackSchema(cache, tableName, (size_t) (separator - tableName));
+    }
+    return trackSchema(cache, "main", 4) && trackSchema(cache, "temp", 4);
+}
+
+static bool trackSchema(SchemaCache *cache, const char *schemaName, size_t nameLength) {
+    for (uint32_t i = 0; i < cache->schemaCount; i++) {
+        SchemaVersion *schema = &cache->schemas[i];
+        if (sqlite3_strnicmp(schema->schemaName, schemaName, (int) nameLength) == 0 && schema->schemaName[nameLength] == '\0') {
+            return schema->version >= 0;
+        }
+    }
+
+    SchemaVersion *schemas = realloc(cache->schemas, sizeof(SchemaVersion) * (cache->schemaCount + 1));
+    if (schemas == NULL) return false;
+    cache->schemas = schemas;
+    SchemaVersion *schema = &schemas[cache->schemaCount];
+    *schema = (SchemaVersion) {.schemaName = malloc(nameLength + 1), .version = -1};
+    char *sql = NULL;
+    if (schema->schemaName != NULL) {
+        memcpy(schema->schemaName, schemaName, nameLength);
+        schema->schemaName[nameLength] = '\0';
+        sql = sqlite3_mprintf("PRAGMA \"%w\".schema_version", schema->schemaName);
+    }
+    if (sql == NULL || sqlite3_prepare_v2(cache->db, sql, -1, &schema->stmt, NULL) != SQLITE_OK) {
+        sqlite3_free(sql);
+        sqlite3_finalize(schema->stmt);
+        free(schema->schemaName);
+        return false;   // not attached schema is not tracked, its tables are not cached
+    }
+    sqlite3_free(sql);
+    schema->version = readSchemaVersion(schema->stmt);
+    cache->schemaCount++;
+    return schema->version >= 0;
+}
+
+static int readSchemaVersion(sqlite3_stmt *stmt) {
+    int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_reset(stmt);
+    return version;
+}
+
+static bool loadColumns(sqlite3 *db, SchemaTable *table) {
+    sqlite3_stmt *stmt = prepareTableQuery(db, TABLE_INFO_SQL, table->name);
+    if (stmt == NULL) return false;
+
+    uint32_t capacity = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (table->columnCount == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 8;
+            SchemaColumn *columns = realloc(table->columns, sizeof(SchemaColumn) * capacity);
+            if (columns == NULL) break;
+            table->columns = columns;
+        }
+
+        SchemaColumn *column = &table->columns[table->columnCount];
+        column->name = copyColumnText(stmt, 0);
+        column->declaredType = copyColumnText(stmt, 1);
+        column->isNotNull = sqlite3_column_int(stmt, 2) != 0;
+        column->isPrimaryKey = sqlite3_column_int(stmt, 3) != 0;
+        table->columnCount++;
+        if (column->name == NULL || column->declaredType == NULL) break;
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) return false;
+
+    table->columnMap = getHashMapInstance(table->columnCount * 2 + 1);
+    if (table->columnMap == NULL) return false;
+    for (uint32_t i = 0; i < table->columnCount; i++) {
+        hashMapPut(table->columnMap, table->columns[i].name, (MapValueType) (long) i);
+    }
+    return true;
+}
+
+static bool loadIndexes(sqlite3 *db, SchemaTable *table) {
+    sqlite3_stmt *stmt = prepareTableQuery(db, INDEX_LIST_SQL, table->name);
+    if (stmt == NULL) return false;
+
+    uint32_t capacity = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (table->indexCount == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 4;
+            char **indexNames = realloc(table->indexNames, sizeof(char *) * capacity);
+            if (indexNames == NULL) break;
+            table->indexNames = indexNames;
+        }
+        table->indexNames[table->indexCount] = copyColumnText(stmt, 0);
+        if (table->indexNames[table->indexCount++] == NULL) break;
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+// Table name is bound, so it doesn't need quoting. Name can be qualified as 'schema.table', schema is bound separately
+static sqlite3_stmt *prepareTableQuery(sqlite3 *db, const char *sql, const char *tableName) {
+    sqlite3_stmt *stmt = NULL;
+    const char *separator = strchr(tableName, '.');
+    const char *name = separator != NULL ? separator + 1 : tableName;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK ||
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC) != SQLITE_OK ||
+        (separator != NULL && sqlite3_bind_text(stmt, 2, tableName, (int) (separator - tableName), SQLITE_STATIC) != SQLITE_OK)) {
+        sqlite3_finalize(stmt);
+        return NULL;
+    }
+    return stmt;
+}
+
+static char *copyColumnText(sqlite3_stmt *stmt, int column) {
+    const char *text = (const char *) sqlite3_column_text(stmt, column);
+    return strdup(text != NULL ? text : "");
+}
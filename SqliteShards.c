@@ -0,0 +1,680 @@
+#include <ctype.h>
+#include "SqliteWrapper.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+#define NO_LIMIT (-1)
+#define MAX_QUERY_DEPTH 64
+#define SHARD_NUMBER_BUFFER_SIZE 32
+
+// Aggregate of each shard rows can't be merged, min() and max() with several arguments are scalar functions
+static const char *const AGGREGATE_FUNCTIONS[] = {"count", "sum", "min", "max", "avg", "total", "group_concat"};
+
+typedef struct ShardOrderTerm {
+    const char *name;       // points to query sql
+    uint32_t length;
+    int column;             // resolved result column index
+    bool isDescending;
+} ShardOrderTerm;
+
+typedef struct ShardQueryPlan {
+    ShardOrderTerm terms[SQLITE_SHARDS_MAX_ORDER_TERMS];
+    uint32_t termCount;     // 0 - rows are concatenated
+    int64_t limit;
+} ShardQueryPlan;
+
+// Buffers to copy current row of shard cursor with types
+typedef struct ShardRow {
+    int columnCount;
+    char **names;
+    char **values;
+    uint32_t *lengths;
+    DbValueType *types;
+    char *numbers;          // doubles formatted with round trip precision
+} ShardRow;
+
+// Single shard part of fan out query, executed on own thread
+typedef struct ShardTask {
+    SqlitePool *pool;
+    const char *sql;
+    str_DbValueMap *queryParams;
+    bool isOrdered;
+    int64_t limit;                  // unordered shard doesn't copy more rows than merged result has
+    sqlite3 *reader;
+    SqliteStatement *statement;     // query cursor, ordered one is positioned on first row
+    ResultSet *rows;                // unordered query rows, NULL if there are no rows
+    int rc;
+    pthread_t thread;
+    bool isThreadStarted;
+} ShardTask;
+
+static void *runShardTask(void *arg);
+static int prepareShardTask(ShardTask *task);
+static void executeShardTask(ShardTask *task);
+static int copyShardRows(ShardTask *task);
+static int initShardRow(ShardRow *row, sqlite3_stmt *stmt);
+static bool appendShardRow(ShardRow *row, sqlite3_stmt *stmt, ResultSet *output);
+static int mergeOrderedRows(ShardTask *tasks, uint32_t taskCount, const ShardQueryPlan *plan, ResultSet *output);
+static int concatShardRows(ShardTask *tasks, uint32_t taskCount, const ShardQueryPlan *plan, ResultSet *output);
+static int compareShardRows(sqlite3_stmt *first, sqlite3_stmt *second, const ShardQueryPlan *plan);
+static int compareColumnValues(sqlite3_stmt *first, sqlite3_stmt *second, int column);
+static int resolveOrderColumns(ShardQueryPlan *plan, sqlite3_stmt *stmt);
+static bool isBinaryCollation(sqlite3_stmt *stmt, int column);
+
+static int parseShardQuery(const char *sql, str_DbValueMap *queryParams, ShardQueryPlan *plan);
+static int parseOrderTerms(const char *start, const char *end, ShardQueryPlan *plan);
+static int parseLimit(const char *start, str_DbValueMap *queryParams, int64_t *limit);
+static bool isMergeUnsupportedAt(const char *sql, const char *position);
+static bool isRowSourceAt(const char *sql, const char *position, bool isFromClause);
+static bool isClauseStartAt(const char *sql, const char *position);
+static bool isAggregateCallAt(const char *sql, const char *position);
+static const char *skipQuoted(const char *sql);
+static const char *skipSpaces(const char *sql);
+static bool isWordAt(const char *sql, const char *position, const char *word);
+static bool isIdentifierChar(char c);
+
+static uint32_t hashKeyBytes(const uint8_t *bytes, size_t length);
+static uint32_t hashKeyInt(uint64_t value);
+static int taskErrorCode(sqlite3 *db);
+
+
+SqliteShards *newSqliteShards(const char *const *dbNames, uint32_t shardCount, const char *keyParam, const ShardOptions *options) {
+    if (dbNames == NULL || shardCount < 1 || shardCount > SQLITE_SHARDS_MAX_COUNT || keyParam == NULL) return NULL;
+    SqliteShards *shards = calloc(1, sizeof(struct SqliteShards));
+    if (shards == NULL) return NULL;
+    shards->pools = calloc(shardCount, sizeof(SqlitePool *));
+    shards->keyParam = strdup(keyParam);
+    shards->shardCount = shardCount;
+    if (shards->pools == NULL || shards->keyParam == NULL) {
+        deleteSqliteShards(shards);
+        return NULL;
+    }
+
+    SqliteOpenOptions defaultOptions = {.busyTimeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS};
+    const SqliteOpenOptions *openOptions = options != NULL && options->openOptions != NULL ? options->openOptions : &defaultOptions;
+    uint32_t readerCount = options != NULL && options->readersPerShard > 0 ? options->readersPerShard : SQLITE_SHARDS_READERS;
+    if ((uint64_t) shardCount * ((uint64_t) readerCount + 1) > SQLITE_MAX_CONNECTIONS) {
+        deleteSqliteShards(shards);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < shardCount; i++) {
+        shards->pools[i] = newSqlitePoolWithOptions(dbNames[i], readerCount, openOptions);
+        if (shards->pools[i] == NULL) {
+            deleteSqliteShards(shards);
+            return NULL;
+        }
+    }
+    return shards;
+}
+
+uint32_t shardsKeyIndex(SqliteShards *shards, DbValue key) {
+    if (shards == NULL) return 0;
+    uint32_t hash = 0;
+    switch (key.type) {
+        case DB_VALUE_INT:
+            hash = hashKeyInt((uint64_t) key.as.intValue);
+            break;
+        case DB_VALUE_REAL: {
+            uint64_t bits;
+            memcpy(&bits, &key.as.doubleValue, sizeof(bits));
+            hash = hashKeyInt(bits);
+            break;
+        }
+        case DB_VALUE_TEXT:
+            hash = key.as.strValue != NULL ? hashKeyBytes((const uint8_t *) key.as.strValue, strlen(key.as.strValue)) : 0;
+            break;
+        case DB_VALUE_BLOB:
+            hash = key.as.blobValue != NULL ? hashKeyBytes(key.as.blobValue, key.length) : 0;
+            break;
+        default:
+            break;
+    }
+    return hash % shards->shardCount;
+}
+
+int shardsExecuteUpdate(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams) {
+    if (shards == NULL || sql == NULL || queryParams == NULL) return SQLITE_MISUSE;
+    DbValue key = str_DbValueMapGetOrDefault(queryParams, shards->keyParam, DB_NULL_VALUE());
+    if (key.type == DB_VALUE_NULL) return SQLITE_MISUSE;
+    return poolExecuteUpdate(shards->pools[shardsKeyIndex(shards, key)], sql, queryParams);
+}
+
+int shardsExecuteUpdateAll(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams) {
+    if (shards == NULL || sql == NULL) return SQLITE_MISUSE;
+    int rc = SQLITE_OK;
+    for (uint32_t i = 0; i < shards->shardCount && rc == SQLITE_OK; i++) {
+        rc = poolExecuteUpdate(shards->pools[i], sql, queryParams);
+    }
+    return rc;
+}
+
+ResultSet *shardsExecuteQuery(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams) {
+    if (shards == NULL || sql == NULL) return NULL;
+    DbValue key = queryParams != NULL ? str_DbValueMapGetOrDefault(queryParams, shards->keyParam, DB_NULL_VALUE()) : DB_NULL_VALUE();
+    if (key.type != DB_VALUE_NULL) {
+        return poolExecuteQuery(shards->pools[shardsKeyIndex(shards, key)], sql, queryParams);
+    }
+
+    ShardQueryPlan plan;
+    if (parseShardQuery(sql, queryParams, &plan) != SQLITE_OK) return NULL;
+    ShardTask tasks[SQLITE_SHARDS_MAX_COUNT];
+    for (uint32_t i = 0; i < shards->shardCount; i++) {
+        tasks[i] = (ShardTask) {.pool = shards->pools[i], .sql = sql, .queryParams = queryParams, .isOrdered = plan.termCount > 0,
+                               .limit = plan.limit};
+    }
+    if (plan.termCount > 0) {   // order is resolved on first shard statement before fan out, so unsupported order doesn't query shards
+        int rc = prepareShardTask(&tasks[0]);
+        if (rc == SQLITE_OK) {
+            rc = resolveOrderColumns(&plan, tasks[0].statement->stmt);
+        }
+        if (rc != SQLITE_OK) {
+            sqliteStatementRelease(tasks[0].statement);
+            sqlitePoolRelease(tasks[0].pool, tasks[0].reader);
+            return NULL;
+        }
+    }
+    for (uint32_t i = 1; i < shards->shardCount; i++) {
+        tasks[i].isThreadStarted = pthread_create(&tasks[i].thread, NULL, runShardTask, &tasks[i]) == 0;
+    }
+    executeShardTask(&tasks[0]);
+
+    int rc = SQLITE_OK;
+    for (uint32_t i = 0; i < shards->shardCount; i++) {
+        if (tasks[i].isThreadStarted) {
+            pthread_join(tasks[i].thread, NULL);
+        } else if (i > 0) {
+            executeShardTask(&tasks[i]);
+        }
+        if (rc == SQLITE_OK && tasks[i].rc != SQLITE_OK && tasks[i].rc != SQLITE_ROW && tasks[i].rc != SQLITE_DONE) {
+            rc = tasks[i].rc;
+        }
+    }
+
+    ResultSet *output = rc == SQLITE_OK ? newSqliteResultSet(NULL, NULL) : NULL;
+    if (output != NULL) {
+        rc = plan.termCount > 0 ? mergeOrderedRows(tasks, shards->shardCount, &plan, output) : concatShardRows(tasks, shards->shardCount, &plan, output);
+    }
+    for (uint32_t i = 0; i < shards->shardCount; i++) {
+        sqliteStatementRelease(tasks[i].statement);
+        resultSetDelete(tasks[i].rows);
+        sqlitePoolRelease(tasks[i].pool, tasks[i].reader);
+    }
+    if (rc != SQLITE_OK) {
+        resultSetDelete(output);
+        return NULL;
+    }
+    return output;
+}
+
+void deleteSqliteShards(SqliteShards *shards) {
+    if (shards != NULL) {
+        for (uint32_t i = 0; shards->pools != NULL && i < shards->shardCount; i++) {
+            deleteSqlitePool(shards->pools[i]);
+        }
+        free(shards->pools);
+        free(shards->keyParam);
+        free(shards);
+    }
+}
+
+static void *runShardTask(void *arg) {
+    executeShardTask((ShardTask *) arg);
+    return NULL;
+}
+
+// Reader and statement are released by caller after merge
+static int prepareShardTask(ShardTask *task) {
+    task->reader = sqlitePoolAcquireReader(task->pool);
+    if (task->reader == NULL) return SQLITE_MISUSE;
+    task->statement = sqliteAcquireStatement(task->reader, task->sql);
+    return task->statement != NULL ? SQLITE_OK : taskErrorCode(task->reader);
+}
+
+// First shard of ordered query is already prepared by caller
+static void executeShardTask(ShardTask *task) {
+    if (task->reader == NULL) {
+        task->rc = prepareShardTask(task);
+        if (task->rc != SQLITE_OK) return;
+    }
+    task->rc = sqliteStatementBind(task->statement, task->queryParams, false);
+    if (task->rc == SQLITE_OK) {
+        task->rc = sqliteStatementStep(task->statement);    // shard rows are sorted before first row is returned
+    }
+    if (!task->isOrdered && task->rc == SQLITE_ROW) {
+        task->rc = copyShardRows(task);     // on shard thread, so shards are read in parallel
+    }
+}
+
+// Cursor is positioned on first row, SQLITE_DONE is returned when all rows or limit are copied
+static int copyShardRows(ShardTask *task) {
+    sqlite3_stmt *stmt = task->statement->stmt;
+    ShardRow row;
+    task->rows = newSqliteResultSet(NULL, NULL);
+    if (task->rows == NULL || initShardRow(&row, stmt) != SQLITE_OK) return SQLITE_NOMEM;
+
+    int rc = SQLITE_ROW;
+    for (int64_t rowCount = 0; rc == SQLITE_ROW && (task->limit == NO_LIMIT || rowCount < task->limit); rowCount++) {
+        if (!appendShardRow(&row, stmt, task->rows)) {
+            rc = SQLITE_NOMEM;
+            break;
+        }
+        rc = sqliteStatementStep(task->statement);
+    }
+    free(row.names);
+    return rc == SQLITE_ROW ? SQLITE_DONE : rc;
+}
+
+static int initShardRow(ShardRow *row, sqlite3_stmt *stmt) {
+    row->columnCount = sqlite3_column_count(stmt);
+    size_t columnSize = sizeof(char *) * 2 + sizeof(uint32_t) + sizeof(DbValueType) + SHARD_NUMBER_BUFFER_SIZE;
+    row->names = malloc(columnSize * row->columnCount);
+    if (row->names == NULL) return SQLITE_NOMEM;
+    row->values = row->names + row->columnCount;
+    row->lengths = (uint32_t *) (row->values + row->columnCount);
+    row->types = (DbValueType *) (row->lengths + row->columnCount);
+    row->numbers = (char *) (row->types + row->columnCount);
+    for (int i = 0; i < row->columnCount; i++) {
+        row->names[i] = (char *) sqlite3_column_name(stmt, i);
+    }
+    return SQLITE_OK;
+}
+
+// Same as single shard cursor: values keep types, doubles are not rounded to 15 digits of sqlite text conversion
+static bool appendShardRow(ShardRow *row, sqlite3_stmt *stmt, ResultSet *output) {
+    static const DbValueType VALUE_TYPES[] = {[SQLITE_INTEGER] = DB_VALUE_INT, [SQLITE_FLOAT] = DB_VALUE_REAL, [SQLITE_TEXT] = DB_VALUE_TEXT,
+                                              [SQLITE_BLOB] = DB_VALUE_BLOB, [SQLITE_NULL] = DB_VALUE_NULL};
+    for (int i = 0; i < row->columnCount; i++) {
+        row->types[i] = VALUE_TYPES[sqlite3_column_type(stmt, i)];    // before text conversion
+        if (row->types[i] == DB_VALUE_REAL) {
+            row->values[i] = row->numbers + i * SHARD_NUMBER_BUFFER_SIZE;
+            sqlite3_snprintf(SHARD_NUMBER_BUFFER_SIZE, row->values[i], "%!.17g", sqlite3_column_double(stmt, i));
+            row->lengths[i] = (uint32_t) strlen(row->values[i]);
+            continue;
+        }
+        row->values[i] = (char *) sqlite3_column_text(stmt, i);
+        row->lengths[i] = (uint32_t) sqlite3_column_bytes(stmt, i);
+    }
+    return resultSetAppendTypedRow(output, row->columnCount, row->values, row->lengths, row->types, row->names);
+}
+
+// Each shard cursor is already sorted, so next row is the smallest of shard heads
+static int mergeOrderedRows(ShardTask *tasks, uint32_t taskCount, const ShardQueryPlan *plan, ResultSet *output) {
+    if (sqlite3_column_count(tasks[0].statement->stmt) == 0) return SQLITE_OK;
+    ShardRow row;
+    if (initShardRow(&row, tasks[0].statement->stmt) != SQLITE_OK) return SQLITE_NOMEM;
+    int rc = SQLITE_OK;
+
+    for (int64_t rowCount = 0; plan->limit == NO_LIMIT || rowCount < plan->limit; rowCount++) {
+        ShardTask *next = NULL;
+        for (uint32_t i = 0; i < taskCount; i++) {
+            if (tasks[i].rc == SQLITE_ROW && (next == NULL || compareShardRows(tasks[i].statement->stmt, next->statement->stmt, plan) < 0)) {
+                next = &tasks[i];
+            }
+        }
+        if (next == NULL) break;
+
+        if (!appendShardRow(&row, next->statement->stmt, output)) {
+            rc = SQLITE_NOMEM;
+            break;
+        }
+        next->rc = sqliteStatementStep(next->statement);
+        if (next->rc != SQLITE_ROW && next->rc != SQLITE_DONE) {
+            rc = next->rc;
+            break;
+        }
+    }
+    free(row.names);
+    return rc;
+}
+
+static int concatShardRows(ShardTask *tasks, uint32_t taskCount, const ShardQueryPlan *plan, ResultSet *output) {
+    int64_t rowCount = 0;
+    for (uint32_t i = 0; i < taskCount; i++) {
+        ResultSet *rows = tasks[i].rows;
+        if (rows == NULL || rows->columnCount == 0) continue;     // no rows
+        char **columnValues = malloc((sizeof(char *) + sizeof(uint32_t) + sizeof(DbValueType)) * rows->columnCount);
+        if (columnValues == NULL) return SQLITE_NOMEM;
+        uint32_t *valueLengths = (uint32_t *) (columnValues + rows->columnCount);
+        DbValueType *valueTypes = (DbValueType *) (valueLengths + rows->columnCount);
+
+        while ((plan->limit == NO_LIMIT || rowCount < plan->limit) && nextResultSet(rows)) {
+            for (uint32_t j = 0; j < rows->columnCount; j++) {    // shard rows are appended with types
+                columnValues[j] = (char *) rsGetBlobByIndex(rows, (int) j, &valueLengths[j]);
+                valueTypes[j] = rsGetColumnTypeByIndex(rows, (int) j);
+            }
+            if (!resultSetAppendTypedRow(output, (int) rows->columnCount, columnValues, valueLengths, valueTypes, rows->columnNames)) {
+                free(columnValues);
+                return SQLITE_NOMEM;
+            }
+            rowCount++;
+        }
+        free(columnValues);
+    }
+    return SQLITE_OK;
+}
+
+static int compareShardRows(sqlite3_stmt *first, sqlite3_stmt *second, const ShardQueryPlan *plan) {
+    for (uint32_t i = 0; i < plan->termCount; i++) {
+        int result = compareColumnValues(first, second, plan->terms[i].column);
+        if (result != 0) {
+            return plan->terms[i].isDescending ? -result : result;
+        }
+    }
+    return 0;
+}
+
+// Same order as sqlite uses for BINARY collation: NULL, numbers, text, blobs
+static int compareColumnValues(sqlite3_stmt *first, sqlite3_stmt *second, int column) {
+    static const int TYPE_RANKS[] = {[SQLITE_INTEGER] = 1, [SQLITE_FLOAT] = 1, [SQLITE_TEXT] = 2, [SQLITE_BLOB] = 3, [SQLITE_NULL] = 0};
+    int firstType = sqlite3_column_type(first, column);
+    int secondType = sqlite3_column_type(second, column);
+    int firstRank = TYPE_RANKS[firstType];
+    int secondRank = TYPE_RANKS[secondType];
+    if (firstRank != secondRank) return firstRank < secondRank ? -1 : 1;
+
+    if (firstRank == 0) return 0;
+    if (firstRank == 1) {
+        if (firstType == SQLITE_INTEGER && secondType == SQLITE_INTEGER) {
+            sqlite3_int64 firstValue = sqlite3_column_int64(first, column);
+            sqlite3_int64 secondValue = sqlite3_column_int64(second, column);
+            return firstValue < secondValue ? -1 : firstValue > secondValue;
+        }
+        double firstValue = sqlite3_column_double(first, column);
+        double secondValue = sqlite3_column_double(second, column);
+        return firstValue < secondValue ? -1 : firstValue > secondValue;
+    }
+
+    const void *firstBytes = firstRank == 2 ? (const void *) sqlite3_column_text(first, column) : sqlite3_column_blob(first, column);
+    const void *secondBytes = firstRank == 2 ? (const void *) sqlite3_column_text(second, column) : sqlite3_column_blob(second, column);
+    int firstLength = sqlite3_column_bytes(first, column);
+    int secondLength = sqlite3_column_bytes(second, column);
+    int minLength = firstLength < secondLength ? firstLength : secondLength;
+    int result = minLength > 0 ? memcmp(firstBytes, secondBytes, (size_t) minLength) : 0;
+    return result != 0 ? result : (firstLength > secondLength) - (firstLength < secondLength);
+}
+
+// Term is result column name, its alias or 1 based position
+static int resolveOrderColumns(ShardQueryPlan *plan, sqlite3_stmt *stmt) {
+    int columnCount = sqlite3_column_count(stmt);
+    for (uint32_t i = 0; i < plan->termCount; i++) {
+        ShardOrderTerm *term = &plan->terms[i];
+        term->column = -1;
+        if (isdigit((unsigned char) term->name[0])) {
+            int position = atoi(term->name);
+            term->column = position >= 1 && position <= columnCount ? position - 1 : -1;
+        }
+        for (int j = 0; j < columnCount && term->column < 0; j++) {
+            const char *columnName = sqlite3_column_name(stmt, j);
+            if (sqlite3_strnicmp(columnName, term->name, (int) term->length) == 0 && columnName[term->length] == '\0') {
+                term->column = j;
+            }
+        }
+        if (term->column < 0) return SQLITE_RANGE;   // expression or column that is not selected
+        if (!isBinaryCollation(stmt, term->column)) return SQLITE_MISUSE;
+    }
+    return SQLITE_OK;
+}
+
+// Shard rows are merged by BINARY order, so column declared with other collation would be sorted differently by each shard.
+// Declared collation of table column is known only with SQLITE_ENABLE_COLUMN_METADATA, expression collation is not checked
+static bool isBinaryCollation(sqlite3_stmt *stmt, int column) {
+#ifdef SQLITE_ENABLE_COLUMN_METADATA
+    const char *tableName = sqlite3_column_table_name(stmt, column);
+    const char *collation = NULL;
+    if (tableName != NULL &&
+        sqlite3_table_column_metadata(sqlite3_db_handle(stmt), sqlite3_column_database_name(stmt, column), tableName,
+                                      sqlite3_column_origin_name(stmt, column), NULL, &collation, NULL, NULL, NULL) == SQLITE_OK) {
+        return collation == NULL || sqlite3_stricmp(collation, "BINARY") == 0;
+    }
+#endif
+    return true;
+}
+
+// Finds top level ORDER BY and LIMIT, clauses of subqueries and window functions are inside parentheses.
+// FROM subqueries and CTEs are executed on rows of each shard, so they are checked the same as top level select.
+// Expression subqueries, e.g. IN (SELECT max(id) ...), are evaluated for rows of own shard and are not checked
+static int parseShardQuery(const char *sql, str_DbValueMap *queryParams, ShardQueryPlan *plan) {
+    plan->termCount = 0;
+    plan->limit = NO_LIMIT;
+    const char *orderBy = NULL;
+    const char *limit = NULL;
+    const char *end = sql + strlen(sql);
+    bool isRowSource[MAX_QUERY_DEPTH] = {false};    // FROM subquery or CTE, including subqueries inside them
+    bool isFromClause[MAX_QUERY_DEPTH] = {false};
+    int depth = 0;
+    for (const char *position = sql; *position != '\0'; position++) {
+        char c = *position;
+        if (c == '\'' || c == '"' || c == '`' || c == '[') {
+            position = skipQuoted(position) - 1;
+        } else if (c == '(') {
+            if (++depth == MAX_QUERY_DEPTH) return SQLITE_MISUSE;
+            isRowSource[depth] = isRowSource[depth - 1] || isRowSourceAt(sql, position, isFromClause[depth - 1]);
+            isFromClause[depth] = false;
+        } else if (c == ')') {
+            if (depth > 0) depth--;
+        } else if (c == ';' && depth == 0) {
+            end = position;
+            break;
+        } else if (isWordAt(sql, position, "OVER") || ((depth == 0 || isRowSource[depth]) && isMergeUnsupportedAt(sql, position))) {
+            return SQLITE_MISUSE;   // window of any select sees only rows of own shard
+        } else if (isWordAt(sql, position, "FROM")) {
+            isFromClause[depth] = true;
+        } else if (depth == 0 && isWordAt(sql, position, "ORDER")) {
+            const char *by = skipSpaces(position + 5);
+            if (isWordAt(sql, by, "BY")) {
+                orderBy = by + 2;
+                limit = NULL;
+            }
+            isFromClause[depth] = false;
+        } else if (isWordAt(sql, position, "LIMIT")) {
+            if (isRowSource[depth]) return SQLITE_MISUSE;   // each shard would return limited rows
+            if (depth == 0) {
+                limit = position;
+            }
+            isFromClause[depth] = false;
+        } else if (isClauseStartAt(sql, position)) {
+            isFromClause[depth] = false;
+        }
+    }
+
+    int rc = SQLITE_OK;
+    if (orderBy != NULL) {
+        rc = parseOrderTerms(orderBy, limit != NULL ? limit : end, plan);
+    }
+    if (rc == SQLITE_OK && limit != NULL) {
+        rc = parseLimit(limit + 5, queryParams, &plan->limit);
+    }
+    return rc;
+}
+
+static int parseOrderTerms(const char *start, const char *end, ShardQueryPlan *plan) {
+    const char *termStart = start;
+    int depth = 0;
+    for (const char *position = start; position <= end; position++) {
+        if (position < end && (*position == '\'' || *position == '"' || *position == '`' || *position == '[')) {
+            position = skipQuoted(position) - 1;
+            continue;
+        }
+        if (position < end && *position == '(') depth++;
+        if (position < end && *position == ')') depth--;
+        if (position < end && (*position != ',' || depth > 0)) continue;
+        if (plan->termCount == SQLITE_SHARDS_MAX_ORDER_TERMS) return SQLITE_RANGE;
+
+        const char *nameStart = skipSpaces(termStart);
+        const char *nameEnd = position;
+        while (nameEnd > nameStart && isspace((unsigned char) nameEnd[-1])) nameEnd--;
+        ShardOrderTerm *term = &plan->terms[plan->termCount++];
+        term->isDescending = false;
+        const char *lastWord = nameEnd;
+        while (lastWord > nameStart && isIdentifierChar(lastWord[-1])) lastWord--;
+        if (lastWord > nameStart && (isWordAt(nameStart, lastWord, "ASC") || isWordAt(nameStart, lastWord, "DESC"))) {
+            term->isDescending = toupper((unsigned char) *lastWord) == 'D';
+            nameEnd = lastWord;
+            while (nameEnd > nameStart && isspace((unsigned char) nameEnd[-1])) nameEnd--;
+        }
+        const char *collation = nameEnd;
+        while (collation > nameStart && isIdentifierChar(collation[-1])) collation--;
+        const char *collate = collation;
+        while (collate > nameStart && isspace((unsigned char) collate[-1])) collate--;
+        while (collate > nameStart && isIdentifierChar(collate[-1])) collate--;
+        if (collate < collation && isWordAt(nameStart, collate, "COLLATE")) {
+            if (nameEnd - collation != 6 || sqlite3_strnicmp(collation, "BINARY", 6) != 0) return SQLITE_MISUSE;   // merge compares bytes
+            nameEnd = collate;
+            while (nameEnd > nameStart && isspace((unsigned char) nameEnd[-1])) nameEnd--;
+        }
+
+        if (nameEnd - nameStart >= 2 && (*nameStart == '"' || *nameStart == '`' || *nameStart == '[')) {
+            nameStart++;    // quoted name
+            nameEnd--;
+        } else {
+            for (const char *dot = nameEnd; dot > nameStart; dot--) {
+                if (dot[-1] == '.') {   // table qualified column
+                    nameStart = dot;
+                    break;
+                }
+            }
+        }
+        if (nameEnd <= nameStart) return SQLITE_RANGE;
+        term->name = nameStart;
+        term->length = (uint32_t) (nameEnd - nameStart);
+        termStart = position + 1;
+    }
+    return SQLITE_OK;
+}
+
+// Literal or named parameter limit, OFFSET would skip rows of each shard instead of merged result
+static int parseLimit(const char *start, str_DbValueMap *queryParams, int64_t *limit) {
+    const char *position = skipSpaces(start);
+    if (*position == ':' || *position == '@' || *position == '$') {
+        const char *nameStart = ++position;
+        while (isIdentifierChar(*position)) position++;
+        char name[64];
+        size_t nameLength = (size_t) (position - nameStart);
+        if (nameLength == 0 || nameLength >= sizeof(name) || queryParams == NULL) return SQLITE_RANGE;
+        memcpy(name, nameStart, nameLength);
+        name[nameLength] = '\0';
+        DbValue value = str_DbValueMapGetOrDefault(queryParams, name, DB_NULL_VALUE());
+        if (value.type != DB_VALUE_INT) return SQLITE_RANGE;
+        *limit = value.as.intValue;
+    } else if (isdigit((unsigned char) *position)) {
+        char *numberEnd;
+        *limit = strtoll(position, &numberEnd, 10);
+        position = numberEnd;
+    } else {
+        return SQLITE_RANGE;
+    }
+
+    position = skipSpaces(position);
+    if (*position == ',' || isWordAt(position, position, "OFFSET")) return SQLITE_MISUSE;
+    if (*limit < 0) {
+        *limit = NO_LIMIT;
+    }
+    return SQLITE_OK;
+}
+
+// Rows of GROUP BY, DISTINCT, aggregates and deduplicating compound select depend on rows of other shards
+static bool isMergeUnsupportedAt(const char *sql, const char *position) {
+    if (isWordAt(sql, position, "GROUP")) return isWordAt(sql, skipSpaces(position + 5), "BY");
+    if (isWordAt(sql, position, "UNION")) return !isWordAt(sql, skipSpaces(position + 5), "ALL");
+    return isWordAt(sql, position, "DISTINCT") || isWordAt(sql, position, "INTERSECT") || isWordAt(sql, position, "EXCEPT") ||
+           isAggregateCallAt(sql, position);
+}
+
+// Parenthesis after FROM, JOIN, comma of FROM list or AS of CTE. Comma inside of join constraint is nested deeper
+static bool isRowSourceAt(const char *sql, const char *position, bool isFromClause) {
+    while (position > sql && isspace((unsigned char) position[-1])) position--;
+    if (position > sql && position[-1] == ',') return isFromClause;
+    const char *word = position;
+    while (word > sql && isIdentifierChar(word[-1])) word--;
+    return isWordAt(sql, word, "FROM") || isWordAt(sql, word, "JOIN") || isWordAt(sql, word, "AS") || isWordAt(sql, word, "MATERIALIZED");
+}
+
+// Clauses after FROM list, top level ORDER BY and LIMIT are checked by caller
+static bool isClauseStartAt(const char *sql, const char *position) {
+    return isWordAt(sql, position, "WHERE") || isWordAt(sql, position, "GROUP") || isWordAt(sql, position, "HAVING") ||
+           isWordAt(sql, position, "ORDER") ||
+           isWordAt(sql, position, "WINDOW") || isWordAt(sql, position, "SELECT") || isWordAt(sql, position, "VALUES") ||
+           isWordAt(sql, position, "UNION") || isWordAt(sql, position, "INTERSECT") || isWordAt(sql, position, "EXCEPT");
+}
+
+static bool isAggregateCallAt(const char *sql, const char *position) {
+    for (size_t i = 0; i < sizeof(AGGREGATE_FUNCTIONS) / sizeof(AGGREGATE_FUNCTIONS[0]); i++) {
+        const char *name = AGGREGATE_FUNCTIONS[i];
+        if (!isWordAt(sql, position, name)) continue;
+        const char *arguments = skipSpaces(position + strlen(name));
+        if (*arguments != '(') return false;    // column with the same name
+        if (strcmp(name, "min") != 0 && strcmp(name, "max") != 0) return true;
+
+        int depth = 0;
+        for (const char *argument = arguments + 1; *argument != '\0'; argument++) {
+            if (*argument == '\'' || *argument == '"' || *argument == '`' || *argument == '[') {
+                argument = skipQuoted(argument) - 1;
+            } else if (*argument == '(') {
+                depth++;
+            } else if (*argument == ')' && depth-- == 0) {
+                return true;
+            } else if (*argument == ',' && depth == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Returns position after closing quote, doubled quote is escaped
+static const char *skipQuoted(const char *sql) {
+    char quote = *sql == '[' ? ']' : *sql;
+    const char *position = sql + 1;
+    while (*position != '\0') {
+        if (*position == quote) {
+            if (quote != ']' && position[1] == quote) {
+                position += 2;
+                continue;
+            }
+            return position + 1;
+        }
+        position++;
+    }
+    return position;
+}
+
+static const char *skipSpaces(const char *sql) {
+    while (isspace((unsigned char) *sql)) sql++;
+    return sql;
+}
+
+static bool isWordAt(const char *sql, const char *position, const char *word) {
+    size_t length = strlen(word);
+    return (position == sql || !isIdentifierChar(position[-1])) &&
+           sqlite3_strnicmp(position, word, (int) length) == 0 &&
+           !isIdentifierChar(position[length]);
+}
+
+static bool isIdentifierChar(char c) {
+    return isalnum((unsigned char) c) || c == '_' || (unsigned char) c >= 0x80;
+}
+
+static uint32_t hashKeyBytes(const uint8_t *bytes, size_t length) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Sequential keys are spread evenly, modulo of raw value would put ranges of ids to the same shard pattern
+static uint32_t hashKeyInt(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return (uint32_t) value;
+}
+
+static int taskErrorCode(sqlite3 *db) {
+    int rc = sqlite3_errcode(db);
+    return rc != SQLITE_OK ? rc : SQLITE_NOMEM;
+}
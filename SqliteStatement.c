@@ -0,0 +1,252 @@
+#include <ctype.h>
+#include "SqliteQueryStats.h"
+#include "SqliteDeadline.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+static int bindDbValue(sqlite3_stmt *stmt, int index, DbValue value, sqlite3_destructor_type destructor);
+static uint32_t statementParamCount(SqliteStatement *statement);
+static const SqlParam *findListParam(const SqlParamList *params, const char *name, uint32_t expectedIndex);
+static char *copyTailSql(const char *tail);
+static void deleteColumnMap(SqliteStatement *statement);
+
+
+SqliteStatement *newSqliteStatement(sqlite3 *db, const char *sql) {
+    if (db == NULL || sql == NULL) return NULL;
+    SqliteStatement *statement = calloc(1, sizeof(struct SqliteStatement));
+    if (statement == NULL) return NULL;
+    statement->db = db;
+    statement->sql = strdup(sql);
+    statement->sqlHash = sqliteStatementHash(sql);
+    statement->paramNames = getVectorInstance(8);
+    if (statement->sql == NULL || statement->paramNames == NULL) {
+        deleteSqliteStatement(statement);
+        return NULL;
+    }
+
+    QueryString *nativeSql = nativeQueryString(sql, statement->paramNames);
+    if (nativeSql == NULL) {
+        deleteSqliteStatement(statement);
+        return NULL;
+    }
+
+    const char *tail = NULL;
+    int rc = sqlite3_prepare_v2(db, nativeSql->value, (int) nativeSql->size, &statement->stmt, &tail);
+    if (rc != SQLITE_OK || statement->stmt == NULL) {  // empty sql also has no statement
+        deleteQueryString(nativeSql);
+        deleteSqliteStatement(statement);
+        return NULL;
+    }
+
+    statement->tailSql = copyTailSql(tail);
+    deleteQueryString(nativeSql);
+    return statement;
+}
+
+int sqliteStatementBind(SqliteStatement *statement, str_DbValueMap *queryParams, bool copyValues) {
+    if (statement->queryStats != NULL) {
+        queryStatsAddBoundBytes(statement, queryParams);
+    }
+    return sqliteBindParams(statement->stmt, statement->paramNames, queryParams, copyValues);
+}
+
+int sqliteBindParams(sqlite3_stmt *stmt, Vector paramNames, str_DbValueMap *queryParams, bool copyValues) {
+    sqlite3_destructor_type destructor = copyValues ? SQLITE_TRANSIENT : SQLITE_STATIC;
+    uint32_t paramCount = (uint32_t) sqlite3_bind_parameter_count(stmt);  // can be lower for multi statement sql
+    if (paramCount > getVectorSize(paramNames)) {
+        paramCount = getVectorSize(paramNames);
+    }
+
+    for (uint32_t i = 0; i < paramCount; i++) {
+        const char *paramName = vectorGet(paramNames, i);
+        DbValue dbValue = queryParams != NULL ? str_DbValueMapGetOrDefault(queryParams, paramName, DB_NULL_VALUE()) : DB_NULL_VALUE();
+        int rc = bindDbValue(stmt, (int) (i + 1), dbValue, destructor);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    return SQLITE_OK;
+}
+
+int sqliteStatementBindList(SqliteStatement *statement, const SqlParamList *params, bool copyValues) {
+    sqlite3_destructor_type destructor = copyValues ? SQLITE_TRANSIENT : SQLITE_STATIC;
+    uint32_t paramCount = statementParamCount(statement);
+    for (uint32_t i = 0; i < paramCount; i++) {
+        const SqlParam *param = params != NULL ? findListParam(params, vectorGet(statement->paramNames, i), i) : NULL;
+        DbValue value = param != NULL ? param->value : DB_NULL_VALUE();
+        if (statement->queryStats != NULL) {
+            queryStatsAddBoundValue(statement, value);
+        }
+        int rc = bindDbValue(statement->stmt, (int) (i + 1), value, destructor);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    return SQLITE_OK;
+}
+
+int sqliteStatementBindValues(SqliteStatement *statement, const SqlValueList *values, bool copyValues) {
+    sqlite3_destructor_type destructor = copyValues ? SQLITE_TRANSIENT : SQLITE_STATIC;
+    uint32_t valueCount = values != NULL ? values->count : 0;
+    if (valueCount != getVectorSize(statement->paramNames)) return SQLITE_RANGE;
+
+    uint32_t paramCount = statementParamCount(statement);
+    for (uint32_t i = 0; i < paramCount; i++) {
+        if (statement->queryStats != NULL) {
+            queryStatsAddBoundValue(statement, values->values[i]);
+        }
+        int rc = bindDbValue(statement->stmt, (int) (i + 1), values->values[i], destructor);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    return SQLITE_OK;
+}
+
+int sqliteStatementStep(SqliteStatement *statement) {
+    if (!statement->deadline.isArmed) {
+        return sqliteDeadlineResult(statement->db, sqlite3_step(statement->stmt));
+    }
+    DeadlineState *previous = sqliteDeadlineEnter(&statement->deadline);
+    int rc = sqliteDeadlineResult(statement->db, sqlite3_step(statement->stmt));   // before leave, interrupt is mapped by active deadline
+    sqliteDeadlineLeave(&statement->deadline, previous);
+    return rc;
+}
+
+void sqliteStatementReset(SqliteStatement *statement) {
+    sqlite3_reset(statement->stmt);
+    sqlite3_clear_bindings(statement->stmt);
+}
+
+void sqliteStatementFinish(SqliteStatement *statement) {
+    if (statement->queryStats != NULL) {
+        queryStatsEnd(statement);
+    }
+    sqliteDeadlineDisarm(&statement->deadline);
+    sqlite3_reset(statement->stmt);
+}
+
+void sqliteStatementRelease(SqliteStatement *statement) {
+    if (statement == NULL) return;
+    sqliteStatementFinish(statement);
+    if (statement->isCached) {
+        sqliteStatementReset(statement);
+        statement->isInUse = false;
+        return;
+    }
+    deleteSqliteStatement(statement);
+}
+
+uint32_t sqliteStatementHash(const char *sql) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    while (*sql != '\0') {
+        hash ^= (uint8_t) *sql++;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+HashMap sqliteStatementColumnMap(SqliteStatement *statement) {
+    int prepareCount = sqlite3_stmt_status(statement->stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+    if (statement->columnMap != NULL && statement->columnPrepareCount == prepareCount) {
+        return statement->columnMap;
+    }
+    deleteColumnMap(statement);     // schema change, 'SELECT *' columns can differ
+
+    int columnCount = sqlite3_column_count(statement->stmt);
+    if (columnCount == 0) return NULL;
+    size_t namesSize = 0;
+    for (int i = 0; i < columnCount; i++) {
+        namesSize += strlen(sqlite3_column_name(statement->stmt, i)) + 1;
+    }
+
+    // column name pointers are valid only until re-prepare, so names are copied: pointers followed by name strings
+    statement->columnNames = malloc(sizeof(char *) * columnCount + namesSize);
+    statement->columnMap = getHashMapInstance(columnCount * 2);
+    if (statement->columnNames == NULL || statement->columnMap == NULL) {
+        deleteColumnMap(statement);
+        return NULL;
+    }
+
+    char *namePtr = (char *) (statement->columnNames + columnCount);
+    for (int i = 0; i < columnCount; i++) {
+        const char *name = sqlite3_column_name(statement->stmt, i);
+        size_t nameSize = strlen(name) + 1;
+        memcpy(namePtr, name, nameSize);
+        statement->columnNames[i] = namePtr;
+        hashMapPut(statement->columnMap, namePtr, (MapValueType) (long) i);
+        namePtr += nameSize;
+    }
+    statement->columnPrepareCount = prepareCount;
+    return statement->columnMap;
+}
+
+void deleteSqliteStatement(SqliteStatement *statement) {
+    if (statement != NULL) {
+        sqlite3_finalize(statement->stmt);
+        for (uint32_t i = 0; i < getVectorSize(statement->paramNames); i++) {
+            free(vectorGet(statement->paramNames, i));
+        }
+        vectorDelete(statement->paramNames);
+        deleteColumnMap(statement);
+        free(statement->mappingColumns);
+        free(statement->tailSql);
+        free(statement->sql);
+        free(statement);
+    }
+}
+
+static int bindDbValue(sqlite3_stmt *stmt, int index, DbValue value, sqlite3_destructor_type destructor) {
+    switch (value.type) {
+        case DB_VALUE_TEXT:
+            return sqlite3_bind_text(stmt, index, DB_VALUE_AS_STR(value), -1, destructor);
+        case DB_VALUE_INT:
+            return sqlite3_bind_int64(stmt, index, DB_VALUE_AS_INT(value));
+        case DB_VALUE_REAL:
+            return sqlite3_bind_double(stmt, index, DB_VALUE_AS_DOUBLE(value));
+        case DB_VALUE_BLOB:
+            if (DB_VALUE_AS_BLOB(value) == NULL) {     // 64 bit variants, length above INT_MAX is SQLITE_TOOBIG instead of overflow
+                return sqlite3_bind_zeroblob64(stmt, index, value.length);
+            }
+            return sqlite3_bind_blob64(stmt, index, DB_VALUE_AS_BLOB(value), value.length, destructor);
+        case DB_VALUE_NULL:
+        default:
+            return sqlite3_bind_null(stmt, index);
+    }
+}
+
+static uint32_t statementParamCount(SqliteStatement *statement) {
+    uint32_t paramCount = (uint32_t) sqlite3_bind_parameter_count(statement->stmt);  // can be lower for multi statement sql
+    return paramCount < getVectorSize(statement->paramNames) ? paramCount : getVectorSize(statement->paramNames);
+}
+
+// Lists are usually written in sql parameter order, so expected position is checked first
+static const SqlParam *findListParam(const SqlParamList *params, const char *name, uint32_t expectedIndex) {
+    if (expectedIndex < params->count && strcmp(params->params[expectedIndex].name, name) == 0) {
+        return &params->params[expectedIndex];
+    }
+    for (uint32_t i = 0; i < params->count; i++) {
+        if (strcmp(params->params[i].name, name) == 0) {
+            return &params->params[i];
+        }
+    }
+    return NULL;
+}
+
+static char *copyTailSql(const char *tail) {
+    if (tail == NULL) return NULL;
+    while (isspace((int) *tail)) {
+        tail++;
+    }
+    return *tail != '\0' ? strdup(tail) : NULL;
+}
+
+static void deleteColumnMap(SqliteStatement *statement) {
+    if (statement->columnMap != NULL) {
+        hashMapDelete(statement->columnMap);
+    }
+    free(statement->columnNames);
+    statement->columnMap = NULL;
+    statement->columnNames = NULL;
+}
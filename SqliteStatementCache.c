@@ -0,0 +1,178 @@
+#include "SqliteStatementCache.h"
+
+#define MIN_BUCKET_COUNT 8
+
+static uint32_t bucketCountForCapacity(uint32_t capacity);
+static SqliteStatement *findStatement(StatementCache *cache, const char *sql, uint32_t hash);
+static void removeStatement(StatementCache *cache, SqliteStatement *statement);
+
+static void bucketLink(SqliteStatement **buckets, uint32_t bucketCount, SqliteStatement *statement);
+static void bucketUnlink(StatementCache *cache, SqliteStatement *statement);
+static void lruLinkHead(StatementCache *cache, SqliteStatement *statement);
+static void lruUnlink(StatementCache *cache, SqliteStatement *statement);
+
+
+StatementCache *newStatementCache(uint32_t capacity) {
+    StatementCache *cache = calloc(1, sizeof(struct StatementCache));
+    if (cache == NULL) return NULL;
+
+    cache->bucketCount = bucketCountForCapacity(capacity);
+    cache->buckets = calloc(cache->bucketCount, sizeof(SqliteStatement *));
+    if (cache->buckets == NULL) {
+        free(cache);
+        return NULL;
+    }
+    cache->stats.capacity = capacity;
+    return cache;
+}
+
+SqliteStatement *statementCacheAcquire(StatementCache *cache, const char *sql) {
+    if (cache == NULL || sql == NULL) return NULL;
+    SqliteStatement *statement = findStatement(cache, sql, sqliteStatementHash(sql));
+    if (statement == NULL || statement->isInUse) {  // statement can be still iterated by other result set
+        cache->stats.misses++;
+        return NULL;
+    }
+
+    lruUnlink(cache, statement);
+    lruLinkHead(cache, statement);
+    statement->isInUse = true;
+    cache->stats.hits++;
+    return statement;
+}
+
+bool statementCachePut(StatementCache *cache, SqliteStatement *statement) {
+    if (cache == NULL || statement == NULL || statement->isCached) return false;
+    if (cache->stats.capacity == 0 || findStatement(cache, statement->sql, statement->sqlHash) != NULL) {
+        return false;
+    }
+
+    while (cache->stats.size >= cache->stats.capacity) {
+        removeStatement(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+
+    bucketLink(cache->buckets, cache->bucketCount, statement);
+    lruLinkHead(cache, statement);
+    statement->isCached = true;
+    cache->stats.size++;
+    return true;
+}
+
+void statementCacheSetCapacity(StatementCache *cache, uint32_t capacity) {
+    if (cache == NULL) return;
+    while (cache->stats.size > capacity) {
+        removeStatement(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+    cache->stats.capacity = capacity;
+
+    uint32_t bucketCount = bucketCountForCapacity(capacity);
+    if (bucketCount == cache->bucketCount) return;
+    SqliteStatement **buckets = calloc(bucketCount, sizeof(SqliteStatement *));
+    if (buckets == NULL) return;    // keep old buckets, lookup still works
+
+    for (SqliteStatement *statement = cache->head; statement != NULL; statement = statement->next) {
+        bucketLink(buckets, bucketCount, statement);
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucketCount = bucketCount;
+}
+
+StatementCacheStats statementCacheGetStats(StatementCache *cache) {
+    if (cache == NULL) {
+        return (StatementCacheStats) {0};
+    }
+    return cache->stats;
+}
+
+void statementCacheClear(StatementCache *cache) {
+    if (cache == NULL) return;
+    while (cache->tail != NULL) {
+        removeStatement(cache, cache->tail);
+    }
+}
+
+void deleteStatementCache(StatementCache *cache) {
+    if (cache != NULL) {
+        statementCacheClear(cache);
+        free(cache->buckets);
+        free(cache);
+    }
+}
+
+static uint32_t bucketCountForCapacity(uint32_t capacity) {
+    uint32_t bucketCount = MIN_BUCKET_COUNT;
+    while (bucketCount < capacity) {
+        bucketCount <<= 1;
+    }
+    return bucketCount;
+}
+
+static SqliteStatement *findStatement(StatementCache *cache, const char *sql, uint32_t hash) {
+    SqliteStatement *statement = cache->buckets[hash & (cache->bucketCount - 1)];
+    while (statement != NULL) {
+        if (statement->sqlHash == hash && strcmp(statement->sql, sql) == 0) {
+            return statement;
+        }
+        statement = statement->bucketNext;
+    }
+    return NULL;
+}
+
+static void removeStatement(StatementCache *cache, SqliteStatement *statement) {
+    bucketUnlink(cache, statement);
+    lruUnlink(cache, statement);
+    cache->stats.size--;
+    statement->isCached = false;
+    if (!statement->isInUse) {  // otherwise finalized on release
+        deleteSqliteStatement(statement);
+    }
+}
+
+static void bucketLink(SqliteStatement **buckets, uint32_t bucketCount, SqliteStatement *statement) {
+    SqliteStatement **bucket = &buckets[statement->sqlHash & (bucketCount - 1)];
+    statement->bucketNext = *bucket;
+    *bucket = statement;
+}
+
+static void bucketUnlink(StatementCache *cache, SqliteStatement *statement) {
+    SqliteStatement **link = &cache->buckets[statement->sqlHash & (cache->bucketCount - 1)];
+    while (*link != NULL) {
+        if (*link == statement) {
+            *link = statement->bucketNext;
+            break;
+        }
+        link = &(*link)->bucketNext;
+    }
+    statement->bucketNext = NULL;
+}
+
+static void lruLinkHead(StatementCache *cache, SqliteStatement *statement) {
+    statement->prev = NULL;
+    statement->next = cache->head;
+    if (cache->head != NULL) {
+        cache->head->prev = statement;
+    }
+    cache->head = statement;
+    if (cache->tail == NULL) {
+        cache->tail = statement;
+    }
+}
+
+static void lruUnlink(StatementCache *cache, SqliteStatement *statement) {
+    if (statement->prev != NULL) {
+        statement->prev->next = statement->next;
+    } else {
+        cache->head = statement->next;
+    }
+
+    if (statement->next != NULL) {
+        statement->next->prev = statement->prev;
+    } else {
+        cache->tail = statement->prev;
+    }
+    statement->prev = NULL;
+    statement->next = NULL;
+}
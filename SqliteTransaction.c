@@ -0,0 +1,138 @@
+#include "SqliteWrapper.h"
+
+#define SAVEPOINT_NAME_FORMAT "wrapper_sp_%" PRIu32
+#define SAVEPOINT_SQL_SIZE 64
+
+static const char *const BEGIN_SQL[] = {
+        [TRANSACTION_DEFERRED] = "BEGIN DEFERRED",
+        [TRANSACTION_IMMEDIATE] = "BEGIN IMMEDIATE",
+        [TRANSACTION_EXCLUSIVE] = "BEGIN EXCLUSIVE",
+};
+
+static SqliteConnection *transactionConnection(sqlite3 *db);
+static int executeSavepointSql(sqlite3 *db, const char *command, uint32_t level);
+static void rollbackToDepth(sqlite3 *db, uint32_t depth);
+
+
+int sqliteBeginTransaction(sqlite3 *db, TransactionMode mode) {
+    SqliteConnection *connection = transactionConnection(db);
+    if (connection == NULL || mode > TRANSACTION_EXCLUSIVE) return SQLITE_MISUSE;
+
+    if (sqlite3_get_autocommit(db) != 0) {
+        int rc = executeUpdate(db, BEGIN_SQL[mode], NULL);
+        if (rc == SQLITE_OK) {
+            connection->isOwnTransaction = true;
+        }
+        return rc;
+    }
+
+    // inside wrapper or user transaction, mode is already defined by outer one
+    int rc = executeSavepointSql(db, "SAVEPOINT", connection->savepointDepth + 1);
+    if (rc == SQLITE_OK) {
+        connection->savepointDepth++;
+    }
+    return rc;
+}
+
+int sqliteCommitTransaction(sqlite3 *db) {
+    SqliteConnection *connection = transactionConnection(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+
+    if (connection->savepointDepth > 0) {
+        int rc = executeSavepointSql(db, "RELEASE", connection->savepointDepth);
+        if (rc == SQLITE_OK) {
+            connection->savepointDepth--;
+        }
+        return rc;
+    }
+    if (!connection->isOwnTransaction) return SQLITE_MISUSE;
+
+    int rc = executeUpdate(db, "COMMIT", NULL);   // on SQLITE_BUSY transaction stays active and can be committed again
+    if (rc == SQLITE_OK) {
+        connection->isOwnTransaction = false;
+    }
+    return rc;
+}
+
+int sqliteRollbackTransaction(sqlite3 *db) {
+    SqliteConnection *connection = transactionConnection(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+
+    if (connection->savepointDepth > 0) {
+        int rc = executeSavepointSql(db, "ROLLBACK TO", connection->savepointDepth);
+        if (rc == SQLITE_OK) {
+            rc = executeSavepointSql(db, "RELEASE", connection->savepointDepth);
+        }
+        if (rc == SQLITE_OK) {      // otherwise savepoint is still open
+            connection->savepointDepth--;
+        }
+        return rc;
+    }
+    if (!connection->isOwnTransaction) return SQLITE_MISUSE;
+
+    int rc = executeUpdate(db, "ROLLBACK", NULL);
+    if (rc == SQLITE_OK || sqlite3_get_autocommit(db) != 0) {   // transaction can already be rolled back by error
+        connection->isOwnTransaction = false;
+    }
+    return rc;
+}
+
+uint32_t sqliteTransactionDepth(sqlite3 *db) {
+    SqliteConnection *connection = transactionConnection(db);
+    if (connection == NULL) return 0;
+    return connection->savepointDepth + (connection->isOwnTransaction ? 1 : 0);
+}
+
+int sqliteRunInTransaction(sqlite3 *db, const TransactionOptions *options, TransactionBody body, void *context) {
+    if (body == NULL) return SQLITE_MISUSE;
+    TransactionOptions runOptions = options != NULL ? *options : (TransactionOptions) {
+            .mode = TRANSACTION_IMMEDIATE,
+            .maxRetries = SQLITE_TRANSACTION_DEFAULT_RETRIES,
+            .retryDelayMs = SQLITE_TRANSACTION_RETRY_DELAY_MS
+    };
+
+    bool isOuter = sqlite3_get_autocommit(db) != 0;     // savepoint can't be retried, outer transaction is already locked
+    uint32_t depth = sqliteTransactionDepth(db);
+    int rc;
+    for (uint32_t attempt = 0;; attempt++) {
+        rc = sqliteBeginTransaction(db, runOptions.mode);
+        if (rc == SQLITE_OK) {
+            rc = body(db, context);
+            if (rc == SQLITE_OK && sqliteTransactionDepth(db) != depth + 1) {
+                rc = SQLITE_MISUSE;     // body has left own levels open or has closed this one
+            }
+            rc = rc == SQLITE_OK ? sqliteCommitTransaction(db) : rc;
+            if (rc != SQLITE_OK) {
+                rollbackToDepth(db, depth);     // levels opened by body are rolled back too
+            }
+        }
+
+        bool isBusy = (rc & 0xFF) == SQLITE_BUSY;   // including extended SQLITE_BUSY_SNAPSHOT
+        if (!isBusy || !isOuter || attempt >= runOptions.maxRetries) break;
+        sqlite3_sleep((int) (runOptions.retryDelayMs * (attempt + 1)));
+    }
+    return rc;
+}
+
+// Wrapper state is reset when sqlite has rolled back transaction on error, e.g. SQLITE_FULL or SQLITE_IOERR
+static SqliteConnection *transactionConnection(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL && sqlite3_get_autocommit(db) != 0) {
+        connection->savepointDepth = 0;
+        connection->isOwnTransaction = false;
+    }
+    return connection;
+}
+
+static void rollbackToDepth(sqlite3 *db, uint32_t depth) {
+    while (sqliteTransactionDepth(db) > depth) {
+        if (sqliteRollbackTransaction(db) != SQLITE_OK) break;
+    }
+}
+
+static int executeSavepointSql(sqlite3 *db, const char *command, uint32_t level) {
+    char sql[SAVEPOINT_SQL_SIZE];
+    int length = snprintf(sql, sizeof(sql), "%s " SAVEPOINT_NAME_FORMAT, command, level);
+    if (length < 0 || (size_t) length >= sizeof(sql)) return SQLITE_MISUSE;
+    return executeUpdate(db, sql, NULL);
+}
@@ -1,103 +1,216 @@
 #include "SqliteWrapper.h"
 
 
-static sqlite3_stmt *tryExecuteStep(sqlite3 *db, const char *sql);
-static int tryExecuteUpdate(sqlite3 *db, const char *sql);
-static int sqliteValueMapperCallback(void *userData, int valueCount, char **values, char **tableColumnNames);
+static SqliteStatement *acquireStatement(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, bool copyValues);
+static SqliteStatement *acquireListStatement(sqlite3 *db, const char *sql, const SqlParamList *params, const SqlValueList *values, bool copyValues, int *rc);
+static ResultSet *listStatementResultSet(SqliteStatement *statement, int result, int *rc);
+static int stepListStatement(SqliteStatement *statement);
+// Same as sqlite3_callback, with value sizes in bytes
+typedef int (*StatementRowCallback)(void *userData, int valueCount, char **values, const uint32_t *valueLengths, char **columnNames);
+
+static int executeCallbackSql(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, StatementRowCallback callback, void *userData);
+static int stepStatementRows(sqlite3_stmt *stmt, StatementRowCallback callback, void *userData);
+static int statementErrorCode(sqlite3 *db);
+static int sqliteValueMapperCallback(void *userData, int valueCount, char **values, const uint32_t *valueLengths, char **tableColumnNames);
 
 
 sqlite3 *sqliteDbInit(const char* dbName) {
-    sqlite3 *db;
+    return sqliteDbInitWithOptions(dbName, NULL);
+}
+
+sqlite3 *sqliteDbInitWithOptions(const char* dbName, const SqliteOpenOptions *options) {
+    sqlite3 *db = NULL;
     sqlite3_initialize();
-    sqlite3_open(dbName, &db);
+    int rc = sqlite3_open_v2(dbName, &db, sqliteOpenFlags(options), NULL);
+    if (rc == SQLITE_OK) {
+        rc = sqliteApplyOpenOptions(db, options);
+    }
+    if (rc != SQLITE_OK) {  // handle is allocated even on failed open
+        sqlite3_close(db);
+        return NULL;
+    }
+    if (sqliteConnectionRegister(db) == NULL) {    // transactions, deadlines and statement cache need wrapper state
+        sqlite3_close(db);
+        return NULL;
+    }
+    // Wrapper handler replaces sqlite3_busy_timeout(), so lock waits are retried with backoff and measured
+    BusyPolicy busyPolicy = {.timeoutMs = options != NULL ? options->busyTimeoutMs : SQLITE_DEFAULT_BUSY_TIMEOUT_MS};
+    if (sqliteSetBusyPolicy(db, &busyPolicy) != SQLITE_OK) {
+        sqlite3_busy_timeout(db, (int) busyPolicy.timeoutMs);
+    }
     return db;
 }
 
 ResultSet *executeQuery(sqlite3 *db, const char *sql, str_DbValueMap *queryParams) {
-    QueryString *query = namedQueryString(sql, queryParams);
-    sqlite3_stmt *stmt = tryExecuteStep(db, query->value);
-    ResultSet *resultSet = stmt != NULL ? newSqliteResultSet(db, stmt) : NULL;
-    deleteQueryString(query);
+    return executeQueryWithArena(db, NULL, sql, queryParams);
+}
+
+ResultSet *executeQueryWithArena(sqlite3 *db, SqliteArena *arena, const char *sql, str_DbValueMap *queryParams) {
+    SqliteStatement *statement = acquireStatement(db, sql, queryParams, true);   // values are used after return
+    if (statement == NULL) return NULL;
+
+    ResultSet *resultSet = newStatementResultSet(statement, arena);
+    if (resultSet == NULL) {
+        sqliteStatementRelease(statement);
+        return NULL;
+    }
     return resultSet;
 }
 
 int executeUpdate(sqlite3 *db, const char *sql, str_DbValueMap *queryParams) {
-    QueryString *query = namedQueryString(sql, queryParams);
-    int rc = tryExecuteUpdate(db, query->value);
-    deleteQueryString(query);
+    SqliteStatement *statement = acquireStatement(db, sql, queryParams, false);
+    if (statement == NULL) {
+        return statementErrorCode(db);
+    }
+
+    int rc = sqliteStatementStep(statement);
+    sqliteStatementRelease(statement);
+    return rc != SQLITE_DONE ? rc : SQLITE_OK;
+}
+
+ResultSet *executeQueryWithList(sqlite3 *db, const char *sql, const SqlParamList *params, int *rc) {
+    int result;
+    SqliteStatement *statement = acquireListStatement(db, sql, params, NULL, true, &result);
+    return listStatementResultSet(statement, result, rc);
+}
+
+ResultSet *executeQueryWithValues(sqlite3 *db, const char *sql, const SqlValueList *values, int *rc) {
+    int result;
+    SqliteStatement *statement = acquireListStatement(db, sql, NULL, values, true, &result);
+    return listStatementResultSet(statement, result, rc);
+}
+
+int executeUpdateWithList(sqlite3 *db, const char *sql, const SqlParamList *params) {
+    int rc;
+    SqliteStatement *statement = acquireListStatement(db, sql, params, NULL, false, &rc);
+    return statement != NULL ? stepListStatement(statement) : rc;
+}
+
+int executeUpdateWithValues(sqlite3 *db, const char *sql, const SqlValueList *values) {
+    int rc;
+    SqliteStatement *statement = acquireListStatement(db, sql, NULL, values, false, &rc);
+    return statement != NULL ? stepListStatement(statement) : rc;
+}
+
+int executeStructUpdate(sqlite3 *db, const char *sql, const RowMapping *mapping, const void *row) {
+    SqliteStatement *statement = sqliteAcquireStatement(db, sql);
+    if (statement == NULL) {
+        return statementErrorCode(db);
+    }
+
+    StructBinding binding;
+    int rc = sqliteStructBindingInit(&binding, statement, mapping);
+    if (rc == SQLITE_OK) {
+        rc = sqliteStatementBindStruct(statement, &binding, row);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqliteStatementStep(statement);
+        rc = rc != SQLITE_DONE ? rc : SQLITE_OK;
+    }
+    sqliteStatementRelease(statement);
+    return rc;
+}
+
+ResultSet *executeQueryWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline, int *rc) {
+    DeadlineState queryDeadline;
+    int result = sqliteDeadlineInit(&queryDeadline, db, deadline);
+    SqliteStatement *statement = result == SQLITE_OK ? acquireStatement(db, sql, queryParams, true) : NULL;
+    if (statement != NULL) {
+        statement->deadline = queryDeadline;    // kept until cursor is completed or deleted
+    } else if (result == SQLITE_OK) {
+        sqliteDeadlineDisarm(&queryDeadline);
+        result = statementErrorCode(db);
+    }
+    return listStatementResultSet(statement, result, rc);
+}
+
+int executeUpdateWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline) {
+    DeadlineState updateDeadline;
+    int rc = sqliteDeadlineInit(&updateDeadline, db, deadline);
+    if (rc != SQLITE_OK) return rc;
+    DeadlineState *previous = sqliteDeadlineEnter(&updateDeadline);
+    rc = executeUpdate(db, sql, queryParams);
+    sqliteDeadlineLeave(&updateDeadline, previous);
+    sqliteDeadlineDisarm(&updateDeadline);
     return rc;
 }
 
 ResultSet *executeCallbackQuery(sqlite3 *db, const char *sql, str_DbValueMap *queryParams) {
-    QueryString *query = namedQueryString(sql, queryParams);
-    char *errorMessage = NULL;
-    ResultSet *rs = newSqliteResultSet(db, NULL);
-    int rc = sqlite3_exec(db, query->value, sqliteValueMapperCallback, (void *) rs, &errorMessage);
+    return executeCallbackQueryWithArena(db, NULL, sql, queryParams);
+}
+
+ResultSet *executeCallbackQueryWithArena(sqlite3 *db, SqliteArena *arena, const char *sql, str_DbValueMap *queryParams) {
+    ResultSet *rs = newSqliteResultSetWithArena(db, NULL, arena);
+    if (rs == NULL) return NULL;
 
+    int rc = executeCallbackSql(db, sql, queryParams, sqliteValueMapperCallback, rs);
     if (rc != SQLITE_OK) {
-        sqlite3_free(errorMessage);
-        deleteQueryString(query);
         resultSetDelete(rs);
         return NULL;
     }
-    deleteQueryString(query);
+    return rs;
+}
+
+ResultSet *executeCallbackQueryWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline, int *rc) {
+    DeadlineState queryDeadline;
+    int result = sqliteDeadlineInit(&queryDeadline, db, deadline);
+    ResultSet *rs = result == SQLITE_OK ? newSqliteResultSet(db, NULL) : NULL;
+    if (rs != NULL) {
+        DeadlineState *previous = sqliteDeadlineEnter(&queryDeadline);
+        result = executeCallbackSql(db, sql, queryParams, sqliteValueMapperCallback, rs);
+        sqliteDeadlineLeave(&queryDeadline, previous);
+        if (result != SQLITE_OK) {
+            resultSetDelete(rs);
+            rs = NULL;
+        }
+    } else if (result == SQLITE_OK) {
+        result = SQLITE_NOMEM;
+    }
+    sqliteDeadlineDisarm(&queryDeadline);
+    if (rc != NULL) {
+        *rc = result;
+    }
     return rs;
 }
 
 int executeCallbackUpdate(sqlite3 *db, const char *sql, str_DbValueMap *queryParams) {
-    QueryString *query = namedQueryString(sql, queryParams);
-    char *errorMessage = NULL;
-    int rc = sqlite3_exec(db, query->value, NULL, NULL, &errorMessage);
-    sqlite3_free(errorMessage);
-    deleteQueryString(query);
-    return rc;
+    return executeCallbackSql(db, sql, queryParams, NULL, NULL);
 }
 
 bool idDbColumnExists(sqlite3 *db, const char *table, const char *columnName) {
-    QueryString *sql = queryStringOf("PRAGMA table_info(%s)", table);
-    char **result = NULL;
-    int row = 0;
-    int col = 0;
-    char *err = NULL;
-    sqlite3_get_table(db, sql->value, &result, &row, &col, &err);
-
-    int idx = col;
-    bool exist = false;
-    for (int i = 0; i < row; i++) {
-        if (strcmp(result[idx + 1], columnName) == 0) {
-            exist = true;
-            break;
-        }
-
-        idx += col;
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) {
+        SchemaTable *schemaTable = newSchemaTable(db, table);
+        bool exist = schemaTableColumnIndex(schemaTable, columnName) >= 0;
+        deleteSchemaTable(schemaTable);
+        return exist;
     }
-
-    sqlite3_free_table(result);
-    deleteQueryString(sql);
-    return exist;
+    return schemaTableColumnIndex(sqliteGetTableSchema(db, table), columnName) >= 0;
 }
 
 Vector getDbTableColumnNames(sqlite3 *db, const char *table) {
-    QueryString *sql = queryStringOf("PRAGMA table_info(%s)", table);
-    char **result = NULL;
-    int row = 0;
-    int column = 0;
-    char *errmsg = NULL;
-    sqlite3_get_table(db, sql->value, &result, &row, &column, &errmsg);
-
-    Vector columns = getVectorInstance(row);
-    int idx = column;
-    for (int i = 0; i < row; i++) {
-        const char *columnName = result[idx + 1];
-        vectorAdd(columns, strdup(columnName));
-        idx += column;
-    }
-
-    sqlite3_free_table(result);
-    deleteQueryString(sql);
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    SchemaTable *uncachedTable = connection == NULL ? newSchemaTable(db, table) : NULL;
+    const SchemaTable *schemaTable = connection != NULL ? sqliteGetTableSchema(db, table) : uncachedTable;
+
+    uint32_t columnCount = schemaTable != NULL ? schemaTable->columnCount : 0;
+    Vector columns = getVectorInstance(columnCount);
+    for (uint32_t i = 0; i < columnCount; i++) {
+        vectorAdd(columns, strdup(schemaTable->columns[i].name));
+    }
+    deleteSchemaTable(uncachedTable);
     return columns;
 }
 
+const SchemaTable *sqliteGetTableSchema(sqlite3 *db, const char *table) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return NULL;
+    if (connection->schemaCache == NULL) {
+        connection->schemaCache = newSchemaCache(db);
+    }
+    return schemaCacheGetTable(connection->schemaCache, table);
+}
+
 void deleteDbColumnNameVector(Vector columns) {
     for (int i = 0; i < getVectorSize(columns); i++) {
         free(vectorGet(columns, i));
@@ -105,38 +218,167 @@ void deleteDbColumnNameVector(Vector columns) {
     vectorDelete(columns);
 }
 
+void sqliteSetStatementCacheCapacity(sqlite3 *db, uint32_t capacity) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL) {
+        statementCacheSetCapacity(connection->statementCache, capacity);
+    }
+}
+
+StatementCacheStats sqliteGetStatementCacheStats(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    return statementCacheGetStats(connection != NULL ? connection->statementCache : NULL);
+}
+
+int sqliteEnableQueryStats(sqlite3 *db, const QueryStatsOptions *options) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection == NULL) return SQLITE_MISUSE;
+    if (connection->queryStats == NULL) {
+        connection->queryStats = newQueryStatsRegistry(db);
+        if (connection->queryStats == NULL) return SQLITE_NOMEM;
+    }
+    return queryStatsEnable(connection->queryStats, options);
+}
+
+void sqliteDisableQueryStats(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL) {
+        queryStatsDisable(connection->queryStats);
+    }
+}
+
+uint32_t sqliteGetQueryStats(sqlite3 *db, QueryStats *stats, uint32_t maxCount) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    return queryStatsSnapshot(connection != NULL ? connection->queryStats : NULL, stats, maxCount);
+}
+
+void sqliteResetQueryStats(sqlite3 *db) {
+    SqliteConnection *connection = sqliteConnectionOf(db);
+    if (connection != NULL) {
+        queryStatsReset(connection->queryStats);
+    }
+}
+
 void sqliteDbClose(sqlite3 *db) {
     if (db != NULL) {
+        sqliteConnectionUnregister(db);  // cached statements should be finalized before close
         sqlite3_close(db);
     }
 }
 
-static sqlite3_stmt *tryExecuteStep(sqlite3 *db, const char *sql) {
-    sqlite3_stmt *stmt = NULL;
-    sqlite3_prepare_v2(db, sql, (int) strlen(sql), &stmt, NULL);
-    return stmt;
+static SqliteStatement *acquireStatement(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, bool copyValues) {
+    SqliteStatement *statement = sqliteAcquireStatement(db, sql);
+    if (statement == NULL) return NULL;
+
+    int rc = sqliteStatementBind(statement, queryParams, copyValues);
+    if (rc != SQLITE_OK) {
+        sqliteStatementRelease(statement);
+        return NULL;
+    }
+    return statement;
+}
+
+// Values list is used when 'params' is NULL
+static SqliteStatement *acquireListStatement(sqlite3 *db, const char *sql, const SqlParamList *params, const SqlValueList *values, bool copyValues, int *rc) {
+    SqliteStatement *statement = sqliteAcquireStatement(db, sql);
+    if (statement == NULL) {
+        *rc = statementErrorCode(db);
+        return NULL;
+    }
+
+    *rc = params != NULL ? sqliteStatementBindList(statement, params, copyValues) : sqliteStatementBindValues(statement, values, copyValues);
+    if (*rc != SQLITE_OK) {
+        sqliteStatementRelease(statement);
+        return NULL;
+    }
+    return statement;
+}
+
+static ResultSet *listStatementResultSet(SqliteStatement *statement, int result, int *rc) {
+    ResultSet *resultSet = statement != NULL ? newStatementResultSet(statement, NULL) : NULL;
+    if (statement != NULL && resultSet == NULL) {
+        sqliteStatementRelease(statement);
+        result = SQLITE_NOMEM;
+    }
+    if (rc != NULL) {
+        *rc = result;
+    }
+    return resultSet;
+}
+
+static int stepListStatement(SqliteStatement *statement) {
+    int rc = sqliteStatementStep(statement);
+    sqliteStatementRelease(statement);
+    return rc != SQLITE_DONE ? rc : SQLITE_OK;
 }
 
-static int tryExecuteUpdate(sqlite3 *db, const char *sql) {
-    sqlite3_stmt *stmt = NULL;
-    sqlite3_prepare_v2(db, sql, (int) strlen(sql), &stmt, NULL);
+// Same as sqlite3_exec(), but with bound named parameters. First statement is taken from cache
+static int executeCallbackSql(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, StatementRowCallback callback, void *userData) {
+    SqliteStatement *statement = acquireStatement(db, sql, queryParams, false);
+    if (statement == NULL) {
+        return statementErrorCode(db);
+    }
 
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = stepStatementRows(statement->stmt, callback, userData);
+    const char *tailSql = statement->tailSql;
+    while (rc == SQLITE_OK && tailSql != NULL && *tailSql != '\0') {
+        sqlite3_stmt *stmt = NULL;
+        rc = sqlite3_prepare_v2(db, tailSql, -1, &stmt, &tailSql);
+        if (rc != SQLITE_OK || stmt == NULL) break;   // only whitespaces or comments left
+
+        queryStatsTailBegin(statement, stmt);
+        rc = sqliteBindParams(stmt, statement->paramNames, queryParams, false);
+        if (rc == SQLITE_OK) {
+            rc = stepStatementRows(stmt, callback, userData);
+        }
+        queryStatsTailEnd(statement, stmt);
+        sqlite3_finalize(stmt);
+    }
+
+    sqliteStatementRelease(statement);
+    return sqliteDeadlineResult(db, rc);
+}
+
+static int stepStatementRows(sqlite3_stmt *stmt, StatementRowCallback callback, void *userData) {
+    int columnCount = sqlite3_column_count(stmt);
+    char **columnValues = NULL;
+    char **columnNames = NULL;
+    uint32_t *valueLengths = NULL;
+    if (callback != NULL && columnCount > 0) {
+        columnValues = malloc((sizeof(char *) * 2 + sizeof(uint32_t)) * columnCount);
+        if (columnValues == NULL) return SQLITE_NOMEM;
+        columnNames = columnValues + columnCount;
+        valueLengths = (uint32_t *) (columnNames + columnCount);
+        for (int i = 0; i < columnCount; i++) {
+            columnNames[i] = (char *) sqlite3_column_name(stmt, i);
+        }
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (columnValues == NULL) continue;
+        for (int i = 0; i < columnCount; i++) {
+            columnValues[i] = (char *) sqlite3_column_text(stmt, i);
+            valueLengths[i] = (uint32_t) sqlite3_column_bytes(stmt, i);    // called after text, blob is not converted
+        }
+
+        rc = callback(userData, columnCount, columnValues, valueLengths, columnNames);
+        if (rc != SQLITE_OK) break;
+    }
+
+    free(columnValues);
     return rc != SQLITE_DONE ? rc : SQLITE_OK;
 }
 
-static int sqliteValueMapperCallback(void *userData, int valueCount, char **values, char **tableColumnNames) {
-    ResultSet *rs = (ResultSet *) userData;
-    initSingletonHashMap(&rs->columnMap, valueCount * 2);
-    initSingletonVector(&rs->valueVec, 128);
-    HashMap valueMap = getHashMapInstance(valueCount);
+static int statementErrorCode(sqlite3 *db) {
+    int rc = sqlite3_errcode(db);
+    return rc != SQLITE_OK ? rc : SQLITE_MISUSE;    // empty or not valid sql
+}
 
-    for (int i = 0; i < valueCount; i++) {
-        char *columnName = strdup(tableColumnNames[i]);
-        hashMapPut(valueMap, columnName, (MapValueType) strdup(values[i]));
-        hashMapPut(rs->columnMap, columnName, (MapValueType) i);
+static int sqliteValueMapperCallback(void *userData, int valueCount, char **values, const uint32_t *valueLengths, char **tableColumnNames) {
+    ResultSet *rs = (ResultSet *) userData;
+    if (rs->columnNames != NULL && (uint32_t) valueCount != rs->columnCount) {
+        return SQLITE_MISMATCH;     // statements of multi statement sql return different columns
     }
-    vectorAdd(rs->valueVec, valueMap);
-    return SQLITE_OK;
+    return resultSetAppendRowWithLengths(rs, valueCount, values, valueLengths, tableColumnNames) ? SQLITE_OK : SQLITE_NOMEM;
 }
@@ -0,0 +1,207 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <time.h>
+#include "SqliteWrapper.h"
+
+// Lives on submitter stack until writer marks it done
+struct WriteQueueItem {
+    const char *sql;
+    str_DbValueMap *queryParams;
+    int rc;
+    bool isDone;
+    struct WriteQueueItem *next;
+};
+
+static void *runQueueWriter(void *arg);
+static WriteQueueItem *takeQueuedItems(SqliteWriteQueue *queue);
+static void waitFlushWindow(SqliteWriteQueue *queue);
+static WriteQueueItem *executeInTransaction(SqliteWriteQueue *queue, WriteQueueItem *first, uint64_t *flushCount);
+static void failExecutedItems(WriteQueueItem *first, WriteQueueItem *end, int rc);
+
+
+SqliteWriteQueue *newSqliteWriteQueue(const char *dbName, const WriteQueueOptions *options) {
+    if (dbName == NULL) return NULL;
+    SqliteWriteQueue *queue = calloc(1, sizeof(struct SqliteWriteQueue));
+    if (queue == NULL) return NULL;
+
+    SqliteOpenOptions openOptions = options != NULL && options->openOptions != NULL ? *options->openOptions : *SQLITE_DURABLE_OPTIONS;
+    openOptions.openFlags |= SQLITE_OPEN_NOMUTEX;
+    queue->db = sqliteDbInitWithOptions(dbName, &openOptions);
+    if (queue->db == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->maxBatchItems = options != NULL && options->maxBatchItems > 0 ? options->maxBatchItems : SQLITE_WRITE_QUEUE_MAX_BATCH;
+    queue->flushWindowMicros = options != NULL ? options->flushWindowMicros : 0;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->itemAdded, NULL);
+    pthread_cond_init(&queue->itemDone, NULL);
+
+    if (pthread_create(&queue->writer, NULL, runQueueWriter, queue) != 0) {
+        pthread_cond_destroy(&queue->itemDone);
+        pthread_cond_destroy(&queue->itemAdded);
+        pthread_mutex_destroy(&queue->mutex);
+        sqliteDbClose(queue->db);
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+int writeQueueExecuteUpdate(SqliteWriteQueue *queue, const char *sql, str_DbValueMap *queryParams) {
+    if (queue == NULL || sql == NULL) return SQLITE_MISUSE;
+    WriteQueueItem item = {.sql = sql, .queryParams = queryParams, .rc = SQLITE_OK};
+
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->isStopping) {
+        pthread_mutex_unlock(&queue->mutex);
+        return SQLITE_MISUSE;
+    }
+    if (queue->tail != NULL) {
+        queue->tail->next = &item;
+    } else {
+        queue->head = &item;
+    }
+    queue->tail = &item;
+    queue->queuedCount++;
+    pthread_cond_signal(&queue->itemAdded);
+
+    while (!item.isDone) {
+        pthread_cond_wait(&queue->itemDone, &queue->mutex);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return item.rc;
+}
+
+WriteQueueStats writeQueueGetStats(SqliteWriteQueue *queue) {
+    if (queue == NULL) return (WriteQueueStats) {0};
+    pthread_mutex_lock(&queue->mutex);
+    WriteQueueStats stats = queue->stats;
+    pthread_mutex_unlock(&queue->mutex);
+    return stats;
+}
+
+void deleteSqliteWriteQueue(SqliteWriteQueue *queue) {
+    if (queue == NULL) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->isStopping = true;
+    pthread_cond_signal(&queue->itemAdded);
+    pthread_mutex_unlock(&queue->mutex);
+    pthread_join(queue->writer, NULL);
+
+    pthread_cond_destroy(&queue->itemDone);
+    pthread_cond_destroy(&queue->itemAdded);
+    pthread_mutex_destroy(&queue->mutex);
+    sqliteDbClose(queue->db);
+    free(queue);
+}
+
+// Updates submitted while previous transaction is committed are combined into the next one
+static void *runQueueWriter(void *arg) {
+    SqliteWriteQueue *queue = (SqliteWriteQueue *) arg;
+    for (;;) {
+        pthread_mutex_lock(&queue->mutex);
+        while (queue->head == NULL && !queue->isStopping) {
+            pthread_cond_wait(&queue->itemAdded, &queue->mutex);
+        }
+        if (queue->head == NULL) {     // stopped and drained
+            pthread_mutex_unlock(&queue->mutex);
+            break;
+        }
+        waitFlushWindow(queue);
+        WriteQueueItem *items = takeQueuedItems(queue);
+        pthread_mutex_unlock(&queue->mutex);
+
+        uint64_t flushCount = 0;
+        WriteQueueItem *item = items;
+        while (item != NULL) {
+            item = executeInTransaction(queue, item, &flushCount);
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        queue->stats.flushCount += flushCount;
+        for (item = items; item != NULL;) {
+            WriteQueueItem *next = item->next;  // item can be released by submitter right after it is done
+            queue->stats.itemCount++;
+            queue->stats.failedCount += item->rc != SQLITE_OK;
+            item->isDone = true;
+            item = next;
+        }
+        pthread_cond_broadcast(&queue->itemDone);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+    return NULL;
+}
+
+// Called under mutex, takes up to maxBatchItems from queue head
+static WriteQueueItem *takeQueuedItems(SqliteWriteQueue *queue) {
+    WriteQueueItem *items = queue->head;
+    WriteQueueItem *last = items;
+    for (uint32_t i = 1; i < queue->maxBatchItems && last->next != NULL; i++) {
+        last = last->next;
+    }
+    queue->head = last->next;
+    if (queue->head == NULL) {
+        queue->tail = NULL;
+        queue->queuedCount = 0;
+    } else {
+        queue->queuedCount -= queue->maxBatchItems;
+    }
+    last->next = NULL;
+    return items;
+}
+
+// Called under mutex
+static void waitFlushWindow(SqliteWriteQueue *queue) {
+    if (queue->flushWindowMicros == 0) return;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t nanos = (uint64_t) deadline.tv_nsec + (uint64_t) queue->flushWindowMicros * 1000;
+    deadline.tv_sec += (time_t) (nanos / 1000000000);
+    deadline.tv_nsec = (long) (nanos % 1000000000);
+
+    while (queue->queuedCount < queue->maxBatchItems && !queue->isStopping) {
+        if (pthread_cond_timedwait(&queue->itemAdded, &queue->mutex, &deadline) != 0) break;
+    }
+}
+
+// Each update is a single statement, so failed one is rolled back by sqlite without savepoint.
+// Returns first item that is not executed yet, when error has rolled back whole transaction
+static WriteQueueItem *executeInTransaction(SqliteWriteQueue *queue, WriteQueueItem *first, uint64_t *flushCount) {
+    int rc = executeUpdate(queue->db, "BEGIN IMMEDIATE", NULL);
+    if (rc != SQLITE_OK) {
+        for (WriteQueueItem *item = first; item != NULL; item = item->next) {
+            item->rc = rc;
+        }
+        return NULL;
+    }
+
+    for (WriteQueueItem *item = first; item != NULL; item = item->next) {
+        item->rc = executeUpdate(queue->db, item->sql, item->queryParams);
+        if (item->rc != SQLITE_OK && sqlite3_get_autocommit(queue->db) != 0) {    // e.g. SQLITE_FULL or SQLITE_IOERR
+            failExecutedItems(first, item, item->rc);
+            return item->next;
+        }
+    }
+
+    rc = executeUpdate(queue->db, "COMMIT", NULL);
+    if (rc != SQLITE_OK) {
+        if (sqlite3_get_autocommit(queue->db) == 0) {
+            executeUpdate(queue->db, "ROLLBACK", NULL);
+        }
+        failExecutedItems(first, NULL, rc);
+        return NULL;
+    }
+    (*flushCount)++;
+    return NULL;
+}
+
+static void failExecutedItems(WriteQueueItem *first, WriteQueueItem *end, int rc) {
+    for (WriteQueueItem *item = first; item != end; item = item->next) {
+        if (item->rc == SQLITE_OK) {
+            item->rc = rc;
+        }
+    }
+}
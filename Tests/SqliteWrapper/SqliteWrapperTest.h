@@ -4,6 +4,7 @@
 #include "SqliteParameter.h"
 #include "SqliteQuery.h"
 #include "SqliteWrapper.h"
+#include "SqliteClock.h"
 
 
 static MunitResult sqlLiteParameterTest(const MunitParameter params[], void *data) {
@@ -248,12 +249,2028 @@ static MunitResult sqlLiteCallbackTest(const MunitParameter params[], void *data
     return MUNIT_OK;
 }
 
+static MunitResult sqlLiteStatementCacheTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    sqliteSetStatementCacheCapacity(db, 3);
+
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_2(id INTEGER PRIMARY KEY, value INTEGER, data TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    for (int i = 0; i < 10; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_2 VALUES (NULL, :int_val, :data_text)", SQL_PARAM_MAP("int_val", i, "data_text", "time is 12:30"));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    StatementCacheStats stats = sqliteGetStatementCacheStats(db);
+    assert_uint32(2, ==, stats.size);
+    assert_uint64(9, ==, stats.hits);
+    assert_uint64(2, ==, stats.misses);
+
+    // same statement is reused and rebound, parameters inside literals and comments are not resolved
+    char *queryStr = "SELECT * FROM test_2 WHERE value = :int_val AND data = 'time is 12:30' /* :int_val */";
+    ResultSet *rs = executeQuery(db, queryStr, SQL_PARAM_MAP("int_val", 4));
+    assert_not_null(rs);
+    assert_true(nextResultSet(rs));
+    assert_int(4, ==, rsGetInt(rs, "value"));
+    assert_string_equal("time is 12:30", rsGetString(rs, "data"));
+
+    // statement still in use by first result set, should be prepared separately
+    ResultSet *rs_2 = executeQuery(db, queryStr, SQL_PARAM_MAP("int_val", 7));
+    assert_not_null(rs_2);
+    assert_true(nextResultSet(rs_2));
+    assert_int(7, ==, rsGetInt(rs_2, "value"));
+    assert_false(nextResultSet(rs_2));
+    resultSetDelete(rs_2);
+    resultSetDelete(rs);    // deleted before end, should release statement
+
+    rs = executeQuery(db, queryStr, SQL_PARAM_MAP("int_val", 8));
+    assert_true(nextResultSet(rs));
+    assert_int(8, ==, rsGetInt(rs, "value"));
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "DELETE FROM test_2 WHERE value > :int_val", SQL_PARAM_MAP("int_val", 5));
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int(4, ==, sqlite3_changes(db));
+
+    stats = sqliteGetStatementCacheStats(db);
+    assert_uint32(3, ==, stats.size);
+    assert_uint32(3, ==, stats.capacity);
+    assert_uint64(1, ==, stats.evictions);
+
+    // each open connection keeps own wrapper state
+    sqlite3 *memoryDbs[100];
+    for (int i = 0; i < 100; i++) {
+        memoryDbs[i] = sqliteDbInit(":memory:");
+        assert_not_null(memoryDbs[i]);
+    }
+    for (int i = 0; i < 100; i++) {
+        assert_ptr_equal(memoryDbs[i], sqliteConnectionOf(memoryDbs[i])->db);
+        assert_int(SQLITE_OK, ==, sqliteBeginTransaction(memoryDbs[i], TRANSACTION_DEFERRED));
+        assert_int(SQLITE_OK, ==, sqliteCommitTransaction(memoryDbs[i]));
+    }
+    for (int i = 0; i < 100; i += 2) {
+        sqliteDbClose(memoryDbs[i]);
+    }
+    for (int i = 1; i < 100; i += 2) {
+        assert_ptr_equal(memoryDbs[i], sqliteConnectionOf(memoryDbs[i])->db);     // found after other connections are removed
+        sqliteDbClose(memoryDbs[i]);
+    }
+    sqlite3 **registeredDbs = calloc(SQLITE_MAX_CONNECTIONS, sizeof(sqlite3 *));
+    int registeredCount = 0;
+    while (registeredCount < SQLITE_MAX_CONNECTIONS && (registeredDbs[registeredCount] = sqliteDbInit(":memory:")) != NULL) {
+        registeredCount++;
+    }
+    assert_int(SQLITE_MAX_CONNECTIONS - 1, ==, registeredCount);     // first db is still open
+    assert_null(sqliteDbInit(":memory:"));      // connection without wrapper state is not returned
+    for (int i = 0; i < registeredCount; i++) {
+        sqliteDbClose(registeredDbs[i]);
+    }
+    free(registeredDbs);
+
+    rc = executeUpdate(db, "DROP TABLE test_2", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteParameterBindingTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    // multiple statements with shared parameters
+    int rc = executeCallbackUpdate(db, "CREATE TABLE IF NOT EXISTS test_3(id INTEGER PRIMARY KEY, value INTEGER, data TEXT, param DOUBLE);"
+                                       "INSERT INTO test_3 VALUES (NULL, :int_val, :data_text, :decimal_param);"
+                                       "INSERT INTO test_3 VALUES (NULL, :int_val + 1, :data_text, NULL);", SQL_PARAM_MAP("int_val", 1, "data_text", "O'Reilly", "decimal_param", 0.1234567891));
+    assert_int(SQLITE_OK, ==, rc);
+
+    // values are bound as is, without quoting and formatting
+    rc = executeUpdate(db, "INSERT INTO test_3 VALUES (NULL, :int_val, :data_text, :decimal_param)",
+                       SQL_PARAM_MAP("int_val", INT64_MAX, "data_text", "'); DROP TABLE test_3; --", "decimal_param", 1e-10));
+    assert_int(SQLITE_OK, ==, rc);
+
+    ResultSet *rs = executeCallbackQuery(db, "SELECT * FROM test_3 WHERE data = :data_text ORDER BY id", SQL_PARAM_MAP("data_text", "O'Reilly"));
+    assert_not_null(rs);
+    assert_true(nextResultSet(rs));
+    assert_int(1, ==, rsGetInt(rs, "value"));
+    assert_double_equal(0.1234567891, rsGetDouble(rs, "param"), 9);
+    assert_true(nextResultSet(rs));
+    assert_int(2, ==, rsGetInt(rs, "value"));
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    rs = executeQuery(db, "SELECT * FROM test_3 WHERE value = :int_val", SQL_PARAM_MAP("int_val", INT64_MAX));
+    assert_not_null(rs);
+    assert_true(nextResultSet(rs));
+    assert_int64(INT64_MAX, ==, rsGetI64(rs, "value"));
+    assert_string_equal("'); DROP TABLE test_3; --", rsGetString(rs, "data"));
+    assert_double_equal(1e-10, rsGetDouble(rs, "param"), 12);
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    assert_null(executeCallbackQuery(db, "SELECT * FROM not_exist WHERE id = :id", SQL_PARAM_MAP("id", 1)));
+    assert_int(SQLITE_ERROR, ==, executeCallbackUpdate(db, "DROP TABLE not_exist", NULL));
+
+    rc = executeCallbackUpdate(db, "DROP TABLE test_3", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static str_DbValueMap *batchTestRowSupplier(void *context, uint64_t rowIndex) {
+    str_DbValueMap *row = (str_DbValueMap *) context;
+    if (rowIndex >= 25) return NULL;
+    str_DbValueMapAdd(row, "int_val", DB_VALUE((int64_t) rowIndex));
+    return row;
+}
+
+typedef struct BatchPendingTestContext {
+    str_DbValueMap *row;
+    sqlite3 *db;
+    uint32_t pendingCount;
+    bool isCommittedWhilePending;
+} BatchPendingTestContext;
+
+// Second row is late, supplier reports pending while waiting for it
+static str_DbValueMap *batchTestPendingSupplier(void *context, uint64_t rowIndex) {
+    BatchPendingTestContext *testContext = (BatchPendingTestContext *) context;
+    if (rowIndex >= 2) return NULL;
+    if (rowIndex == 1 && testContext->pendingCount < 3) {
+        testContext->pendingCount++;
+        testContext->isCommittedWhilePending |= sqlite3_get_autocommit(testContext->db) != 0;
+        sqlite3_sleep(5);
+        return SQLITE_BATCH_ROW_PENDING;
+    }
+    str_DbValueMapAdd(testContext->row, "int_val", DB_VALUE((int64_t) (300 + rowIndex)));
+    return testContext->row;
+}
+
+static MunitResult sqlLiteBatchUpdateTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_4(id INTEGER PRIMARY KEY, value INTEGER UNIQUE, data TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    str_DbValueMap *rows[] = {
+            SQL_PARAM_MAP("int_val", 100, "data_text", "one"),
+            SQL_PARAM_MAP("int_val", 101, "data_text", "two"),
+            SQL_PARAM_MAP("int_val", 102, "data_text", "three"),
+    };
+    BatchStats stats;
+    rc = executeBatchUpdate(db, "INSERT INTO test_4 VALUES (NULL, :int_val, :data_text)", rows, ARRAY_SIZE(rows), NULL, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint64(3, ==, stats.rowsWritten);
+    assert_uint32(1, ==, stats.batchCount);
+
+    BatchOptions options = {.commitRows = 10};
+    str_DbValueMap *row = NEW_SQL_PARAM_MAP(2);
+    str_DbValueMapAdd(row, "data_text", DB_VALUE("supplied"));
+    rc = executeBatchUpdateFrom(db, "INSERT INTO test_4 VALUES (NULL, :int_val, :data_text)", batchTestRowSupplier, row, &options, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint64(25, ==, stats.rowsWritten);
+    assert_uint32(3, ==, stats.batchCount);
+    assert_true(stats.maxBatchMicros >= stats.lastBatchMicros);
+    assert_true(sqlite3_get_autocommit(db));
+
+    // open transaction is committed by interval while producer is idle
+    BatchPendingTestContext pendingContext = {.row = row, .db = db};
+    options = (BatchOptions) {.commitIntervalMs = 5};
+    rc = executeBatchUpdateFrom(db, "INSERT INTO test_4 VALUES (NULL, :int_val, :data_text)", batchTestPendingSupplier, &pendingContext, &options, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint64(2, ==, stats.rowsWritten);
+    assert_uint32(2, ==, stats.batchCount);
+    assert_true(pendingContext.isCommittedWhilePending);
+
+    rc = executeBatchUpdate(db, "INSERT INTO test_4 VALUES (NULL, :int_val, NULL); DELETE FROM test_4", rows, ARRAY_SIZE(rows), NULL, &stats);
+    assert_int(SQLITE_MISUSE, ==, rc);
+
+    // unique constraint fails on last row, whole batch should be rolled back
+    str_DbValueMap *failedRows[] = {
+            SQL_PARAM_MAP("int_val", 200, "data_text", "new"),
+            SQL_PARAM_MAP("int_val", 100, "data_text", "duplicate"),
+    };
+    rc = executeBatchUpdate(db, "INSERT INTO test_4 VALUES (NULL, :int_val, :data_text)", failedRows, ARRAY_SIZE(failedRows), NULL, &stats);
+    assert_int(SQLITE_CONSTRAINT, ==, rc);
+    assert_uint64(0, ==, stats.rowsWritten);
+    assert_true(sqlite3_get_autocommit(db));
+
+    ResultSet *rs = executeQuery(db, "SELECT COUNT(*) AS total FROM test_4", NULL);
+    assert_true(nextResultSet(rs));
+    assert_int(30, ==, rsGetInt(rs, "total"));
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "DROP TABLE test_4", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteColumnBatchTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_5(id INTEGER PRIMARY KEY, value INTEGER, data TEXT, param DOUBLE)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= 10; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_5 VALUES (NULL, :int_val, :data_text, :decimal_param)",
+                           SQL_PARAM_MAP("int_val", i * 10, "data_text", i % 3 == 0 ? NULL : "text", "decimal_param", i * 0.5));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+
+    ResultSet *rs = executeQuery(db, "SELECT id, value, data, param FROM test_5 ORDER BY id", NULL);
+    assert_not_null(rs);
+    ColumnBatch *batch = newColumnBatch(4);
+    assert_not_null(batch);
+
+    int64_t valueSum = 0;
+    double paramSum = 0;
+    uint32_t textBytes = 0;
+    uint32_t nullCount = 0;
+    uint32_t batchCount = 0;
+    uint32_t rowCount;
+    while ((rowCount = rsFetchColumnBatch(rs, batch)) > 0) {
+        batchCount++;
+        assert_uint32(4, ==, batch->columnCount);
+        int dataIndex = columnBatchGetColumnIndex(batch, "data");
+        assert_int(2, ==, dataIndex);
+        assert_true(batch->columns[1].type == DB_VALUE_INT);
+        assert_true(batch->columns[3].type == DB_VALUE_REAL);
+
+        for (uint32_t row = 0; row < rowCount; row++) {
+            valueSum += batch->columns[1].intValues[row];
+            paramSum += batch->columns[3].doubleValues[row];
+            if (columnBatchIsNull(batch, dataIndex, row)) {
+                nullCount++;
+                continue;
+            }
+            uint32_t length;
+            const uint8_t *text = columnBatchGetBytes(batch, dataIndex, row, &length);
+            assert_memory_equal(4, "text", text);
+            textBytes += length;
+        }
+    }
+
+    assert_uint32(3, ==, batchCount);
+    assert_int64(550, ==, valueSum);
+    assert_double_equal(27.5, paramSum, 6);
+    assert_uint32(3, ==, nullCount);
+    assert_uint32(28, ==, textBytes);
+    resultSetDelete(rs);
+
+    // reused batch takes column types from own values
+    rs = executeQuery(db, "SELECT CASE WHEN id <= 4 THEN NULL WHEN id <= 8 THEN data ELSE value END AS mixed FROM test_5 ORDER BY id", NULL);
+    assert_uint32(4, ==, rsFetchColumnBatch(rs, batch));
+    assert_true(batch->columns[0].type == DB_VALUE_NULL);
+    assert_uint32(4, ==, rsFetchColumnBatch(rs, batch));
+    assert_true(batch->columns[0].type == DB_VALUE_TEXT);
+    assert_true(columnBatchIsNull(batch, 0, 1));    // id 6
+    uint32_t length;
+    assert_memory_equal(4, "text", columnBatchGetBytes(batch, 0, 0, &length));
+    assert_uint32(4, ==, length);
+    assert_uint32(2, ==, rsFetchColumnBatch(rs, batch));
+    assert_true(batch->columns[0].type == DB_VALUE_INT);
+    assert_int64(100, ==, batch->columns[0].intValues[1]);
+    assert_uint32(0, ==, rsFetchColumnBatch(rs, batch));
+    deleteColumnBatch(batch);
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "DROP TABLE test_5", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteCallbackResultSetTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    int rc = executeCallbackUpdate(db, "CREATE TABLE IF NOT EXISTS test_6(id INTEGER PRIMARY KEY, value INTEGER, data TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= 500; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_6 VALUES (NULL, :int_val, :data_text)", SQL_PARAM_MAP("int_val", i, "data_text", i % 2 == 0 ? "even" : NULL));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+
+    ResultSet *rs = executeCallbackQuery(db, "SELECT * FROM test_6 ORDER BY id", NULL);
+    assert_not_null(rs);
+    assert_uint32(500, ==, rs->rowCount);
+    assert_uint32(3, ==, rs->columnCount);
+
+    int64_t valueSum = 0;
+    int nullCount = 0;
+    while (nextResultSet(rs)) {
+        valueSum += rsGetI64ByIndex(rs, 1);
+        const char *dataStr = rsGetString(rs, "data");
+        if (dataStr == NULL) {
+            nullCount++;
+            assert_true(rsGetColumnType(rs, "data") == DB_VALUE_NULL);
+            assert_int(0, ==, rsGetIntByIndex(rs, 2));
+        } else {
+            assert_string_equal("even", rsGetStringByIndex(rs, 2));
+        }
+    }
+    assert_int64(125250, ==, valueSum);
+    assert_int(250, ==, nullCount);
+    resultSetDelete(rs);
+
+    rs = executeCallbackQuery(db, "SELECT * FROM test_6 WHERE id < 0", NULL);
+    assert_not_null(rs);
+    assert_false(nextResultSet(rs));
+    assert_null(rsGetString(rs, "data"));
+    assert_false(resultSetAppendRow(rs, 0, NULL, NULL));    // row without columns
+    assert_uint32(0, ==, rs->rowCount);
+    resultSetDelete(rs);
+
+    // statements with different columns can't share result set columns
+    rs = executeCallbackQuery(db, "SELECT 1 AS a; SELECT 2 AS b", NULL);
+    assert_not_null(rs);
+    assert_true(nextResultSet(rs));
+    assert_true(nextResultSet(rs));
+    assert_int(2, ==, rsGetIntByIndex(rs, 0));
+    resultSetDelete(rs);
+    assert_null(executeCallbackQuery(db, "SELECT 1 AS a; SELECT 2 AS a, 3 AS b", NULL));
+    assert_null(executeCallbackQueryWithDeadline(db, "SELECT 1 AS a; SELECT 2 AS a, 3 AS b", NULL, &(QueryDeadline) {0}, &rc));
+    assert_int(SQLITE_MISMATCH, ==, rc);
+
+    rc = executeCallbackUpdate(db, "DROP TABLE test_6", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteColumnHandleTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_9(id INTEGER PRIMARY KEY, value INTEGER)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= 100; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_9 VALUES (NULL, :int_val)", SQL_PARAM_MAP("int_val", i));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+
+    HashMap columnMap = NULL;
+    for (int run = 0; run < 2; run++) {
+        ResultSet *rs = executeQuery(db, "SELECT * FROM test_9", NULL);
+        assert_not_null(rs);
+        if (columnMap != NULL) {
+            assert_ptr_equal(columnMap, rs->columnMap);  // resolved once per prepared statement
+        }
+        columnMap = rs->columnMap;
+
+        int idColumn = rsColumnIndex(rs, "id");
+        int valueColumn = rsColumnIndex(rs, "value");
+        assert_int(0, ==, idColumn);
+        assert_int(1, ==, valueColumn);
+        assert_int(-1, ==, rsColumnIndex(rs, "not_existing"));
+
+        int64_t valueSum = 0;
+        while (nextResultSet(rs)) {
+            assert_true(rsGetColumnTypeByIndex(rs, valueColumn) == DB_VALUE_INT);
+            valueSum += rsGetI64ByIndex(rs, valueColumn);
+        }
+        assert_int64(5050, ==, valueSum);
+        assert_int(0, ==, rsColumnIndex(rs, "id"));    // map is kept until delete
+        resultSetDelete(rs);
+    }
+
+    // schema change re-prepares statement on first step, so 'SELECT *' columns are resolved again for the first result set
+    rc = executeUpdate(db, "ALTER TABLE test_9 RENAME TO test_9_old", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "CREATE TABLE test_9(value TEXT, id INTEGER)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "INSERT INTO test_9 VALUES ('y', 2)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    ResultSet *rs = executeQuery(db, "SELECT * FROM test_9", NULL);
+    assert_int(0, ==, rsColumnIndex(rs, "value"));
+    assert_int(1, ==, rsColumnIndex(rs, "id"));
+    assert_true(nextResultSet(rs));
+    assert_string_equal("y", rsGetString(rs, "value"));
+    assert_int(2, ==, rsGetInt(rs, "id"));
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "ALTER TABLE test_9 ADD COLUMN data TEXT DEFAULT 'z'", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rs = executeQuery(db, "SELECT * FROM test_9", NULL);
+    assert_true(nextResultSet(rs));
+    assert_string_equal("z", rsGetString(rs, "data"));
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "DROP TABLE test_9_old", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "DROP TABLE test_9", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static void queryStatsTestSink(void *context, const QueryExecution *execution) {
+    uint64_t *rowsReturned = context;
+    *rowsReturned += execution->rowsReturned;
+}
+
+static MunitResult sqlLiteQueryStatsTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    assert_uint32(0, ==, sqliteGetQueryStats(db, NULL, 0));
+
+    uint64_t sinkRows = 0;
+    int rc = sqliteEnableQueryStats(db, &(QueryStatsOptions) {.captureQueryPlan = true, .sink = queryStatsTestSink, .sinkContext = &sinkRows});
+    assert_int(SQLITE_OK, ==, rc);
+
+    rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_10(id INTEGER PRIMARY KEY, value INTEGER, data TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= 20; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_10 VALUES (NULL, :int_val, :data_text)", SQL_PARAM_MAP("int_val", i, "data_text", "text"));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    for (int i = 0; i < 3; i++) {
+        ResultSet *rs = executeQuery(db, "SELECT * FROM test_10 WHERE value > :min_value", SQL_PARAM_MAP("min_value", 10));
+        while (nextResultSet(rs));
+        resultSetDelete(rs);
+    }
+
+    QueryStats stats[8];
+    uint32_t templateCount = sqliteGetQueryStats(db, stats, 8);
+    assert_uint32(3, ==, templateCount);
+    assert_string_equal("INSERT INTO test_10 VALUES (NULL, :int_val, :data_text)", stats[1].sql);
+    assert_uint64(20, ==, stats[1].callCount);
+    assert_uint64(1, ==, stats[1].prepareCount);
+    assert_uint64(20, ==, stats[1].rowsChanged);
+    assert_uint64(20 * (8 + 4), ==, stats[1].bytesBound);
+    assert_true(stats[1].totalStepNanos > 0);
+    assert_true(stats[1].maxStepNanos <= stats[1].totalStepNanos);
+
+    assert_uint64(3, ==, stats[2].callCount);
+    assert_uint64(30, ==, stats[2].rowsReturned);
+    assert_uint64(0, ==, stats[2].rowsChanged);
+    assert_uint64(30, ==, sinkRows);
+    assert_not_null(stats[2].queryPlan);
+    assert_not_null(strstr(stats[2].queryPlan, "test_10"));
+
+    sqliteResetQueryStats(db);
+    sqliteDisableQueryStats(db);
+    ResultSet *rs = executeQuery(db, "SELECT * FROM test_10 WHERE value > :min_value", SQL_PARAM_MAP("min_value", 10));
+    while (nextResultSet(rs));
+    resultSetDelete(rs);
+    assert_uint32(3, ==, sqliteGetQueryStats(db, stats, 8));
+    assert_uint64(0, ==, stats[2].callCount);   // not tracked when disabled
+    assert_not_null(stats[2].queryPlan);
+
+    // rows of following statements are counted to the same execution
+    rc = sqliteEnableQueryStats(db, NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rs = executeCallbackQuery(db, "SELECT id FROM test_10 WHERE value <= 2; SELECT id FROM test_10 WHERE value > 17", NULL);
+    assert_not_null(rs);
+    resultSetDelete(rs);
+    assert_uint32(4, ==, sqliteGetQueryStats(db, stats, 8));
+    assert_uint64(1, ==, stats[3].callCount);
+    assert_uint64(5, ==, stats[3].rowsReturned);
+
+    // disable completes active execution, so cursor doesn't keep pointer to stats
+    rs = executeQuery(db, "SELECT * FROM test_10 WHERE value > :min_value", SQL_PARAM_MAP("min_value", 10));
+    assert_true(nextResultSet(rs));
+    sqliteDisableQueryStats(db);
+    assert_null(rs->statement->queryStats);
+    while (nextResultSet(rs));
+    resultSetDelete(rs);
+    sqliteGetQueryStats(db, stats, 8);
+    assert_uint64(1, ==, stats[2].callCount);
+    assert_uint64(1, ==, stats[2].rowsReturned);
+
+    rc = executeUpdate(db, "DROP TABLE test_10", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteSchemaCacheTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_11(id INTEGER PRIMARY KEY, value INTEGER NOT NULL, data)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "CREATE INDEX IF NOT EXISTS test_11_value ON test_11(value)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    const SchemaTable *table = sqliteGetTableSchema(db, "test_11");
+    assert_not_null(table);
+    assert_uint32(3, ==, table->columnCount);
+    assert_string_equal("value", table->columns[1].name);
+    assert_string_equal("INTEGER", table->columns[1].declaredType);
+    assert_string_equal("", table->columns[2].declaredType);
+    assert_true(table->columns[0].isPrimaryKey);
+    assert_true(table->columns[1].isNotNull);
+    assert_uint32(1, ==, table->indexCount);
+    assert_string_equal("test_11_value", table->indexNames[0]);
+    assert_int(2, ==, schemaTableColumnIndex(table, "data"));
+
+    for (int i = 0; i < 100; i++) {
+        assert_true(idDbColumnExists(db, "test_11", "data"));
+        assert_false(idDbColumnExists(db, "test_11", "param"));
+    }
+    assert_ptr_equal(table, sqliteGetTableSchema(db, "test_11"));   // loaded once
+
+    const SchemaTable *missingTable = sqliteGetTableSchema(db, "test_11_missing");
+    assert_not_null(missingTable);
+    assert_uint32(0, ==, missingTable->columnCount);
+    char missingName[32];
+    for (int i = 0; i < 100; i++) {     // misses are not cached
+        snprintf(missingName, sizeof(missingName), "test_11_missing_%d", i);
+        assert_false(idDbColumnExists(db, missingName, "id"));
+    }
+    assert_uint32(1, ==, getVectorSize(sqliteConnectionOf(db)->schemaCache->tables));
+
+    const SchemaTable *qualifiedTable = sqliteGetTableSchema(db, "main.test_11");
+    assert_not_null(qualifiedTable);
+    assert_uint32(3, ==, qualifiedTable->columnCount);
+    assert_uint32(1, ==, qualifiedTable->indexCount);
+    assert_uint32(0, ==, sqliteGetTableSchema(db, "temp.test_11")->columnCount);
+
+    // schema change of attached and temp schema drops their cached tables
+    remove("../resources/schema_cache_test.db");
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "ATTACH DATABASE '../resources/schema_cache_test.db' AS aux_11", NULL));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "CREATE TABLE aux_11.test_11(id INTEGER PRIMARY KEY)", NULL));
+    assert_uint32(1, ==, sqliteGetTableSchema(db, "aux_11.test_11")->columnCount);
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "ALTER TABLE aux_11.test_11 ADD COLUMN name TEXT", NULL));
+    assert_uint32(2, ==, sqliteGetTableSchema(db, "aux_11.test_11")->columnCount);
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "DETACH DATABASE aux_11", NULL));
+    assert_null(sqliteGetTableSchema(db, "aux_11.test_11"));     // not attached schema
+    remove("../resources/schema_cache_test.db");
+    assert_uint32(3, ==, sqliteGetTableSchema(db, "test_11")->columnCount);
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "CREATE TEMP TABLE test_11(id INTEGER PRIMARY KEY)", NULL));
+    assert_uint32(1, ==, sqliteGetTableSchema(db, "test_11")->columnCount);    // temp table hides main one
+    assert_uint32(1, ==, sqliteGetTableSchema(db, "temp.test_11")->columnCount);
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "DROP TABLE temp.test_11", NULL));
+    assert_uint32(3, ==, sqliteGetTableSchema(db, "test_11")->columnCount);
+
+    // schema change drops cached tables
+    rc = executeUpdate(db, "ALTER TABLE test_11 ADD COLUMN param DOUBLE", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_true(idDbColumnExists(db, "test_11", "param"));
+    Vector nameVec = getDbTableColumnNames(db, "test_11");
+    assert_uint32(4, ==, getVectorSize(nameVec));
+    assert_string_equal("param", vectorGet(nameVec, 3));
+    deleteDbColumnNameVector(nameVec);
+
+    rc = executeUpdate(db, "DROP TABLE test_11", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_false(idDbColumnExists(db, "test_11", "id"));
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteArenaTest(const MunitParameter params[], void *data) {
+    SqliteArena *arena = newSqliteArena(256);
+    assert_not_null(arena);
+
+    void *first = sqliteArenaAlloc(arena, 10);
+    void *grown = sqliteArenaRealloc(arena, first, 10, 40);
+    assert_ptr_equal(first, grown);     // last allocation is extended in place
+    assert_uint64(0, ==, (uintptr_t) sqliteArenaAlloc(arena, 1) % SQLITE_ARENA_ALIGNMENT);
+    char *large = sqliteArenaAlloc(arena, 1000);     // larger than block
+    assert_not_null(large);
+    memset(large, 'a', 1000);
+    sqliteArenaReset(arena);
+    assert_uint64(0, ==, arena->allocatedBytes);
+
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_12(id INTEGER PRIMARY KEY, data TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= 50; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_12 VALUES (NULL, :data_text)", SQL_PARAM_MAP("data_text", "arena row"));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+
+    SqliteArenaBlock *blocks = NULL;
+    for (int request = 0; request < 3; request++) {
+        QueryString *query = namedQueryStringWithArena(arena, "SELECT * FROM test_12 WHERE id > :min_id", SQL_PARAM_MAP("min_id", 10));
+        assert_string_equal("SELECT * FROM test_12 WHERE id > 10", query->value);
+        queryStringAppend(query, " ORDER BY id DESC", 17);
+        assert_string_equal("SELECT * FROM test_12 WHERE id > 10 ORDER BY id DESC", query->value);
+
+        ResultSet *rs = executeQueryWithArena(db, arena, "SELECT * FROM test_12 WHERE id <= :max_id", SQL_PARAM_MAP("max_id", 5));
+        assert_not_null(rs);
+        int rowCount = 0;
+        while (nextResultSet(rs)) {
+            rowCount++;
+        }
+        assert_int(5, ==, rowCount);
+        resultSetDelete(rs);
+
+        ResultSet *callbackRs = executeCallbackQueryWithArena(db, arena, query->value, NULL);
+        assert_not_null(callbackRs);
+        assert_uint32(40, ==, callbackRs->rowCount);
+        assert_true(nextResultSet(callbackRs));
+        assert_int(50, ==, rsGetInt(callbackRs, "id"));
+        assert_string_equal("arena row", rsGetString(callbackRs, "data"));
+        resultSetDelete(callbackRs);
+
+        assert_true(arena->allocatedBytes > 0);
+        if (blocks != NULL) {
+            assert_ptr_equal(blocks, arena->blocks);    // blocks are reused after reset
+        }
+        blocks = arena->blocks;
+        sqliteArenaReset(arena);    // all request allocations are released at once
+    }
+
+    rc = executeUpdate(db, "DROP TABLE test_12", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    deleteSqliteArena(arena);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteImportTest(const MunitParameter params[], void *data) {
+    const char *csv = "\xEF\xBB\xBF" "id,name,amount\r\n"
+                      "1,plain,1.5\r\n"
+                      "2,\"quoted, \"\"escaped\"\"\",2\r\n"
+                      "\n"
+                      "3,\"multi\nline\",\r\n"
+                      "4,,4";
+    FILE *file = fopen("../resources/import_test.csv", "wb");
+    assert_not_null(file);
+    fputs(csv, file);
+    fclose(file);
+
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_13(id INTEGER PRIMARY KEY, name TEXT, amount DOUBLE)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    ImportReadMode readModes[] = {IMPORT_READ_AUTO, IMPORT_READ_STREAM};
+    for (int i = 0; i < 4; i++) {
+        ImportOptions options = {.hasHeader = true, .isEmptyNull = true, .commitRows = 2, .readMode = readModes[i % 2], .useProducerThread = i >= 2};
+        ImportStats stats;
+        rc = sqliteImportFile(db, "../resources/import_test.csv", "test_13", &options, &stats);
+        assert_int(SQLITE_OK, ==, rc);
+        assert_uint64(4, ==, stats.rowsImported);
+        assert_uint32(2, ==, stats.batchCount);
+        assert_uint64(strlen(csv) - 3, ==, stats.bytesParsed);
+
+        ResultSet *rs = executeQuery(db, "SELECT * FROM test_13 ORDER BY id", NULL);
+        assert_true(nextResultSet(rs));
+        assert_string_equal("plain", rsGetString(rs, "name"));
+        assert_double(1.5, ==, rsGetDouble(rs, "amount"));
+        assert_true(nextResultSet(rs));
+        assert_string_equal("quoted, \"escaped\"", rsGetString(rs, "name"));
+        assert_int(DB_VALUE_REAL, ==, rsGetColumnType(rs, "amount"));  // text is converted by column affinity
+        assert_true(nextResultSet(rs));
+        assert_string_equal("multi\nline", rsGetString(rs, "name"));
+        assert_int(DB_VALUE_NULL, ==, rsGetColumnType(rs, "amount"));
+        assert_true(nextResultSet(rs));
+        assert_int(4, ==, rsGetInt(rs, "id"));
+        assert_int(DB_VALUE_NULL, ==, rsGetColumnType(rs, "name"));
+        assert_false(nextResultSet(rs));
+        resultSetDelete(rs);
+        executeUpdate(db, "DELETE FROM test_13", NULL);
+    }
+
+    const char *tsv = "10\tfirst\t1\n11\tsecond\t2.5\n12\tthird\t3\t100\n";
+    ImportStats stats;
+    rc = sqliteImportBuffer(db, tsv, strlen(tsv), "test_13", &(ImportOptions) {.delimiter = '\t'}, &stats);
+    assert_int(SQLITE_RANGE, ==, rc);   // third record has extra field
+    assert_uint64(3, ==, stats.errorRow);
+    assert_uint64(0, ==, stats.rowsImported);
+    ResultSet *rs = executeQuery(db, "SELECT COUNT(*) AS row_count FROM test_13", NULL);
+    assert_true(nextResultSet(rs));
+    assert_int(0, ==, rsGetInt(rs, "row_count"));     // transaction is rolled back
+    resultSetDelete(rs);
+
+    rc = sqliteImportBuffer(db, tsv, strlen(tsv), NULL,
+                            &(ImportOptions) {.delimiter = '\t', .insertSql = "INSERT INTO test_13(id, name) VALUES (?, upper(?))"}, &stats);
+    assert_int(SQLITE_RANGE, ==, rc);
+    rc = sqliteImportBuffer(db, tsv, 25, NULL,
+                            &(ImportOptions) {.delimiter = '\t', .insertSql = "INSERT INTO test_13(id, name, amount) VALUES (?, upper(?), ?)"}, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint64(2, ==, stats.rowsImported);
+    rs = executeQuery(db, "SELECT name FROM test_13 WHERE id = 11", NULL);
+    assert_true(nextResultSet(rs));
+    assert_string_equal("SECOND", rsGetString(rs, "name"));
+    resultSetDelete(rs);
+
+    rc = executeUpdate(db, "DROP TABLE test_13", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    remove("../resources/import_test.csv");
+    return MUNIT_OK;
+}
+
+static int exportTestSink(void *context, const char *data, size_t size) {
+    queryStringAppend((QueryString *) context, data, (uint32_t) size);
+    return SQLITE_OK;
+}
+
+static int exportTestFailingSink(void *context, const char *data, size_t size) {
+    uint32_t *acceptedFlushes = (uint32_t *) context;
+    if (*acceptedFlushes == 0) return SQLITE_ABORT;
+    (*acceptedFlushes)--;
+    return SQLITE_OK;
+}
+
+static MunitResult sqlLiteExportTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_14(id INTEGER PRIMARY KEY, amount DOUBLE, name TEXT, data BLOB)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "INSERT INTO test_14 VALUES (-42, NULL, 'a,\"b\"' || char(10) || 'c', NULL), "
+                           "(1, 1.5, 'plain', x'0AFF'), (3, 2, 'tab' || char(9) || 'back\\slash', NULL)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    const char *sql = "SELECT id, amount, name, data FROM test_14 ORDER BY id";
+
+    QueryString *csv = newQueryString();
+    ResultSet *rs = executeQuery(db, sql, NULL);
+    ExportStats stats;
+    rc = rsExportToSink(rs, exportTestSink, csv, &(ExportOptions) {.hasHeader = true, .bufferSize = 8}, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    resultSetDelete(rs);
+    assert_string_equal("id,amount,name,data\n"
+                        "-42,,\"a,\"\"b\"\"\nc\",\n"
+                        "1,1.5,plain,0AFF\n"
+                        "3,2.0,tab\tback\\slash,\n", csv->value);
+    assert_uint64(3, ==, stats.rowsExported);
+    assert_uint64(csv->size, ==, stats.bytesWritten);
+    assert_uint32((csv->size + 7) / 8, ==, stats.flushCount);   // output is passed by full buffers
+    deleteQueryString(csv);
+
+    const char *jsonLines = "{\"id\":-42,\"amount\":null,\"name\":\"a,\\\"b\\\"\\nc\",\"data\":null}\n"
+                            "{\"id\":1,\"amount\":1.5,\"name\":\"plain\",\"data\":\"0AFF\"}\n"
+                            "{\"id\":3,\"amount\":2.0,\"name\":\"tab\\tback\\\\slash\",\"data\":null}\n";
+#ifdef SQLITE_EXPORT_HAS_FD
+    FILE *file = fopen("../resources/export_test.jsonl", "w+b");
+    assert_not_null(file);
+    rs = executeQuery(db, sql, NULL);
+    rc = rsExportToFd(rs, fileno(file), &(ExportOptions) {.format = EXPORT_JSON_LINES}, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    resultSetDelete(rs);
+    assert_uint32(1, ==, stats.flushCount);
+
+    char fileContent[256] = {0};
+    rewind(file);
+    assert_size(strlen(jsonLines), ==, fread(fileContent, 1, sizeof(fileContent) - 1, file));
+    assert_string_equal(jsonLines, fileContent);
+    fclose(file);
+    remove("../resources/export_test.jsonl");
+#endif
+
+    uint32_t acceptedFlushes = 1;
+    rs = executeQuery(db, sql, NULL);
+    rc = rsExportToSink(rs, exportTestFailingSink, &acceptedFlushes, &(ExportOptions) {.format = EXPORT_JSON_LINES, .bufferSize = 16}, &stats);
+    assert_int(SQLITE_ABORT, ==, rc);
+    assert_uint64(16, ==, stats.bytesWritten);     // rejected buffer is not counted
+    assert_uint32(2, ==, stats.flushCount);
+    resultSetDelete(rs);
+
+    csv = newQueryString();     // doubles are exported with round trip precision
+    rs = executeQuery(db, "SELECT 0.1 + 0.2", NULL);
+    rc = rsExportToSink(rs, exportTestSink, csv, NULL, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    resultSetDelete(rs);
+    assert_double(0.1 + 0.2, ==, strtod(csv->value, NULL));
+    deleteQueryString(csv);
+
+    rc = executeUpdate(db, "DROP TABLE test_14", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static int blobTestSink(void *context, const void *data, uint32_t size) {
+    uint32_t *offset = (uint32_t *) context;
+    for (uint32_t i = 0; i < size; i++) {
+        if (((const uint8_t *) data)[i] != (uint8_t) ((*offset + i) % 251)) return SQLITE_CORRUPT;
+    }
+    *offset += size;
+    return SQLITE_OK;
+}
+
+static int blobTestSource(void *context, void *buffer, uint32_t capacity, uint32_t *size) {
+    uint32_t *offset = (uint32_t *) context;
+    for (uint32_t i = 0; i < capacity; i++) {
+        ((uint8_t *) buffer)[i] = (uint8_t) ((*offset + i) % 251);
+    }
+    *offset += capacity;
+    *size = capacity;
+    return SQLITE_OK;
+}
+
+static MunitResult sqlLiteBlobTest(const MunitParameter params[], void *data) {
+    const uint8_t bytes[] = {0x00, 0x01, 0xAB, 0x00, 0xFF, 0x10};
+    QueryString *query = namedQueryString("INSERT INTO test_15 VALUES (:data, :empty)",
+                                          SQL_PARAM_MAP("data", DB_BLOB_VALUE(bytes, 3), "empty", DB_BLOB_VALUE(NULL, 4)));
+    assert_string_equal("INSERT INTO test_15 VALUES (X'0001AB', zeroblob(4))", query->value);
+    deleteQueryString(query);
+
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_15(id INTEGER PRIMARY KEY, data BLOB)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdate(db, "INSERT INTO test_15 VALUES (1, :data)", SQL_PARAM_MAP("data", DB_BLOB_VALUE(bytes, sizeof(bytes))));
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeCallbackUpdate(db, "INSERT INTO test_15 VALUES (2, :data)", SQL_PARAM_MAP("data", DB_BLOB_VALUE(bytes + 1, 2)));
+    assert_int(SQLITE_OK, ==, rc);
+
+    ResultSet *rs = executeQuery(db, "SELECT data FROM test_15 ORDER BY id", NULL);
+    uint32_t length = 0;
+    assert_true(nextResultSet(rs));
+    const uint8_t *value = rsGetBlob(rs, "data", &length);
+    assert_uint32(sizeof(bytes), ==, length);     // zero bytes are kept
+    assert_memory_equal(sizeof(bytes), bytes, value);
+    assert_int(DB_VALUE_BLOB, ==, rsGetColumnType(rs, "data"));
+    assert_true(nextResultSet(rs));
+    value = rsGetBlob(rs, "data", &length);
+    assert_uint32(2, ==, length);
+    assert_memory_equal(2, bytes + 1, value);
+    resultSetDelete(rs);
+
+    rs = executeCallbackQuery(db, "SELECT data FROM test_15 ORDER BY id", NULL);
+    assert_true(nextResultSet(rs));
+    value = rsGetBlob(rs, "data", &length);
+    assert_uint32(sizeof(bytes), ==, length);     // callback result set keeps zero bytes too
+    assert_memory_equal(sizeof(bytes), bytes, value);
+    resultSetDelete(rs);
+
+    // large payload is reserved with zero filled blob and streamed by chunks
+    const uint32_t payloadSize = SQLITE_BLOB_CHUNK_SIZE * 3 + 100;
+    rc = executeUpdate(db, "INSERT INTO test_15 VALUES (3, :data)", SQL_PARAM_MAP("data", DB_BLOB_VALUE(NULL, payloadSize)));
+    assert_int(SQLITE_OK, ==, rc);
+    SqliteBlob *blob = sqliteBlobOpen(db, "test_15", "data", 3, true);
+    assert_not_null(blob);
+    assert_uint32(payloadSize, ==, blob->size);
+    uint32_t offset = 0;
+    rc = sqliteBlobWriteFrom(blob, blobTestSource, &offset);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint32(payloadSize, ==, offset);
+    assert_int(SQLITE_ERROR, ==, sqliteBlobWrite(blob, bytes, 1));  // blob can't grow
+
+    assert_int(SQLITE_OK, ==, sqliteBlobSeek(blob, 0));
+    offset = 0;
+    rc = sqliteBlobReadTo(blob, blobTestSink, &offset);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint32(payloadSize, ==, offset);
+
+    uint8_t buffer[8];
+    rc = sqliteBlobReopen(blob, 1);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int(SQLITE_OK, ==, sqliteBlobSeek(blob, 2));
+    assert_int(SQLITE_OK, ==, sqliteBlobRead(blob, buffer, sizeof(buffer), &length));
+    assert_uint32(4, ==, length);   // read is limited by blob size
+    assert_memory_equal(4, bytes + 2, buffer);
+    assert_int(SQLITE_OK, ==, sqliteBlobClose(blob));
+    assert_null(sqliteBlobOpen(db, "test_15", "data", 100, false));
+
+    rc = executeUpdate(db, "DROP TABLE test_15", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+typedef struct MappedTestRow {
+    int64_t id;
+    int count;
+    uint32_t flags;
+    bool isActive;
+    float ratio;
+    double amount;
+    char code[6];
+    char *content;
+} MappedTestRow;
+
+static const RowField mappedTestFields[] = {
+        ROW_FIELD(MappedTestRow, id, "id"),
+        ROW_FIELD(MappedTestRow, count, "count"),
+        ROW_FIELD(MappedTestRow, flags, "flags"),
+        ROW_FIELD(MappedTestRow, isActive, "is_active"),
+        ROW_FIELD(MappedTestRow, ratio, "ratio"),
+        ROW_FIELD(MappedTestRow, amount, "amount"),
+        ROW_TEXT_FIELD(MappedTestRow, code, "code"),
+        ROW_FIELD(MappedTestRow, content, "content"),
+};
+static const RowMapping mappedTestMapping = ROW_MAPPING(MappedTestRow, mappedTestFields);
+
+static MunitResult sqlLiteRowMapperTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_18(id INTEGER PRIMARY KEY, count INTEGER, flags INTEGER, is_active INTEGER, ratio REAL, amount REAL, code TEXT, content TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    executeUpdate(db, "DELETE FROM test_18", NULL);
+    for (int i = 1; i <= 5; i++) {
+        rc = executeUpdate(db, "INSERT INTO test_18 VALUES (:id, :count, :flags, :active, :ratio, :amount, :code, :content)",
+                           SQL_PARAM_MAP("id", i, "count", i * 10, "flags", (int64_t) 4000000000, "active", i % 2, "ratio", 0.5, "amount", i * 1.25, "code", "ABCDEFGH", "content", "text"));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    rc = executeUpdate(db, "INSERT INTO test_18(id, code) VALUES (6, 'ab' || char(233) || char(233))", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    // paged mapping from cursor
+    ResultSet *rs = executeQuery(db, "SELECT * FROM test_18 ORDER BY id", NULL);
+    MappedTestRow rows[4];
+    uint32_t rowCount;
+    assert_int(SQLITE_OK, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, NULL, &rowCount));
+    assert_uint32(4, ==, rowCount);
+    for (int i = 0; i < 4; i++) {
+        assert_true(rows[i].id == i + 1);
+        assert_int((i + 1) * 10, ==, rows[i].count);
+        assert_uint32(4000000000U, ==, rows[i].flags);
+        assert_true(rows[i].isActive == ((i + 1) % 2 == 1));
+        assert_float(0.5f, ==, rows[i].ratio);
+        assert_double_equal((i + 1) * 1.25, rows[i].amount, 3);
+        assert_string_equal("ABCDE", rows[i].code);   // truncated to array size
+        assert_string_equal("text", rows[i].content);
+    }
+    freeMappedRows(&mappedTestMapping, rows, rowCount);
+
+    SqliteArena *arena = newSqliteArena(SQLITE_ARENA_DEFAULT_BLOCK_SIZE);
+    assert_int(SQLITE_OK, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, arena, &rowCount));
+    assert_uint32(2, ==, rowCount);
+    assert_true(rows[1].id == 6);
+    assert_int(0, ==, rows[1].count);     // NULL values
+    assert_null(rows[1].content);
+    assert_string_equal("ab\xc3\xa9", rows[1].code);    // UTF-8 sequence is not split
+    assert_int(SQLITE_OK, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, arena, &rowCount));
+    assert_uint32(0, ==, rowCount);
+    resultSetDelete(rs);
+
+    // column indexes are cached on statement and resolved again after re-prepare
+    rc = executeUpdate(db, "CREATE VIEW IF NOT EXISTS test_18_view AS SELECT * FROM test_18", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 0; i < 2; i++) {
+        rs = executeQuery(db, "SELECT * FROM test_18_view WHERE id = 3", NULL);
+        assert_int(SQLITE_OK, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, arena, &rowCount));
+        assert_uint32(1, ==, rowCount);
+        assert_true(rows[0].id == 3);
+        assert_int(30, ==, rows[0].count);
+        assert_string_equal("text", rows[0].content);
+        assert_ptr_equal(mappedTestFields, rs->statement->mappingKey);
+        resultSetDelete(rs);
+
+        rc = executeUpdate(db, "DROP VIEW test_18_view", NULL);
+        assert_int(SQLITE_OK, ==, rc);
+        rc = executeUpdate(db, "CREATE VIEW test_18_view AS SELECT content, code, amount, ratio, is_active, flags, count, id FROM test_18", NULL);
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    rc = executeUpdate(db, "DROP VIEW test_18_view", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    // fields of reused buffer have the same address with other column names
+    RowField reusedFields[] = {ROW_FIELD(MappedTestRow, id, "id"), ROW_FIELD(MappedTestRow, count, "count")};
+    const RowMapping reusedMapping = ROW_MAPPING(MappedTestRow, reusedFields);
+    for (int i = 0; i < 2; i++) {
+        rs = executeQuery(db, "SELECT id, count FROM test_18 WHERE id = 3", NULL);
+        assert_int(SQLITE_OK, ==, rsMapRows(rs, &reusedMapping, rows, 4, arena, &rowCount));
+        assert_uint32(1, ==, rowCount);
+        assert_true(rows[0].id == (i == 0 ? 3 : 30));
+        assert_int(i == 0 ? 30 : 3, ==, rows[0].count);
+        resultSetDelete(rs);
+        reusedFields[0].columnName = "count";
+        reusedFields[1].columnName = "id";
+    }
+
+    // callback result set and single row
+    rs = executeCallbackQuery(db, "SELECT * FROM test_18 WHERE id = 3", NULL);
+    assert_true(nextResultSet(rs));
+    MappedTestRow row;
+    assert_int(SQLITE_OK, ==, rsMapRow(rs, &mappedTestMapping, &row, arena));
+    assert_true(row.id == 3);
+    assert_uint32(4000000000U, ==, row.flags);
+    assert_double_equal(3.75, row.amount, 3);
+    assert_string_equal("text", row.content);
+    resultSetDelete(rs);
+
+    // missing column
+    rs = executeQuery(db, "SELECT id FROM test_18", NULL);
+    assert_int(SQLITE_RANGE, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, arena, &rowCount));
+    assert_uint32(0, ==, rowCount);
+    resultSetDelete(rs);
+
+    // struct parameter binding, 'extra' parameter has no field
+    MappedTestRow newRows[] = {
+            {.id = 7, .count = 70, .flags = 4000000001U, .isActive = true, .ratio = 0.25f, .amount = 7.5, .code = "XYZ", .content = "seven"},
+            {.id = 8, .count = 80, .code = {'1', '2', '3', '4', '5', '6'}},     // no terminator, NULL content
+    };
+    BatchStats stats;
+    rc = executeBatchStructUpdate(db, "INSERT INTO test_18 VALUES (:id, :count, :flags, :is_active, :ratio, :amount, :code, :content)",
+                                  &mappedTestMapping, newRows, 2, NULL, &stats);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_true(stats.rowsWritten == 2);
+    newRows[1].amount = 8.5;
+    rc = executeStructUpdate(db, "UPDATE test_18 SET amount = :amount, content = :extra WHERE id = :id", &mappedTestMapping, &newRows[1]);
+    assert_int(SQLITE_OK, ==, rc);
+
+    rs = executeQuery(db, "SELECT * FROM test_18 WHERE id >= 7 ORDER BY id", NULL);
+    assert_int(SQLITE_OK, ==, rsMapRows(rs, &mappedTestMapping, rows, 4, arena, &rowCount));
+    assert_uint32(2, ==, rowCount);
+    assert_uint32(4000000001U, ==, rows[0].flags);
+    assert_true(rows[0].isActive);
+    assert_float(0.25f, ==, rows[0].ratio);
+    assert_string_equal("XYZ", rows[0].code);
+    assert_string_equal("seven", rows[0].content);
+    assert_int(80, ==, rows[1].count);
+    assert_double_equal(8.5, rows[1].amount, 3);
+    assert_string_equal("12345", rows[1].code);
+    assert_null(rows[1].content);
+    resultSetDelete(rs);
+    deleteSqliteArena(arena);
+
+    rc = executeUpdate(db, "DROP TABLE test_18", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteParamListTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_20(c1 INTEGER PRIMARY KEY, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11, c12, c13, c14)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    // more than SQL_PARAM_MAP() limit, not in sql order
+    rc = executeUpdateWithList(db, "INSERT INTO test_20 VALUES (:c1, :c2, :c3, :c4, :c5, :c6, :c7, :c8, :c9, :c10, :c11, :c12, :c13, :c14)", SQL_PARAMS(
+            SQL_PARAM("c1", 1), SQL_PARAM("c2", 2), SQL_PARAM("c3", 3), SQL_PARAM("c4", 4), SQL_PARAM("c5", 5),
+            SQL_PARAM("c6", 6), SQL_PARAM("c7", 7), SQL_PARAM("c8", 8), SQL_PARAM("c9", 9), SQL_PARAM("c10", 10),
+            SQL_PARAM("c11", 11), SQL_PARAM("c12", 12.5), SQL_PARAM("c14", "last"), SQL_PARAM("c13", "text")));
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdateWithValues(db, "INSERT INTO test_20(c1, c2, c3, c14) VALUES (:id, :value, :value * 2, :text)",
+                                 SQL_VALUES(DB_VALUE(2), DB_VALUE(21), DB_VALUE("second")));    // ':value' is single parameter
+    assert_int(SQLITE_OK, ==, rc);
+    rc = executeUpdateWithValues(db, "INSERT INTO test_20(c1, c2) VALUES (:id, :value)", SQL_VALUES(DB_VALUE(3)));
+    assert_int(SQLITE_RANGE, ==, rc);
+
+    ResultSet *rs = executeQueryWithList(db, "SELECT * FROM test_20 WHERE c1 = :id", SQL_PARAMS(SQL_PARAM("id", 1)), &rc);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_true(nextResultSet(rs));
+    assert_int(11, ==, rsGetInt(rs, "c11"));
+    assert_double_equal(12.5, rsGetDouble(rs, "c12"), 3);
+    assert_string_equal("text", rsGetString(rs, "c13"));
+    assert_string_equal("last", rsGetString(rs, "c14"));
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    rs = executeQueryWithValues(db, "SELECT c3, c5, c14 FROM test_20 WHERE c1 = :id", SQL_VALUES(DB_VALUE(2)), NULL);
+    assert_true(nextResultSet(rs));
+    assert_int(42, ==, rsGetInt(rs, "c3"));
+    assert_int(DB_VALUE_NULL, ==, rsGetColumnType(rs, "c5"));
+    assert_string_equal("second", rsGetString(rs, "c14"));
+    resultSetDelete(rs);
+
+    // missing list parameter is bound as NULL
+    rs = executeQueryWithList(db, "SELECT count(*) AS cnt FROM test_20 WHERE c1 = :id OR :other IS NULL", SQL_PARAMS(SQL_PARAM("id", 1)), NULL);
+    assert_true(nextResultSet(rs));
+    assert_int(2, ==, rsGetInt(rs, "cnt"));
+    resultSetDelete(rs);
+
+    // binding error is returned with NULL result
+    rs = executeQueryWithValues(db, "SELECT * FROM test_20 WHERE c1 = :id AND c2 = :value", SQL_VALUES(DB_VALUE(1)), &rc);
+    assert_null(rs);
+    assert_int(SQLITE_RANGE, ==, rc);
+    rs = executeQueryWithList(db, "SELECT * FROM not_existing WHERE id = :id", SQL_PARAMS(SQL_PARAM("id", 1)), &rc);
+    assert_null(rs);
+    assert_int(SQLITE_ERROR, ==, rc);
+
+    rc = executeUpdate(db, "DROP TABLE test_20", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+typedef struct TransactionTestContext {
+    int attempts;
+    int busyAttempts;    // simulated SQLITE_BUSY results
+    int openLevels;      // nested transactions left open by body
+    int result;
+} TransactionTestContext;
+
+static int transactionTestBody(sqlite3 *db, void *context) {
+    TransactionTestContext *testContext = context;
+    testContext->attempts++;
+    int rc = executeUpdate(db, "INSERT INTO test_21 VALUES (:id)", SQL_PARAM_MAP("id", 100 + testContext->attempts));
+    return rc == SQLITE_OK && testContext->attempts <= testContext->busyAttempts ? SQLITE_BUSY : rc;
+}
+
+static int transactionTestOpenLevelsBody(sqlite3 *db, void *context) {
+    TransactionTestContext *testContext = context;
+    for (int i = 0; i < testContext->openLevels; i++) {
+        int rc = sqliteBeginTransaction(db, TRANSACTION_DEFERRED);
+        rc = rc == SQLITE_OK ? executeUpdate(db, "INSERT INTO test_21 VALUES (:id)", SQL_PARAM_MAP("id", 200 + i)) : rc;
+        if (rc != SQLITE_OK) return rc;
+    }
+    return testContext->result;
+}
+
+static int transactionTestDenyRollback(void *userData, int action, const char *arg1, const char *arg2, const char *dbName, const char *trigger) {
+    return action == SQLITE_TRANSACTION && arg1 != NULL && strcmp(arg1, "ROLLBACK") == 0 ? SQLITE_DENY : SQLITE_OK;
+}
+
+static int transactionTestCount(sqlite3 *db) {
+    ResultSet *rs = executeQuery(db, "SELECT count(*) AS cnt FROM test_21", NULL);
+    int count = nextResultSet(rs) ? rsGetInt(rs, "cnt") : -1;
+    resultSetDelete(rs);
+    return count;
+}
+
+static MunitResult sqlLiteTransactionTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_21(id INTEGER PRIMARY KEY)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int(SQLITE_MISUSE, ==, sqliteCommitTransaction(db));
+
+    // nested savepoints
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_IMMEDIATE));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "INSERT INTO test_21 VALUES (1)", NULL));
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_DEFERRED));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "INSERT INTO test_21 VALUES (2)", NULL));
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_DEFERRED));
+    assert_uint32(3, ==, sqliteTransactionDepth(db));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "INSERT INTO test_21 VALUES (3)", NULL));
+    assert_int(SQLITE_OK, ==, sqliteRollbackTransaction(db));
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(db));
+    assert_uint32(1, ==, sqliteTransactionDepth(db));
+    assert_int(2, ==, transactionTestCount(db));
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(db));
+    assert_uint32(0, ==, sqliteTransactionDepth(db));
+    assert_true(sqlite3_get_autocommit(db) != 0);
+    assert_int(2, ==, transactionTestCount(db));
+
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_EXCLUSIVE));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "DELETE FROM test_21", NULL));
+    assert_int(SQLITE_OK, ==, sqliteRollbackTransaction(db));
+    assert_int(2, ==, transactionTestCount(db));
+
+    // failed rollback keeps level open
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_IMMEDIATE));
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "DELETE FROM test_21", NULL));
+    assert_int(SQLITE_OK, ==, sqlite3_set_authorizer(db, transactionTestDenyRollback, NULL));
+    assert_int(SQLITE_AUTH, ==, sqliteRollbackTransaction(db));
+    assert_uint32(1, ==, sqliteTransactionDepth(db));
+    assert_int(SQLITE_OK, ==, sqlite3_set_authorizer(db, NULL, NULL));
+    assert_int(SQLITE_OK, ==, sqliteRollbackTransaction(db));
+    assert_uint32(0, ==, sqliteTransactionDepth(db));
+    assert_int(2, ==, transactionTestCount(db));
+
+    // whole unit is repeated on busy
+    TransactionTestContext context = {.busyAttempts = 2};
+    rc = sqliteRunInTransaction(db, &(TransactionOptions) {.mode = TRANSACTION_IMMEDIATE, .maxRetries = 3, .retryDelayMs = 1}, transactionTestBody, &context);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int(3, ==, context.attempts);
+    assert_int(3, ==, transactionTestCount(db));
+
+    context = (TransactionTestContext) {.busyAttempts = 5};
+    rc = sqliteRunInTransaction(db, &(TransactionOptions) {.maxRetries = 1, .retryDelayMs = 1}, transactionTestBody, &context);
+    assert_int(SQLITE_BUSY, ==, rc);
+    assert_int(2, ==, context.attempts);
+    assert_int(3, ==, transactionTestCount(db));
+
+    // lock held by other connection
+    sqlite3 *otherDb = sqliteDbInit("../resources/test.db");
+    assert_not_null(otherDb);
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(otherDb, TRANSACTION_IMMEDIATE));
+    assert_int(SQLITE_OK, ==, sqliteSetBusyPolicy(db, &(BusyPolicy) {.timeoutMs = 0}));     // retried by transaction only
+    context = (TransactionTestContext) {0};
+    rc = sqliteRunInTransaction(db, &(TransactionOptions) {.mode = TRANSACTION_IMMEDIATE, .maxRetries = 2, .retryDelayMs = 1}, transactionTestBody, &context);
+    assert_int(SQLITE_BUSY, ==, rc);
+    assert_int(0, ==, context.attempts);
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(otherDb));
+    sqliteDbClose(otherDb);
+
+    // inside outer transaction unit is a savepoint
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(db, TRANSACTION_IMMEDIATE));
+    context = (TransactionTestContext) {.busyAttempts = 1};
+    rc = sqliteRunInTransaction(db, NULL, transactionTestBody, &context);
+    assert_int(SQLITE_BUSY, ==, rc);
+    assert_int(1, ==, context.attempts);
+    assert_uint32(1, ==, sqliteTransactionDepth(db));
+
+    // levels left open by failed unit are rolled back to depth on entry
+    context = (TransactionTestContext) {.openLevels = 2, .result = SQLITE_ERROR};
+    rc = sqliteRunInTransaction(db, NULL, transactionTestOpenLevelsBody, &context);
+    assert_int(SQLITE_ERROR, ==, rc);
+    assert_uint32(1, ==, sqliteTransactionDepth(db));
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(db));
+    assert_int(3, ==, transactionTestCount(db));
+
+    context = (TransactionTestContext) {.openLevels = 2, .result = SQLITE_OK};
+    rc = sqliteRunInTransaction(db, NULL, transactionTestOpenLevelsBody, &context);
+    assert_int(SQLITE_MISUSE, ==, rc);     // not closed levels can't be committed by unit
+    assert_uint32(0, ==, sqliteTransactionDepth(db));
+    assert_true(sqlite3_get_autocommit(db) != 0);
+    assert_int(3, ==, transactionTestCount(db));
+
+    rc = executeUpdate(db, "DROP TABLE test_21", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static MunitResult sqlLiteBusyTest(const MunitParameter params[], void *data) {
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    assert_int(SQLITE_MISUSE, ==, sqliteSetBusyPolicy(NULL, NULL));
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_22(id INTEGER PRIMARY KEY)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int(SQLITE_OK, ==, sqliteEnableQueryStats(db, NULL));
+
+    sqlite3 *otherDb = sqliteDbInit("../resources/test.db");
+    assert_not_null(otherDb);
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(otherDb, TRANSACTION_IMMEDIATE));
+
+    // retried with backoff until deadline
+    assert_int(SQLITE_OK, ==, sqliteSetBusyPolicy(db, &(BusyPolicy) {.timeoutMs = 20, .initialDelayMicros = 1000}));
+    rc = executeUpdate(db, "INSERT INTO test_22 VALUES (1)", NULL);
+    assert_int(SQLITE_BUSY, ==, rc);
+    BusyStats stats = sqliteGetBusyStats(db);
+    assert_uint64(1, ==, stats.waitCount);
+    assert_uint64(1, ==, stats.timeoutCount);
+    assert_uint64(2, <=, stats.retryCount);
+    assert_uint64(15000, <=, stats.totalWaitMicros);
+    assert_uint64(stats.totalWaitMicros, ==, stats.maxWaitMicros);
+    uint64_t histogramCount = 0;
+    for (int i = 0; i < SQLITE_BUSY_HISTOGRAM_BUCKETS; i++) {
+        histogramCount += stats.waitHistogram[i];
+    }
+    assert_uint64(1, ==, histogramCount);
+    assert_uint64(0, ==, stats.waitHistogram[0]);
+
+    QueryStats queryStats[4];
+    uint32_t templateCount = sqliteGetQueryStats(db, queryStats, 4);
+    assert_uint32(1, ==, templateCount);
+    assert_string_equal("INSERT INTO test_22 VALUES (1)", queryStats[0].sql);
+    assert_uint64(stats.totalWaitMicros, ==, queryStats[0].totalBusyWaitMicros);
+    assert_uint64(stats.totalWaitMicros, ==, queryStats[0].maxBusyWaitMicros);
+
+    // zero timeout fails without sleep
+    assert_int(SQLITE_OK, ==, sqliteSetBusyPolicy(db, &(BusyPolicy) {.timeoutMs = 0}));
+    rc = executeUpdate(db, "INSERT INTO test_22 VALUES (1)", NULL);
+    assert_int(SQLITE_BUSY, ==, rc);
+    stats = sqliteGetBusyStats(db);
+    assert_uint64(2, ==, stats.waitCount);
+    assert_uint64(2, ==, stats.timeoutCount);
+    assert_uint64(1, ==, stats.waitHistogram[0]);
+
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(otherDb));
+    sqliteDbClose(otherDb);
+    assert_int(SQLITE_OK, ==, sqliteSetBusyPolicy(db, NULL));
+    rc = executeUpdate(db, "INSERT INTO test_22 VALUES (1)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint64(2, ==, sqliteGetBusyStats(db).waitCount);
+    sqliteResetBusyStats(db);
+    assert_uint64(0, ==, sqliteGetBusyStats(db).waitCount);
+
+    rc = executeUpdate(db, "DROP TABLE test_22", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static void deadlineTestCancelFunction(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    SqliteCancelToken *token = sqlite3_user_data(context);
+    if (sqlite3_value_int64(argv[0]) == 100) {
+        sqliteCancel(token);
+    }
+    sqlite3_result_value(context, argv[0]);
+}
+
+static MunitResult sqlLiteDeadlineTest(const MunitParameter params[], void *data) {
+    const char *countSql = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < :limit) SELECT count(*) AS cnt FROM c";
+    sqlite3 *db = sqliteDbInit("../resources/test.db");
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_23(id INTEGER PRIMARY KEY)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    // runaway query is interrupted and cached statement is reused
+    uint64_t startMicros = sqliteClockMicros();
+    ResultSet *rs = executeCallbackQueryWithDeadline(db, countSql, SQL_PARAM_MAP("limit", (int64_t) 1000000000000), &(QueryDeadline) {.timeoutMs = 20}, &rc);
+    assert_null(rs);
+    assert_int(SQLITE_DEADLINE_EXCEEDED, ==, rc);
+    assert_int(SQLITE_INTERRUPT, ==, rc & 0xFF);
+    assert_uint64(1000000, >, sqliteClockMicros() - startMicros);
+
+    rs = executeQuery(db, countSql, SQL_PARAM_MAP("limit", 1000));
+    assert_true(nextResultSet(rs));
+    assert_int(1000, ==, rsGetInt(rs, "cnt"));
+    resultSetDelete(rs);
+    assert_null(sqliteConnectionOf(db)->activeDeadline);
+
+    // cursor keeps deadline until rows are read
+    rs = executeQueryWithDeadline(db, "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT x FROM c WHERE x % 1000000 = 0", NULL, &(QueryDeadline) {.timeoutMs = 20}, &rc);
+    assert_not_null(rs);
+    assert_int(SQLITE_OK, ==, rc);
+    while (nextResultSet(rs)) {}
+    assert_int(SQLITE_DEADLINE_EXCEEDED, ==, rs->stepResult);
+    assert_null(sqliteConnectionOf(db)->activeDeadline);
+    assert_uint32(0, ==, sqliteConnectionOf(db)->armedDeadlineCount);   // handler is removed after completion
+    resultSetDelete(rs);
+
+    // open cursor deadline doesn't interrupt other statements of connection
+    SqliteCancelToken token = {0};
+    rs = executeQueryWithDeadline(db, "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT x FROM c WHERE x % 100000 = 0", NULL, &(QueryDeadline) {.cancelToken = &token}, NULL);
+    assert_true(nextResultSet(rs));
+    assert_uint32(1, ==, sqliteConnectionOf(db)->armedDeadlineCount);   // handler stays installed between steps
+    sqliteCancel(&token);
+    ResultSet *countRs = executeQuery(db, countSql, SQL_PARAM_MAP("limit", 100000));
+    assert_true(nextResultSet(countRs));
+    assert_int(100000, ==, rsGetInt(countRs, "cnt"));
+    resultSetDelete(countRs);
+    assert_false(nextResultSet(rs));
+    assert_int(SQLITE_QUERY_CANCELLED, ==, rs->stepResult);
+    resultSetDelete(rs);
+    assert_null(executeQueryWithDeadline(db, countSql, NULL, &(QueryDeadline) {.cancelToken = &token}, &rc));
+    assert_int(SQLITE_QUERY_CANCELLED, ==, rc);
+    assert_null(executeQueryWithDeadline(db, "SELECT * FROM not_existing_23", NULL, NULL, &rc));
+    assert_int(SQLITE_ERROR, ==, rc);
+
+    // single call deadline keeps connection deadline
+    assert_int(SQLITE_OK, ==, sqliteSetDeadline(db, &(QueryDeadline) {.timeoutMs = 60000}));
+    assert_int(SQLITE_QUERY_CANCELLED, ==, executeUpdateWithDeadline(db, "INSERT INTO test_23 VALUES (1)", NULL, &(QueryDeadline) {.cancelToken = &token}));
+    assert_true(sqliteConnectionOf(db)->deadlineState.isArmed);
+    assert_int(SQLITE_OK, ==, sqliteSetDeadline(db, &(QueryDeadline) {.timeoutMs = 60000}));
+    assert_uint32(1, ==, sqliteConnectionOf(db)->armedDeadlineCount);
+    sqliteClearDeadline(db);
+    assert_uint32(0, ==, sqliteConnectionOf(db)->armedDeadlineCount);
+    sqliteCancelTokenReset(&token);
+
+    // cancel token
+    sqliteCancel(&token);
+    sqliteCancel(&token);
+    assert_int(SQLITE_QUERY_CANCELLED, ==, executeUpdateWithDeadline(db, "INSERT INTO test_23 VALUES (1)", NULL, &(QueryDeadline) {.cancelToken = &token}));
+    sqliteCancelTokenReset(&token);
+    assert_false(sqliteIsCancelled(&token));
+    assert_int(SQLITE_OK, ==, sqlite3_create_function(db, "cancel_at_100", 1, SQLITE_UTF8, &token, deadlineTestCancelFunction, NULL, NULL));
+    rc = executeUpdateWithDeadline(db, "INSERT INTO test_23 WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT cancel_at_100(x) FROM c", NULL,
+                                   &(QueryDeadline) {.cancelToken = &token});
+    assert_int(SQLITE_QUERY_CANCELLED, ==, rc);
+    assert_true(sqliteIsCancelled(&token));
+    rs = executeQuery(db, "SELECT count(*) AS cnt FROM test_23", NULL);
+    assert_true(nextResultSet(rs));
+    assert_int(0, ==, rsGetInt(rs, "cnt"));     // interrupted insert is rolled back
+    resultSetDelete(rs);
+
+    // lock wait is limited by deadline
+    sqlite3 *otherDb = sqliteDbInit("../resources/test.db");
+    assert_not_null(otherDb);
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(otherDb, TRANSACTION_IMMEDIATE));
+    startMicros = sqliteClockMicros();
+    rc = executeUpdateWithDeadline(db, "INSERT INTO test_23 VALUES (1)", NULL, &(QueryDeadline) {.timeoutMs = 30});
+    assert_int(SQLITE_DEADLINE_EXCEEDED, ==, rc);
+    assert_uint64(1000000, >, sqliteClockMicros() - startMicros);
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(otherDb));
+    sqliteDbClose(otherDb);
+    assert_int(SQLITE_OK, ==, executeUpdate(db, "INSERT INTO test_23 VALUES (1)", NULL));
+
+    rc = executeUpdate(db, "DROP TABLE test_23", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqliteDbClose(db);
+    return MUNIT_OK;
+}
+
+static const char *optionsTestPragma(sqlite3 *db, const char *pragma) {
+    static char value[32];
+    ResultSet *rs = executeQuery(db, pragma, NULL);
+    bool hasValue = nextResultSet(rs);
+    if (hasValue) {
+        snprintf(value, sizeof(value), "%s", rsGetStringByIndex(rs, 0));
+    }
+    resultSetDelete(rs);
+    return hasValue ? value : NULL;
+}
+
+static MunitResult sqlLiteOpenOptionsTest(const MunitParameter params[], void *data) {
+    const char *dbName = "../resources/options_test.db";
+    remove(dbName);
+    assert_null(sqliteDbInitWithOptions("../resources/not_existing_dir/test.db", NULL));
+    assert_null(sqliteDbInitWithOptions(dbName, SQLITE_READ_ONLY_ANALYTICS_OPTIONS));    // read only can't create db
+    assert_null(sqliteDbInitWithOptions(":memory:", &(SqliteOpenOptions) {.journalMode = DB_JOURNAL_WAL}));   // mode is not applied
+
+    sqlite3 *db = sqliteDbInitWithOptions(dbName, &(SqliteOpenOptions) {
+            .journalMode = DB_JOURNAL_WAL,
+            .synchronous = DB_SYNC_NORMAL,
+            .pageSize = 8192,
+            .cacheSize = -2048,
+            .tempStore = DB_TEMP_STORE_MEMORY});
+    assert_not_null(db);
+    int rc = executeUpdate(db, "CREATE TABLE IF NOT EXISTS test_8(id INTEGER PRIMARY KEY, value INTEGER)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    assert_string_equal("wal", optionsTestPragma(db, "PRAGMA journal_mode"));
+    assert_string_equal("1", optionsTestPragma(db, "PRAGMA synchronous"));
+    assert_string_equal("8192", optionsTestPragma(db, "PRAGMA page_size"));
+    assert_string_equal("-2048", optionsTestPragma(db, "PRAGMA cache_size"));
+    assert_string_equal("2", optionsTestPragma(db, "PRAGMA temp_store"));
+    sqliteDbClose(db);
+
+    db = sqliteDbInitWithOptions(dbName, SQLITE_READ_ONLY_ANALYTICS_OPTIONS);
+    assert_not_null(db);
+    assert_int(SQLITE_READONLY, ==, executeUpdate(db, "INSERT INTO test_8 VALUES (1, 1)", NULL));
+    assert_string_equal("wal", optionsTestPragma(db, "PRAGMA journal_mode"));
+    assert_not_null(optionsTestPragma(db, "PRAGMA mmap_size"));   // can be limited by SQLITE_MAX_MMAP_SIZE
+    sqliteDbClose(db);
+
+    remove(dbName);
+    remove("../resources/options_test.db-wal");
+    remove("../resources/options_test.db-shm");
+    return MUNIT_OK;
+}
+
+#ifdef SQLITE_WRAPPER_THREADS
+#define POOL_TEST_DB "../resources/pool_test.db"
+#define POOL_TEST_READERS 4
+#define POOL_TEST_QUERIES 50
+
+static void *poolTestReader(void *context) {
+    SqlitePool *pool = context;
+    intptr_t failures = 0;
+    for (int i = 0; i < POOL_TEST_QUERIES; i++) {
+        ResultSet *rs = poolExecuteQuery(pool, "SELECT count(*) AS cnt, sum(value) AS total FROM test_7 WHERE id <= :max_id", SQL_PARAM_MAP("max_id", 100));
+        if (rs == NULL || !nextResultSet(rs) || rsGetInt(rs, "cnt") != 100 || rsGetI64(rs, "total") != 5050) {
+            failures++;
+        }
+        resultSetDelete(rs);
+    }
+    return (void *) failures;
+}
+
+static void *poolTestWriter(void *context) {
+    SqlitePool *pool = context;
+    intptr_t failures = 0;
+    for (int i = 101; i <= 100 + POOL_TEST_QUERIES; i++) {
+        if (poolExecuteUpdate(pool, "INSERT INTO test_7 VALUES (:id, :int_val)", SQL_PARAM_MAP("id", i, "int_val", i)) != SQLITE_OK) {
+            failures++;
+        }
+    }
+    return (void *) failures;
+}
+
+static MunitResult sqlLitePoolTest(const MunitParameter params[], void *data) {
+    SqlitePool *pool = newSqlitePool(POOL_TEST_DB, 2);
+    assert_not_null(pool);
+
+    int rc = poolExecuteUpdate(pool, "CREATE TABLE IF NOT EXISTS test_7(id INTEGER PRIMARY KEY, value INTEGER)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    sqlite3 *writer = sqlitePoolAcquireWriter(pool);
+    assert_not_null(writer);
+    for (int i = 1; i <= 100; i++) {
+        rc = executeUpdate(writer, "INSERT INTO test_7 VALUES (:id, :int_val)", SQL_PARAM_MAP("id", i, "int_val", i));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    sqlitePoolRelease(pool, writer);
+
+    // readers are read only
+    sqlite3 *reader = sqlitePoolAcquireReader(pool);
+    assert_not_null(reader);
+    assert_int(SQLITE_READONLY, ==, executeUpdate(reader, "DELETE FROM test_7", NULL));
+    sqlitePoolRelease(pool, reader);
+
+    pthread_t threads[POOL_TEST_READERS + 1];
+    for (int i = 0; i < POOL_TEST_READERS; i++) {
+        assert_int(0, ==, pthread_create(&threads[i], NULL, poolTestReader, pool));
+    }
+    assert_int(0, ==, pthread_create(&threads[POOL_TEST_READERS], NULL, poolTestWriter, pool));
+    for (int i = 0; i <= POOL_TEST_READERS; i++) {
+        void *failures;
+        pthread_join(threads[i], &failures);
+        assert_ptr_equal(NULL, failures);
+    }
+
+    ResultSet *rs = poolExecuteCallbackQuery(pool, "SELECT count(*) AS cnt FROM test_7", NULL);
+    assert_not_null(rs);
+    assert_true(nextResultSet(rs));
+    assert_int(100 + POOL_TEST_QUERIES, ==, rsGetInt(rs, "cnt"));
+    resultSetDelete(rs);
+
+    deleteSqlitePool(pool);
+    remove(POOL_TEST_DB);
+    remove(POOL_TEST_DB "-wal");
+    remove(POOL_TEST_DB "-shm");
+    return MUNIT_OK;
+}
+
+#define ASYNC_TEST_DB "../resources/async_test.db"
+
+static void asyncTestNotify(void *context) {
+    __atomic_add_fetch((int *) context, 1, __ATOMIC_SEQ_CST);
+}
+
+static void asyncTestCompletion(void *userData, AsyncResult *result) {
+    AsyncResult *received = userData;
+    *received = *result;
+}
+
+typedef struct AsyncBlockingContext {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    bool isWorkerBlocked;
+    bool isReleased;
+} AsyncBlockingContext;
+
+// Holds worker, so next requests are queued as single burst
+static void asyncTestBlockingCompletion(void *userData, AsyncResult *result) {
+    AsyncBlockingContext *context = userData;
+    pthread_mutex_lock(&context->mutex);
+    context->isWorkerBlocked = true;
+    pthread_cond_broadcast(&context->changed);
+    while (!context->isReleased) {
+        pthread_cond_wait(&context->changed, &context->mutex);
+    }
+    pthread_mutex_unlock(&context->mutex);
+}
+
+static int asyncTestCommitHook(void *context) {
+    (*(int *) context)++;
+    return 0;
+}
+
+static MunitResult sqlLiteAsyncTest(const MunitParameter params[], void *data) {
+    remove(ASYNC_TEST_DB);
+    int notifyCount = 0;
+    SqliteAsync *async = newSqliteAsync(ASYNC_TEST_DB, &(AsyncOptions) {.notify = asyncTestNotify, .notifyContext = &notifyCount});
+    assert_not_null(async);
+
+    uint64_t id = sqliteAsyncUpdate(async, "CREATE TABLE test_16(id INTEGER PRIMARY KEY, content TEXT, value REAL)", NULL, NULL, NULL);
+    assert_true(id > 0);
+    for (int i = 1; i <= 10; i++) {
+        char content[16];   // reused buffer, value must be copied on submit
+        snprintf(content, sizeof(content), "row_%d", i);
+        assert_true(sqliteAsyncUpdate(async, "INSERT INTO test_16 VALUES (:id, :content, :value)", SQL_PARAM_MAP("id", i, "content", content, "value", i * 0.5), NULL, NULL) > 0);
+        memset(content, 0, sizeof(content));
+    }
+
+    uint64_t queryId = sqliteAsyncQuery(async, "SELECT id, content, value FROM test_16 WHERE id > :min_id ORDER BY id", SQL_PARAM_MAP("min_id", 5), NULL, NULL);
+    AsyncResult result;
+    assert_true(sqliteAsyncWait(async, queryId, &result, 5000));
+    assert_true(result.id == queryId);
+    assert_int(SQLITE_OK, ==, result.rc);
+    assert_not_null(result.resultSet);
+    for (int i = 6; i <= 10; i++) {
+        char expected[16];
+        snprintf(expected, sizeof(expected), "row_%d", i);
+        assert_true(nextResultSet(result.resultSet));
+        assert_int(i, ==, rsGetInt(result.resultSet, "id"));
+        assert_string_equal(expected, rsGetString(result.resultSet, "content"));
+        assert_double_equal(i * 0.5, rsGetDouble(result.resultSet, "value"), 3);
+    }
+    assert_false(nextResultSet(result.resultSet));
+    resultSetDelete(result.resultSet);
+
+    // earlier updates are queued before query, so all of them are already completed
+    int updateCount = 0;
+    while (sqliteAsyncPoll(async, &result)) {
+        assert_int(SQLITE_OK, ==, result.rc);
+        assert_null(result.resultSet);
+        if (result.changes == 1) {
+            assert_int(result.lastInsertRowId, ==, updateCount + 1);
+            updateCount++;
+        }
+    }
+    assert_int(10, ==, updateCount);
+
+    // callback completion bypasses queue
+    AsyncResult received = {0};
+    id = sqliteAsyncUpdate(async, "UPDATE test_16 SET value = 0 WHERE id <= :max_id", SQL_PARAM_MAP("max_id", 3), asyncTestCompletion, &received);
+    assert_true(id > 0);
+    queryId = sqliteAsyncQuery(async, "SELECT count(*) AS cnt FROM test_16 WHERE value = 0", NULL, NULL, NULL);
+    assert_true(sqliteAsyncWait(async, 0, &result, 5000));
+    assert_true(result.id == queryId);
+    assert_true(nextResultSet(result.resultSet));
+    assert_int(3, ==, rsGetInt(result.resultSet, "cnt"));
+    resultSetDelete(result.resultSet);
+    assert_true(received.id == id);
+    assert_int(SQLITE_OK, ==, received.rc);
+    assert_int(3, ==, received.changes);
+
+    // errors are reported in result
+    queryId = sqliteAsyncQuery(async, "SELECT * FROM not_existing", NULL, NULL, NULL);
+    assert_true(sqliteAsyncWait(async, queryId, &result, 5000));
+    assert_int(SQLITE_OK, !=, result.rc);
+    assert_null(result.resultSet);
+    assert_false(sqliteAsyncPoll(async, &result));
+
+    // burst of updates is committed once, failed update is rolled back alone
+    AsyncBlockingContext blocking = {.mutex = PTHREAD_MUTEX_INITIALIZER, .changed = PTHREAD_COND_INITIALIZER};
+    assert_true(sqliteAsyncUpdate(async, "UPDATE test_16 SET value = 1 WHERE id = 1", NULL, asyncTestBlockingCompletion, &blocking) > 0);
+    pthread_mutex_lock(&blocking.mutex);
+    while (!blocking.isWorkerBlocked) {
+        pthread_cond_wait(&blocking.changed, &blocking.mutex);
+    }
+    pthread_mutex_unlock(&blocking.mutex);
+    int commitCount = 0;
+    sqlite3_commit_hook(async->db, asyncTestCommitHook, &commitCount);     // worker doesn't use connection while blocked
+
+    const int groupIds[] = {11, 12, 1, 13};     // id 1 already exists
+    uint64_t groupRequestIds[4];
+    for (int i = 0; i < 4; i++) {
+        groupRequestIds[i] = sqliteAsyncUpdate(async, "INSERT INTO test_16 VALUES (:id, 'group', 0)", SQL_PARAM_MAP("id", groupIds[i]), NULL, NULL);
+        assert_true(groupRequestIds[i] > 0);
+    }
+    pthread_mutex_lock(&blocking.mutex);
+    blocking.isReleased = true;
+    pthread_cond_broadcast(&blocking.changed);
+    pthread_mutex_unlock(&blocking.mutex);
+    for (int i = 0; i < 4; i++) {
+        assert_true(sqliteAsyncWait(async, groupRequestIds[i], &result, 5000));
+        assert_int(groupIds[i] == 1 ? SQLITE_CONSTRAINT : SQLITE_OK, ==, result.rc & 0xFF);
+        assert_int(groupIds[i] == 1 ? 0 : 1, ==, result.changes);
+    }
+    assert_int(1, ==, commitCount);
+    sqlite3_commit_hook(async->db, NULL, NULL);
+
+    // values are materialized with types, blob keeps zero bytes
+    queryId = sqliteAsyncQuery(async, "SELECT count(*) AS cnt, x'00FF01' AS data, 0.1 AS value FROM test_16 WHERE content = 'group'", NULL, NULL, NULL);
+    assert_true(sqliteAsyncWait(async, queryId, &result, 5000));
+    assert_true(nextResultSet(result.resultSet));
+    assert_int(3, ==, rsGetInt(result.resultSet, "cnt"));
+    uint32_t length = 0;
+    const uint8_t *blob = rsGetBlob(result.resultSet, "data", &length);
+    assert_uint32(3, ==, length);
+    assert_memory_equal(3, "\x00\xFF\x01", blob);
+    assert_int(DB_VALUE_BLOB, ==, rsGetColumnType(result.resultSet, "data"));
+    assert_int(DB_VALUE_INT, ==, rsGetColumnType(result.resultSet, "cnt"));
+    assert_int(DB_VALUE_REAL, ==, rsGetColumnType(result.resultSet, "value"));
+    assert_double(0.1, ==, rsGetDouble(result.resultSet, "value"));
+    resultSetDelete(result.resultSet);
+
+    sqliteAsyncQuery(async, "SELECT * FROM test_16", NULL, NULL, NULL);    // not received, deleted with worker
+    deleteSqliteAsync(async);
+    assert_int(20, ==, notifyCount);   // all queued results, callback completion is not notified
+    remove(ASYNC_TEST_DB);
+    return MUNIT_OK;
+}
+
+#define WRITE_QUEUE_TEST_DB "../resources/write_queue_test.db"
+#define WRITE_QUEUE_TEST_THREADS 4
+#define WRITE_QUEUE_TEST_ROWS 50
+
+typedef struct WriteQueueTestContext {
+    SqliteWriteQueue *queue;
+    int firstId;
+} WriteQueueTestContext;
+
+static void *writeQueueTestWriter(void *context) {
+    SqliteWriteQueue *queue = ((WriteQueueTestContext *) context)->queue;
+    int firstId = ((WriteQueueTestContext *) context)->firstId;
+    intptr_t failures = 0;
+    for (int id = firstId; id < firstId + WRITE_QUEUE_TEST_ROWS; id++) {
+        if (writeQueueExecuteUpdate(queue, "INSERT INTO test_17 VALUES (:id, :int_val)", SQL_PARAM_MAP("id", id, "int_val", id)) != SQLITE_OK) {
+            failures++;
+        }
+        // duplicate fails only for this caller
+        if (writeQueueExecuteUpdate(queue, "INSERT INTO test_17 VALUES (:id, :int_val)", SQL_PARAM_MAP("id", id, "int_val", 0)) != SQLITE_CONSTRAINT) {
+            failures++;
+        }
+    }
+    return (void *) failures;
+}
+
+static MunitResult sqlLiteWriteQueueTest(const MunitParameter params[], void *data) {
+    remove(WRITE_QUEUE_TEST_DB);
+    SqliteWriteQueue *queue = newSqliteWriteQueue(WRITE_QUEUE_TEST_DB, &(WriteQueueOptions) {.maxBatchItems = 16, .flushWindowMicros = 200});
+    assert_not_null(queue);
+    assert_int(SQLITE_OK, ==, writeQueueExecuteUpdate(queue, "CREATE TABLE test_17(id INTEGER PRIMARY KEY, value INTEGER)", NULL));
+
+    // writer waits for lock held by other connection, so updates of all threads pile up into one batch
+    sqlite3 *lockDb = sqliteDbInit(WRITE_QUEUE_TEST_DB);
+    assert_not_null(lockDb);
+    assert_int(SQLITE_OK, ==, executeUpdate(lockDb, "BEGIN IMMEDIATE", NULL));
+
+    pthread_t threads[WRITE_QUEUE_TEST_THREADS];
+    WriteQueueTestContext contexts[WRITE_QUEUE_TEST_THREADS];
+    for (int i = 0; i < WRITE_QUEUE_TEST_THREADS; i++) {
+        contexts[i] = (WriteQueueTestContext) {.queue = queue, .firstId = i * WRITE_QUEUE_TEST_ROWS + 1};
+        assert_int(0, ==, pthread_create(&threads[i], NULL, writeQueueTestWriter, &contexts[i]));
+    }
+    uint32_t queuedCount = 0;
+    for (int i = 0; i < 200 && queuedCount < WRITE_QUEUE_TEST_THREADS - 1; i++) {   // first batch is taken by blocked writer
+        sqlite3_sleep(1);
+        pthread_mutex_lock(&queue->mutex);
+        queuedCount = queue->queuedCount;
+        pthread_mutex_unlock(&queue->mutex);
+    }
+    assert_int(SQLITE_OK, ==, executeUpdate(lockDb, "COMMIT", NULL));
+    sqliteDbClose(lockDb);
+
+    for (int i = 0; i < WRITE_QUEUE_TEST_THREADS; i++) {
+        void *failures;
+        pthread_join(threads[i], &failures);
+        assert_ptr_equal(NULL, failures);
+    }
+
+    WriteQueueStats stats = writeQueueGetStats(queue);
+    uint64_t updateCount = 1 + WRITE_QUEUE_TEST_THREADS * WRITE_QUEUE_TEST_ROWS * 2;
+    assert_uint64(stats.itemCount, ==, updateCount);
+    assert_uint64(stats.failedCount, ==, WRITE_QUEUE_TEST_THREADS * WRITE_QUEUE_TEST_ROWS);
+    assert_uint64(stats.flushCount, >, 0);
+    assert_uint64(stats.flushCount, <, updateCount);     // at least one batch has committed several updates
+    deleteSqliteWriteQueue(queue);
+
+    sqlite3 *db = sqliteDbInit(WRITE_QUEUE_TEST_DB);
+    ResultSet *rs = executeQuery(db, "SELECT count(*) AS cnt, sum(value) AS total FROM test_17", NULL);
+    assert_true(nextResultSet(rs));
+    int rowCount = WRITE_QUEUE_TEST_THREADS * WRITE_QUEUE_TEST_ROWS;
+    assert_int(rowCount, ==, rsGetInt(rs, "cnt"));
+    assert_true(rsGetI64(rs, "total") == (int64_t) rowCount * (rowCount + 1) / 2);
+    resultSetDelete(rs);
+    sqliteDbClose(db);
+    remove(WRITE_QUEUE_TEST_DB);
+    remove(WRITE_QUEUE_TEST_DB "-wal");
+    remove(WRITE_QUEUE_TEST_DB "-shm");
+    return MUNIT_OK;
+}
+
+#define PARALLEL_SCAN_TEST_DB "../resources/parallel_scan_test.db"
+#define PARALLEL_SCAN_TEST_ROWS 1000
+
+typedef struct ParallelScanTestContext {
+    int64_t rowCount;
+    int64_t total;
+    uint32_t partitionMask;
+    int stopAtPartition;    // -1 - don't stop
+    SqlitePool *pool;
+    sqlite3 *heldReaders[3];    // released by first partition after write, so second one starts after it
+    int64_t tableRowCounts[2];  // table size seen by each partition
+} ParallelScanTestContext;
+
+static int parallelScanTestRows(void *context, uint32_t partition, ResultSet *resultSet) {
+    ParallelScanTestContext *testContext = context;
+    if ((int) partition == testContext->stopAtPartition) return SQLITE_ABORT;
+    int64_t rowCount = 0;
+    int64_t total = 0;
+    while (nextResultSet(resultSet)) {
+        rowCount++;
+        total += rsGetI64(resultSet, "value");
+    }
+    __atomic_add_fetch(&testContext->rowCount, rowCount, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&testContext->total, total, __ATOMIC_RELAXED);
+    __atomic_or_fetch(&testContext->partitionMask, 1u << partition, __ATOMIC_RELAXED);
+    return SQLITE_OK;
+}
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+static int parallelScanSnapshotTestRows(void *context, uint32_t partition, ResultSet *resultSet) {
+    ParallelScanTestContext *testContext = context;
+    if (partition == 0) {
+        int rc = poolExecuteUpdate(testContext->pool, "INSERT INTO test_24 VALUES (:id, 0)", SQL_PARAM_MAP("id", PARALLEL_SCAN_TEST_ROWS + 1));
+        if (rc != SQLITE_OK) return rc;
+        for (uint32_t i = 0; i < sizeof(testContext->heldReaders) / sizeof(testContext->heldReaders[0]); i++) {
+            sqlitePoolRelease(testContext->pool, testContext->heldReaders[i]);
+        }
+    }
+    ResultSet *rs = executeQuery(resultSet->db, "SELECT count(*) AS row_count FROM test_24", NULL);    // in partition read transaction
+    if (!nextResultSet(rs)) {
+        resultSetDelete(rs);
+        return SQLITE_ERROR;
+    }
+    testContext->tableRowCounts[partition] = rsGetI64(rs, "row_count");
+    resultSetDelete(rs);
+    return parallelScanTestRows(context, partition, resultSet);
+}
+#endif
+
+static int parallelScanTestBatch(void *context, uint32_t partition, ColumnBatch *batch) {
+    ParallelScanTestContext *testContext = context;     // batch callbacks are serialized
+    int column = columnBatchGetColumnIndex(batch, "value");
+    for (uint32_t i = 0; i < batch->rowCount; i++) {
+        testContext->total += batch->columns[column].intValues[i];
+    }
+    testContext->rowCount += batch->rowCount;
+    testContext->partitionMask |= 1u << partition;
+    return SQLITE_OK;
+}
+
+static MunitResult sqlLiteParallelScanTest(const MunitParameter params[], void *data) {
+    const char *scanSql = "SELECT id, value FROM test_24 WHERE id BETWEEN :scan_from AND :scan_to AND value >= :min_value";
+    SqlitePool *pool = newSqlitePool(PARALLEL_SCAN_TEST_DB, 4);
+    assert_not_null(pool);
+    int rc = poolExecuteUpdate(pool, "CREATE TABLE IF NOT EXISTS test_24(id INTEGER PRIMARY KEY, value INTEGER)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+
+    ParallelScanTestContext context = {.stopAtPartition = -1};
+    rc = poolParallelScan(pool, scanSql, SQL_PARAM_MAP("min_value", 0), &(ParallelScanOptions) {.table = "test_24"}, parallelScanTestRows, &context);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint32(0, ==, context.partitionMask);     // empty table
+
+    sqlite3 *writer = sqlitePoolAcquireWriter(pool);
+    assert_int(SQLITE_OK, ==, sqliteBeginTransaction(writer, TRANSACTION_IMMEDIATE));
+    for (int i = 1; i <= PARALLEL_SCAN_TEST_ROWS; i++) {
+        assert_int(SQLITE_OK, ==, executeUpdate(writer, "INSERT INTO test_24 VALUES (:id, :int_val)", SQL_PARAM_MAP("id", i, "int_val", i)));
+    }
+    assert_int(SQLITE_OK, ==, sqliteCommitTransaction(writer));
+    sqlitePoolRelease(pool, writer);
+
+    rc = poolParallelScan(pool, scanSql, SQL_PARAM_MAP("min_value", 0), &(ParallelScanOptions) {.table = "test_24"}, parallelScanTestRows, &context);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int64(PARALLEL_SCAN_TEST_ROWS, ==, context.rowCount);
+    assert_int64((int64_t) PARALLEL_SCAN_TEST_ROWS * (PARALLEL_SCAN_TEST_ROWS + 1) / 2, ==, context.total);
+    assert_uint32(0xF, ==, context.partitionMask);
+
+    // merged column batches
+    context = (ParallelScanTestContext) {.stopAtPartition = -1};
+    rc = poolParallelScanBatches(pool, scanSql, SQL_PARAM_MAP("min_value", 501), &(ParallelScanOptions) {.table = "test_24", .keyColumn = "id", .partitionCount = 2, .batchRows = 64},
+                                 parallelScanTestBatch, &context);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_int64(PARALLEL_SCAN_TEST_ROWS / 2, ==, context.rowCount);
+    assert_int64((int64_t) (501 + PARALLEL_SCAN_TEST_ROWS) * PARALLEL_SCAN_TEST_ROWS / 4, ==, context.total);
+    assert_uint32(0x2, ==, context.partitionMask);    // first half is filtered out
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    // row written after first partition started is not seen by second one, all partitions read the same snapshot
+    context = (ParallelScanTestContext) {.stopAtPartition = -1, .pool = pool};
+    for (uint32_t i = 0; i < 3; i++) {
+        context.heldReaders[i] = sqlitePoolAcquireReader(pool);     // second partition waits for reader
+    }
+    rc = poolParallelScan(pool, scanSql, SQL_PARAM_MAP("min_value", 0), &(ParallelScanOptions) {.table = "test_24", .partitionCount = 2}, parallelScanSnapshotTestRows, &context);
+    assert_int(SQLITE_OK, ==, rc);
+    assert_uint32(0x3, ==, context.partitionMask);
+    assert_int64(PARALLEL_SCAN_TEST_ROWS, ==, context.tableRowCounts[0]);
+    assert_int64(context.tableRowCounts[0], ==, context.tableRowCounts[1]);
+    assert_int64(PARALLEL_SCAN_TEST_ROWS, ==, context.rowCount);
+    assert_int(SQLITE_OK, ==, poolExecuteUpdate(pool, "DELETE FROM test_24 WHERE id > :id", SQL_PARAM_MAP("id", PARALLEL_SCAN_TEST_ROWS)));
+#endif
+
+    // errors
+    context = (ParallelScanTestContext) {.stopAtPartition = 2};
+    rc = poolParallelScan(pool, scanSql, SQL_PARAM_MAP("min_value", 0), &(ParallelScanOptions) {.table = "test_24"}, parallelScanTestRows, &context);
+    assert_int(SQLITE_ABORT, ==, rc);
+    rc = poolParallelScan(pool, "SELECT id, value FROM test_24", NULL, &(ParallelScanOptions) {.table = "test_24"}, parallelScanTestRows, &context);
+    assert_int(SQLITE_RANGE, ==, rc);   // without bounds each partition would read whole table
+    rc = poolParallelScan(pool, scanSql, NULL, &(ParallelScanOptions) {.table = "not_existing"}, parallelScanTestRows, &context);
+    assert_int(SQLITE_ERROR, ==, rc);
+    assert_int(SQLITE_MISUSE, ==, poolParallelScan(pool, scanSql, NULL, NULL, parallelScanTestRows, &context));
+
+    deleteSqlitePool(pool);
+    remove(PARALLEL_SCAN_TEST_DB);
+    remove(PARALLEL_SCAN_TEST_DB "-wal");
+    remove(PARALLEL_SCAN_TEST_DB "-shm");
+    return MUNIT_OK;
+}
+
+#define SHARD_TEST_COUNT 3
+#define SHARD_TEST_ROWS 300
+
+static const char *const SHARD_TEST_DBS[SHARD_TEST_COUNT] = {"../resources/shard_test_0.db", "../resources/shard_test_1.db", "../resources/shard_test_2.db"};
+
+static MunitResult sqlLiteShardsTest(const MunitParameter params[], void *data) {
+    SqliteShards *shards = newSqliteShards(SHARD_TEST_DBS, SHARD_TEST_COUNT, "id", NULL);
+    assert_not_null(shards);
+    int rc = shardsExecuteUpdateAll(shards, "CREATE TABLE IF NOT EXISTS test_25(id INTEGER PRIMARY KEY, value INTEGER, name TEXT)", NULL);
+    assert_int(SQLITE_OK, ==, rc);
+    for (int i = 1; i <= SHARD_TEST_ROWS; i++) {
+        char name[16];
+        sprintf(name, "name_%03d", i);
+        rc = shardsExecuteUpdate(shards, "INSERT INTO test_25 VALUES (:id, :int_val, :name)", SQL_PARAM_MAP("id", i, "int_val", i % 100, "name", name));
+        assert_int(SQLITE_OK, ==, rc);
+    }
+    assert_int(SQLITE_MISUSE, ==, shardsExecuteUpdate(shards, "INSERT INTO test_25 VALUES (:other, 0, NULL)", SQL_PARAM_MAP("other", 1)));
+
+    // rows are spread over all files
+    for (uint32_t i = 0; i < SHARD_TEST_COUNT; i++) {
+        ResultSet *rs = poolExecuteQuery(shards->pools[i], "SELECT count(*) AS row_count FROM test_25", NULL);
+        assert_true(nextResultSet(rs));
+        assert_true(rsGetInt(rs, "row_count") > SHARD_TEST_ROWS / SHARD_TEST_COUNT / 2);
+        resultSetDelete(rs);
+    }
+
+    // keyed query is routed to single shard
+    ResultSet *rs = shardsExecuteQuery(shards, "SELECT name FROM test_25 WHERE id = :id", SQL_PARAM_MAP("id", 42));
+    assert_true(nextResultSet(rs));
+    assert_string_equal("name_042", rsGetString(rs, "name"));
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    // unordered rows are concatenated
+    rs = shardsExecuteQuery(shards, "SELECT id, value FROM test_25 WHERE value >= :min_value", SQL_PARAM_MAP("min_value", 50));
+    assert_not_null(rs);
+    int64_t rowCount = 0;
+    int64_t total = 0;
+    while (nextResultSet(rs)) {
+        rowCount++;
+        total += rsGetI64(rs, "value");
+    }
+    assert_true(rowCount == 150);
+    assert_true(total == 3 * (50 + 99) * 50 / 2);
+    resultSetDelete(rs);
+
+    // ordered rows are merged, ties are ordered by second term
+    rs = shardsExecuteQuery(shards, "SELECT t.id, t.value FROM test_25 t ORDER BY t.value DESC, id LIMIT :row_limit", SQL_PARAM_MAP("row_limit", 7));
+    assert_not_null(rs);
+    const int expectedIds[] = {99, 199, 299, 98, 198, 298, 97};
+    for (int i = 0; i < 7; i++) {
+        assert_true(nextResultSet(rs));
+        assert_int(expectedIds[i], ==, rsGetInt(rs, "id"));
+    }
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+
+    rs = shardsExecuteQuery(shards, "SELECT name FROM test_25 WHERE name LIKE 'name_1%' ORDER BY 1 LIMIT 3", NULL);
+    assert_true(nextResultSet(rs));
+    assert_string_equal("name_100", rsGetString(rs, "name"));
+    assert_true(nextResultSet(rs));
+    assert_string_equal("name_101", rsGetString(rs, "name"));
+    resultSetDelete(rs);
+
+    // merged values keep types and full double precision
+    const char *typedSqls[] = {"SELECT id, name, id / 3.0 AS ratio FROM test_25 WHERE id <= 3",
+                               "SELECT id, name, id / 3.0 AS ratio FROM test_25 WHERE id <= 3 ORDER BY id"};
+    for (int i = 0; i < 2; i++) {
+        rs = shardsExecuteQuery(shards, typedSqls[i], NULL);
+        assert_not_null(rs);
+        rowCount = 0;
+        while (nextResultSet(rs)) {
+            rowCount++;
+            assert_int(DB_VALUE_INT, ==, rsGetColumnType(rs, "id"));
+            assert_int(DB_VALUE_TEXT, ==, rsGetColumnType(rs, "name"));
+            assert_int(DB_VALUE_REAL, ==, rsGetColumnType(rs, "ratio"));
+            assert_true(rsGetDouble(rs, "ratio") == rsGetI64(rs, "id") / 3.0);
+        }
+        assert_int64(3, ==, rowCount);
+        resultSetDelete(rs);
+    }
+
+    // not supported merges and shard errors
+    assert_null(shardsExecuteQuery(shards, "SELECT id FROM test_25 ORDER BY value", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT id FROM test_25 ORDER BY id LIMIT 5 OFFSET 5", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT count(*) AS cnt FROM test_25", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT Sum (value) FROM test_25", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT value, count(*) FROM test_25 GROUP BY value", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT DISTINCT value FROM test_25", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT value FROM test_25 UNION SELECT id FROM test_25", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT name FROM test_25 ORDER BY name COLLATE NOCASE", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT id, row_number() OVER (ORDER BY id) AS rn FROM test_25 ORDER BY id", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT k, c FROM (SELECT value % 2 AS k, count(*) AS c FROM test_25 GROUP BY k)", NULL));
+    assert_null(shardsExecuteQuery(shards, "WITH c AS (SELECT DISTINCT value FROM test_25) SELECT value FROM c", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT t.id FROM test_25 t JOIN (SELECT id FROM test_25 LIMIT 5) s ON s.id = t.id", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT t.id FROM test_25 t, (SELECT value FROM test_25 UNION SELECT id FROM test_25) s", NULL));
+    rs = shardsExecuteQuery(shards, "SELECT id FROM (SELECT id, value FROM test_25 WHERE value = 99) ORDER BY id", NULL);
+    assert_not_null(rs);    // subquery of each shard rows
+    for (int i = 0; i < 3; i++) {
+        assert_true(nextResultSet(rs));
+        assert_int(99 + i * 100, ==, rsGetInt(rs, "id"));
+    }
+    assert_false(nextResultSet(rs));
+    resultSetDelete(rs);
+    rs = shardsExecuteQuery(shards, "SELECT max(id, value) AS top, name FROM test_25 WHERE id IN (SELECT max(id) FROM test_25) ORDER BY name COLLATE BINARY DESC", NULL);
+    assert_not_null(rs);    // scalar max() and aggregate of subquery
+    rowCount = 0;
+    while (nextResultSet(rs)) {
+        rowCount++;
+    }
+    assert_int64(SHARD_TEST_COUNT, ==, rowCount);   // max id of each shard
+    resultSetDelete(rs);
+#ifdef SQLITE_ENABLE_COLUMN_METADATA
+    assert_int(SQLITE_OK, ==, shardsExecuteUpdateAll(shards, "CREATE TABLE IF NOT EXISTS test_25_nocase(id INTEGER PRIMARY KEY, name TEXT COLLATE NOCASE)", NULL));
+    assert_null(shardsExecuteQuery(shards, "SELECT id, name FROM test_25_nocase ORDER BY name", NULL));
+    rs = shardsExecuteQuery(shards, "SELECT id, name FROM test_25_nocase ORDER BY id", NULL);
+    assert_not_null(rs);
+    resultSetDelete(rs);
+#endif
+    assert_null(shardsExecuteQuery(shards, "SELECT id FROM not_existing", NULL));
+    assert_null(newSqliteShards(SHARD_TEST_DBS, 0, "id", NULL));
+
+    deleteSqliteShards(shards);
+    for (int i = 0; i < SHARD_TEST_COUNT; i++) {
+        char path[64];
+        remove(SHARD_TEST_DBS[i]);
+        sprintf(path, "%s-wal", SHARD_TEST_DBS[i]);
+        remove(path);
+        sprintf(path, "%s-shm", SHARD_TEST_DBS[i]);
+        remove(path);
+    }
+    return MUNIT_OK;
+}
+#endif
+
 static MunitTest sqlWrapperTests[] = {
         {.name =  "Param map test - should correctly create params and map to db values", .test = sqlLiteParameterTest},
         {.name =  "Query string test - should correctly create and format query string", .test = sqlLiteQueryStringTest},
         {.name =  "Metadata test - should correctly return db table column data", .test = sqlLiteTableMetadataTest},
         {.name =  "Full test - should correctly execute queries and get results", .test = sqlLiteFullTest},
         {.name =  "Callback test - should correctly work same with callback functions", .test = sqlLiteCallbackTest},
+        {.name =  "Statement cache test - should reuse prepared statements and evict least recently used", .test = sqlLiteStatementCacheTest},
+        {.name =  "Parameter binding test - should bind named parameters without inlining to sql", .test = sqlLiteParameterBindingTest},
+        {.name =  "Batch update test - should execute rows in transactions and report batch stats", .test = sqlLiteBatchUpdateTest},
+        {.name =  "Column batch test - should fetch rows to column major arrays", .test = sqlLiteColumnBatchTest},
+        {.name =  "Callback result set test - should store all rows in single arena", .test = sqlLiteCallbackResultSetTest},
+        {.name =  "Column handle test - should resolve column names once per statement", .test = sqlLiteColumnHandleTest},
+        {.name =  "Query stats test - should aggregate executions per sql template", .test = sqlLiteQueryStatsTest},
+        {.name =  "Schema cache test - should load table metadata once per schema version", .test = sqlLiteSchemaCacheTest},
+        {.name =  "Arena test - should allocate query strings and result sets from arena", .test = sqlLiteArenaTest},
+        {.name =  "Import test - should bulk import delimited file with quoted fields", .test = sqlLiteImportTest},
+        {.name =  "Export test - should write result set rows as CSV and JSON Lines", .test = sqlLiteExportTest},
+        {.name =  "Blob test - should bind, fetch and stream blob values", .test = sqlLiteBlobTest},
+        {.name =  "Row mapper test - should map rows to struct array and bind struct parameters", .test = sqlLiteRowMapperTest},
+        {.name =  "Parameter list test - should bind stack parameter lists of any size", .test = sqlLiteParamListTest},
+        {.name =  "Transaction test - should nest savepoints and retry busy units", .test = sqlLiteTransactionTest},
+        {.name =  "Busy policy test - should back off until deadline and record lock waits", .test = sqlLiteBusyTest},
+        {.name =  "Deadline test - should interrupt runaway queries and keep connection reusable", .test = sqlLiteDeadlineTest},
+        {.name =  "Open options test - should apply pragmas on open and fail atomically", .test = sqlLiteOpenOptionsTest},
+#ifdef SQLITE_WRAPPER_THREADS
+        {.name =  "Pool test - should run concurrent readers with single writer", .test = sqlLitePoolTest},
+        {.name =  "Async test - should execute queries on worker thread", .test = sqlLiteAsyncTest},
+        {.name =  "Write queue test - should group concurrent updates with own results", .test = sqlLiteWriteQueueTest},
+        {.name =  "Parallel scan test - should split key range over reader connections", .test = sqlLiteParallelScanTest},
+        {.name =  "Shards test - should route keyed writes and merge reads of all files", .test = sqlLiteShardsTest},
+#endif
         END_OF_TESTS
 };
 
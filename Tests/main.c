@@ -4,7 +4,8 @@
 int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
     MunitTest emptyTests[] = {END_OF_TESTS};
     MunitSuite testSuitArray[] = {
-            sqliteWrapperTestSuite
+            sqliteWrapperTestSuite,
+            {NULL, NULL, NULL, 0, MUNIT_SUITE_OPTION_NONE}
     };
 
     MunitSuite baseSuite = {
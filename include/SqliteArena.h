@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SQLITE_ARENA_DEFAULT_BLOCK_SIZE
+    #define SQLITE_ARENA_DEFAULT_BLOCK_SIZE 8192
+#endif
+
+#define SQLITE_ARENA_ALIGNMENT sizeof(void *)
+
+typedef struct SqliteArenaBlock {
+    struct SqliteArenaBlock *next;
+    size_t size;
+    size_t capacity;
+    char data[];
+} SqliteArenaBlock;
+
+// Bump allocator, all allocations are released at once with reset. Not thread safe, use one arena per request/thread
+typedef struct SqliteArena {
+    SqliteArenaBlock *blocks;
+    SqliteArenaBlock *current;
+    void *lastAllocation;       // can be extended in place
+    size_t blockSize;
+    size_t allocatedBytes;      // since last reset
+} SqliteArena;
+
+
+SqliteArena *newSqliteArena(size_t blockSize);
+
+// Functions below fallback to malloc/realloc/free when arena is NULL
+void *sqliteArenaAlloc(SqliteArena *arena, size_t size);
+void *sqliteArenaCalloc(SqliteArena *arena, size_t size);
+void *sqliteArenaRealloc(SqliteArena *arena, void *ptr, size_t oldSize, size_t newSize);
+void sqliteArenaFree(SqliteArena *arena, void *ptr);  // no-op for arena memory
+char *sqliteArenaStrdup(SqliteArena *arena, const char *str);
+
+// Blocks are kept for reuse, so warmed up arena doesn't call malloc
+void sqliteArenaReset(SqliteArena *arena);
+void deleteSqliteArena(SqliteArena *arena);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <pthread.h>
+#include "SqliteResultSet.h"
+#include "SqliteOpenOptions.h"
+
+#ifndef SQLITE_ASYNC_MAX_PARAMS
+    #define SQLITE_ASYNC_MAX_PARAMS 32      // named parameters per request
+#endif
+
+typedef struct AsyncResult {
+    uint64_t id;                // request id returned on submit
+    int rc;
+    ResultSet *resultSet;       // materialized rows for query, owned by receiver and freed with resultSetDelete()
+    int changes;                // rows changed by update
+    int64_t lastInsertRowId;
+    void *userData;
+} AsyncResult;
+
+// Called on worker thread, result set ownership is passed to callback
+typedef void (*AsyncCompletion)(void *userData, AsyncResult *result);
+// Called on worker thread after result is added to completion queue, e.g. to wake up event loop
+typedef void (*AsyncNotify)(void *context);
+
+typedef struct AsyncOptions {
+    const SqliteOpenOptions *openOptions;
+    AsyncNotify notify;
+    void *notifyContext;
+} AsyncOptions;
+
+typedef struct AsyncRequest AsyncRequest;
+
+// Single worker thread with own connection, requests are executed in submit order.
+// Consecutive updates taken by worker at once are committed by single transaction
+typedef struct SqliteAsync {
+    sqlite3 *db;
+    pthread_t worker;
+    pthread_mutex_t mutex;
+    pthread_cond_t requestAdded;
+    pthread_cond_t resultAdded;
+    AsyncRequest *requestHead;
+    AsyncRequest *requestTail;
+    AsyncRequest *resultHead;
+    AsyncRequest *resultTail;
+    uint64_t nextId;
+    bool isStopping;
+    AsyncNotify notify;
+    void *notifyContext;
+} SqliteAsync;
+
+
+// Connection is opened with SQLITE_OPEN_NOMUTEX, as it is used only by worker thread
+SqliteAsync *newSqliteAsync(const char *dbName, const AsyncOptions *options);
+
+// Sql and parameter values are copied, so they can be released right after submit. Returns request id, 0 on error.
+// Without completion callback result is added to completion queue
+uint64_t sqliteAsyncQuery(SqliteAsync *async, const char *sql, str_DbValueMap *queryParams, AsyncCompletion completion, void *userData);
+uint64_t sqliteAsyncUpdate(SqliteAsync *async, const char *sql, str_DbValueMap *queryParams, AsyncCompletion completion, void *userData);
+
+// Takes any completed result without blocking
+bool sqliteAsyncPoll(SqliteAsync *async, AsyncResult *result);
+// Waits for result of request 'id' (0 - any request) up to timeout, returns false on timeout
+bool sqliteAsyncWait(SqliteAsync *async, uint64_t id, AsyncResult *result, uint32_t timeoutMs);
+
+// Pending requests are executed before worker is stopped, not received results are deleted
+void deleteSqliteAsync(SqliteAsync *async);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SqliteConnection.h"
+#include "SqliteRowMapper.h"
+
+#ifndef SQLITE_BATCH_DEFAULT_COMMIT_ROWS
+    #define SQLITE_BATCH_DEFAULT_COMMIT_ROWS 1000
+#endif
+
+typedef struct BatchOptions {
+    uint32_t commitRows;        // commit after every N rows, 0 - no row limit
+    uint32_t commitIntervalMs;  // commit when transaction is open longer than T milliseconds, 0 - no time limit
+} BatchOptions;
+
+typedef struct BatchStats {
+    uint64_t rowsWritten;       // rows from committed transactions
+    uint32_t batchCount;
+    uint64_t lastBatchMicros;   // latency from begin to commit
+    uint64_t maxBatchMicros;
+    uint64_t totalBatchMicros;
+} BatchStats;
+
+// Supplier result when no row is ready after waiting, open transaction is committed once commit interval is elapsed
+#define SQLITE_BATCH_ROW_PENDING ((str_DbValueMap *) -1)
+
+// Returns next row parameters or NULL when there are no more rows. Slow producer should wait with timeout
+// and return SQLITE_BATCH_ROW_PENDING, so transaction is not held open while waiting
+typedef str_DbValueMap *(*BatchRowSupplier)(void *context, uint64_t rowIndex);
+
+
+// Prepares statement once and executes it for each row in explicit transactions.
+// On error current transaction is rolled back, already committed rows stay in db. Multi statement sql is SQLITE_MISUSE
+int executeBatchUpdate(sqlite3 *db, const char *sql, str_DbValueMap **rows, uint32_t rowCount, const BatchOptions *options, BatchStats *stats);
+int executeBatchUpdateFrom(sqlite3 *db, const char *sql, BatchRowSupplier nextRow, void *context, const BatchOptions *options, BatchStats *stats);
+// Binds struct fields to parameters with the same name as field column, no parameter map is built per row
+int executeBatchStructUpdate(sqlite3 *db, const char *sql, const RowMapping *mapping, const void *rows, uint32_t rowCount, const BatchOptions *options, BatchStats *stats);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "SqliteParameter.h"
+
+#ifndef SQLITE_BLOB_CHUNK_SIZE
+    #define SQLITE_BLOB_CHUNK_SIZE (16 * 1024)
+#endif
+
+// Incremental I/O cursor over single blob value, size is fixed when blob is opened
+typedef struct SqliteBlob {
+    sqlite3 *db;
+    sqlite3_blob *handle;
+    uint32_t size;
+    uint32_t position;
+} SqliteBlob;
+
+// Receives next blob chunk, any other result than SQLITE_OK stops reading
+typedef int (*BlobChunkSink)(void *context, const void *data, uint32_t size);
+// Fills buffer with up to 'capacity' bytes and sets 'size', 0 size ends writing
+typedef int (*BlobChunkSource)(void *context, void *buffer, uint32_t capacity, uint32_t *size);
+
+
+// Opens blob in "main" database, NULL is returned on error and message is available with sqlite3_errmsg()
+SqliteBlob *sqliteBlobOpen(sqlite3 *db, const char *table, const char *column, int64_t rowId, bool isWritable);
+// Moves cursor to the same column of another row, much cheaper than close and open
+int sqliteBlobReopen(SqliteBlob *blob, int64_t rowId);
+
+// Reads up to 'length' bytes from current position, 'readLength' is 0 at the end of blob
+int sqliteBlobRead(SqliteBlob *blob, void *buffer, uint32_t length, uint32_t *readLength);
+// Blob can't be resized, writing past the end fails with SQLITE_ERROR. Insert DB_BLOB_VALUE(NULL, size) to reserve space
+int sqliteBlobWrite(SqliteBlob *blob, const void *data, uint32_t length);
+int sqliteBlobSeek(SqliteBlob *blob, uint32_t position);
+
+// Stream rest of the blob by SQLITE_BLOB_CHUNK_SIZE chunks, without loading whole value into memory
+int sqliteBlobReadTo(SqliteBlob *blob, BlobChunkSink sink, void *context);
+int sqliteBlobWriteFrom(SqliteBlob *blob, BlobChunkSource source, void *context);
+
+int sqliteBlobClose(SqliteBlob *blob);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "SqliteOpenOptions.h"
+
+#ifndef SQLITE_BUSY_INITIAL_DELAY_MICROS
+    #define SQLITE_BUSY_INITIAL_DELAY_MICROS 250
+#endif
+
+#ifndef SQLITE_BUSY_MAX_DELAY_MICROS
+    #define SQLITE_BUSY_MAX_DELAY_MICROS 50000
+#endif
+
+// Lock wait histogram: < 100us, < 1ms, < 10ms, < 100ms, < 1s, < 10s, >= 10s
+#define SQLITE_BUSY_HISTOGRAM_BUCKETS 7
+
+typedef struct BusyPolicy {
+    uint32_t timeoutMs;             // deadline of single lock wait, 0 - return SQLITE_BUSY immediately
+    uint32_t initialDelayMicros;    // 0 - SQLITE_BUSY_INITIAL_DELAY_MICROS, doubled on each retry
+    uint32_t maxDelayMicros;        // 0 - SQLITE_BUSY_MAX_DELAY_MICROS
+    bool isJitterDisabled;          // by default delay is randomized in [delay / 2, delay], so waiters don't retry in lockstep
+} BusyPolicy;
+
+typedef struct BusyStats {
+    uint64_t waitCount;             // lock waits, single wait can be retried several times
+    uint64_t retryCount;
+    uint64_t timeoutCount;          // waits ended with SQLITE_BUSY
+    uint64_t totalWaitMicros;
+    uint64_t maxWaitMicros;
+    uint64_t waitHistogram[SQLITE_BUSY_HISTOGRAM_BUCKETS];
+} BusyStats;
+
+// Busy handler state of single connection
+typedef struct BusyState {
+    BusyPolicy policy;
+    BusyStats stats;
+    uint64_t waitStartMicros;
+    uint64_t waitMicros;            // current wait, added to histogram when next wait starts, on timeout or on stats read
+    bool isWaitPending;
+} BusyState;
+
+
+// Replaces sqlite3_busy_timeout() with backoff policy. NULL policy - SQLITE_DEFAULT_BUSY_TIMEOUT_MS with default delays.
+// sqliteDbInit() installs default policy, connection should be opened by wrapper
+int sqliteSetBusyPolicy(sqlite3 *db, const BusyPolicy *policy);
+// Stats are updated by connection thread, read them from the same thread
+BusyStats sqliteGetBusyStats(sqlite3 *db);
+void sqliteResetBusyStats(sqlite3 *db);
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+// Monotonic time source for batch, instrumentation and timeout measurements
+uint64_t sqliteClockMicros(void);
+uint64_t sqliteClockMillis(void);
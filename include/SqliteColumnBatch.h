@@ -0,0 +1,48 @@
+#pragma once
+
+#include "SqliteResultSet.h"
+
+#ifndef SQLITE_COLUMN_BATCH_DEFAULT_BYTES
+    #define SQLITE_COLUMN_BATCH_DEFAULT_BYTES 4096
+#endif
+
+// Column major values, type is taken from the first not NULL value of each batch and other values are converted to it
+typedef struct ColumnVector {
+    const char *name;
+    DbValueType type;
+    int64_t *intValues;     // DB_VALUE_INT
+    double *doubleValues;   // DB_VALUE_REAL
+    uint32_t *offsets;      // DB_VALUE_TEXT, DB_VALUE_BLOB: value bytes are in [offsets[row], offsets[row + 1])
+    uint8_t *bytes;
+    uint32_t bytesCapacity;
+    uint8_t *nullBitmap;    // bit is set for NULL values
+} ColumnVector;
+
+typedef struct ColumnBatch {
+    uint32_t rowCount;
+    uint32_t rowCapacity;
+    uint32_t columnCount;
+    ColumnVector *columns;
+} ColumnBatch;
+
+
+ColumnBatch *newColumnBatch(uint32_t rowCapacity);
+
+// Steps result set up to batch row capacity and returns fetched row count, 0 when result set is done.
+// Buffers are reused for next batch, so values are valid only until next fetch. When values can't be stored,
+// result set 'stepResult' is SQLITE_NOMEM and the last stepped row is fetched again by next call
+uint32_t rsFetchColumnBatch(ResultSet *resultSet, ColumnBatch *batch);
+
+int columnBatchGetColumnIndex(ColumnBatch *batch, const char *columnName);
+
+static inline bool columnBatchIsNull(ColumnBatch *batch, uint32_t column, uint32_t row) {
+    return (batch->columns[column].nullBitmap[row >> 3] >> (row & 7)) & 1;
+}
+
+static inline const uint8_t *columnBatchGetBytes(ColumnBatch *batch, uint32_t column, uint32_t row, uint32_t *length) {
+    ColumnVector *vector = &batch->columns[column];
+    *length = vector->offsets[row + 1] - vector->offsets[row];
+    return vector->bytes + vector->offsets[row];
+}
+
+void deleteColumnBatch(ColumnBatch *batch);
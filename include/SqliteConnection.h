@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SqliteStatementCache.h"
+#include "SqliteQueryStats.h"
+#include "SqliteSchemaCache.h"
+#include "SqliteBusy.h"
+#include "SqliteDeadline.h"
+
+#ifndef SQLITE_MAX_CONNECTIONS
+    #define SQLITE_MAX_CONNECTIONS 1024     // open wrapper connections, sqliteDbInit() fails when all are used
+#endif
+
+// Per connection wrapper state, registered for each db opened with sqliteDbInit()
+typedef struct SqliteConnection {
+    sqlite3 *db;
+    StatementCache *statementCache;
+    QueryStatsRegistry *queryStats;     // created on first enable
+    SchemaCache *schemaCache;           // created on first table lookup
+    BusyState busyState;                // used when wrapper busy handler is installed
+    DeadlineState deadlineState;        // armed by sqliteSetDeadline()
+    DeadlineState *activeDeadline;      // single call or cursor deadline while its statement is executed
+    uint32_t armedDeadlineCount;        // progress handler is installed while any deadline is armed
+    uint32_t savepointDepth;            // nested sqliteBeginTransaction() levels
+    bool isOwnTransaction;              // outer transaction is started by sqliteBeginTransaction()
+} SqliteConnection;
+
+
+// Returns NULL when SQLITE_MAX_CONNECTIONS connections are already registered
+SqliteConnection *sqliteConnectionRegister(sqlite3 *db);
+SqliteConnection *sqliteConnectionOf(sqlite3 *db);
+void sqliteConnectionUnregister(sqlite3 *db);
+
+// Take statement from connection cache or prepare new one, should be returned with sqliteStatementRelease()
+SqliteStatement *sqliteAcquireStatement(sqlite3 *db, const char *sql);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "SqliteParameter.h"
+
+#ifndef SQLITE_DEADLINE_PROGRESS_OPS
+    #define SQLITE_DEADLINE_PROGRESS_OPS 1000   // VM instructions between deadline and cancel token checks
+#endif
+
+// Extended codes of SQLITE_INTERRUPT, so (rc & 0xFF) == SQLITE_INTERRUPT checks still match
+#define SQLITE_DEADLINE_EXCEEDED (SQLITE_INTERRUPT | (64 << 8))
+#define SQLITE_QUERY_CANCELLED (SQLITE_INTERRUPT | (65 << 8))
+
+// Can be shared between connections and cancelled from any thread
+typedef struct SqliteCancelToken {
+    int isCancelled;
+} SqliteCancelToken;
+
+typedef struct QueryDeadline {
+    uint32_t timeoutMs;             // 0 - no time limit
+    SqliteCancelToken *cancelToken; // optional
+} QueryDeadline;
+
+struct SqliteConnection;
+
+// Deadline of connection, single call or cursor
+typedef struct DeadlineState {
+    sqlite3 *db;
+    struct SqliteConnection *connection;    // resolved once when armed
+    uint64_t deadlineMicros;        // 0 - no time limit
+    SqliteCancelToken *cancelToken;
+    int interruptCode;              // SQLITE_DEADLINE_EXCEEDED or SQLITE_QUERY_CANCELLED after deadline is tripped, otherwise 0
+    bool isArmed;
+} DeadlineState;
+
+
+// Arms deadline for all following statements on connection, until sqliteClearDeadline().
+// Uses sqlite3_progress_handler(), so it replaces any user progress handler. Busy wait is limited by deadline too.
+// Returns SQLITE_QUERY_CANCELLED without arming when token is already cancelled
+int sqliteSetDeadline(sqlite3 *db, const QueryDeadline *deadline);
+void sqliteClearDeadline(sqlite3 *db);
+
+// Deadline of single call or cursor, which is checked only between sqliteDeadlineEnter() and sqliteDeadlineLeave(),
+// so other statements of connection are not interrupted. Connection deadline is still checked. NULL deadline is not armed.
+// Progress handler is installed while any deadline of connection is armed, so armed state should be disarmed after use
+int sqliteDeadlineInit(DeadlineState *state, sqlite3 *db, const QueryDeadline *deadline);
+// Only switches active deadline, so it's cheap for each cursor step. Returns previous active deadline, which is restored on leave.
+// Not armed state is not entered and NULL is returned
+DeadlineState *sqliteDeadlineEnter(DeadlineState *state);
+void sqliteDeadlineLeave(DeadlineState *state, DeadlineState *previous);
+void sqliteDeadlineDisarm(DeadlineState *state);
+// Returns interrupt code when deadline has passed or token is cancelled, otherwise SQLITE_OK
+int sqliteDeadlineCheck(DeadlineState *state);
+
+// Checks active single call deadline, then connection one
+int sqliteDeadlineErrorCode(sqlite3 *db, int rc);
+// Interrupt or busy error of tripped deadline is returned as SQLITE_DEADLINE_EXCEEDED or SQLITE_QUERY_CANCELLED
+static inline int sqliteDeadlineResult(sqlite3 *db, int rc) {
+    return rc == SQLITE_INTERRUPT || rc == SQLITE_BUSY ? sqliteDeadlineErrorCode(db, rc) : rc;
+}
+
+void sqliteCancel(SqliteCancelToken *token);
+bool sqliteIsCancelled(SqliteCancelToken *token);
+void sqliteCancelTokenReset(SqliteCancelToken *token);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SqliteResultSet.h"
+
+#ifndef SQLITE_EXPORT_DEFAULT_BUFFER_SIZE
+    #define SQLITE_EXPORT_DEFAULT_BUFFER_SIZE (64 * 1024)
+#endif
+
+#if defined(__unix__) || defined(__APPLE__) || defined(ESP_PLATFORM)
+    #define SQLITE_EXPORT_HAS_FD
+#endif
+
+typedef enum ExportFormat {
+    EXPORT_CSV,
+    EXPORT_JSON_LINES
+} ExportFormat;
+
+typedef struct ExportOptions {
+    ExportFormat format;
+    char delimiter;         // CSV field delimiter, ',' when not set
+    bool hasHeader;         // CSV column names row
+    uint32_t bufferSize;    // SQLITE_EXPORT_DEFAULT_BUFFER_SIZE when not set
+} ExportOptions;
+
+typedef struct ExportStats {
+    uint64_t rowsExported;
+    uint64_t bytesWritten;   // bytes accepted by sink
+    uint32_t flushCount;
+    uint64_t elapsedMicros;
+} ExportStats;
+
+// Receives filled output buffer, any other result than SQLITE_OK stops export
+typedef int (*ExportSink)(void *context, const char *data, size_t size);
+
+
+// Steps result set to the end and writes rows to output buffer, which is passed to sink when full.
+// Numbers are formatted from native values, blobs are written as hex. NULL is empty CSV field or JSON null.
+// Only prepared statement result set is supported, callback result set returns SQLITE_MISUSE
+int rsExportToSink(ResultSet *resultSet, ExportSink sink, void *context, const ExportOptions *options, ExportStats *stats);
+
+#ifdef SQLITE_EXPORT_HAS_FD
+int rsExportToFd(ResultSet *resultSet, int fd, const ExportOptions *options, ExportStats *stats);
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include "SqliteConnection.h"
+
+#ifndef SQLITE_IMPORT_DEFAULT_COMMIT_ROWS
+    #define SQLITE_IMPORT_DEFAULT_COMMIT_ROWS 100000
+#endif
+
+#ifndef SQLITE_IMPORT_CHUNK_SIZE
+    #define SQLITE_IMPORT_CHUNK_SIZE (1024 * 1024)      // bytes parsed to one batch, grows for longer records
+#endif
+
+#ifndef SQLITE_IMPORT_MAX_COLUMNS
+    #define SQLITE_IMPORT_MAX_COLUMNS 2000              // SQLITE_MAX_COLUMN default
+#endif
+
+typedef enum ImportReadMode {
+    IMPORT_READ_AUTO,       // memory map when available, otherwise stream
+    IMPORT_READ_MMAP,
+    IMPORT_READ_STREAM
+} ImportReadMode;
+
+typedef struct ImportOptions {
+    char delimiter;             // ',' when not set, '\t' for TSV
+    bool hasHeader;             // first record holds column names for INSERT
+    bool isEmptyNull;           // unquoted empty fields are bound as NULL, otherwise as ''
+    bool useProducerThread;     // parse on separate thread while rows are inserted, requires SQLITE_WRAPPER_THREADS
+    ImportReadMode readMode;
+    uint32_t commitRows;        // SQLITE_IMPORT_DEFAULT_COMMIT_ROWS when not set
+    const char *insertSql;      // optional statement with positional parameters, replaces generated INSERT
+} ImportOptions;
+
+typedef struct ImportStats {
+    uint64_t rowsImported;      // rows from committed transactions
+    uint64_t bytesParsed;
+    uint32_t batchCount;
+    uint64_t elapsedMicros;
+    uint64_t errorRow;          // 1 based data row that failed, 0 on success
+} ImportStats;
+
+
+// Fields are bound positionally as text, column affinity converts numbers. Record with more fields than
+// statement parameters fails with SQLITE_RANGE, missing fields are bound as NULL.
+// On error current transaction is rolled back, already committed rows stay in db
+int sqliteImportFile(sqlite3 *db, const char *filePath, const char *table, const ImportOptions *options, ImportStats *stats);
+int sqliteImportStream(sqlite3 *db, FILE *file, const char *table, const ImportOptions *options, ImportStats *stats);
+int sqliteImportBuffer(sqlite3 *db, const char *data, size_t size, const char *table, const ImportOptions *options, ImportStats *stats);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "SqliteParameter.h"
+
+#ifndef SQLITE_DEFAULT_BUSY_TIMEOUT_MS
+    #define SQLITE_DEFAULT_BUSY_TIMEOUT_MS 5000
+#endif
+
+// Presets for sqliteDbInitWithOptions()
+#define SQLITE_DURABLE_OPTIONS (&(SqliteOpenOptions) {  \
+    .journalMode = DB_JOURNAL_WAL,                      \
+    .synchronous = DB_SYNC_FULL,                        \
+    .busyTimeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS})
+
+// Last transactions can be lost on power failure, db file is never corrupted
+#define SQLITE_FAST_INGEST_OPTIONS (&(SqliteOpenOptions) {  \
+    .journalMode = DB_JOURNAL_WAL,                          \
+    .synchronous = DB_SYNC_OFF,                             \
+    .cacheSize = -65536,                                    \
+    .tempStore = DB_TEMP_STORE_MEMORY,                      \
+    .busyTimeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS})
+
+#define SQLITE_READ_ONLY_ANALYTICS_OPTIONS (&(SqliteOpenOptions) {  \
+    .openFlags = SQLITE_OPEN_READONLY,                              \
+    .mmapSize = 268435456,                                          \
+    .cacheSize = -65536,                                            \
+    .tempStore = DB_TEMP_STORE_MEMORY,                              \
+    .busyTimeoutMs = SQLITE_DEFAULT_BUSY_TIMEOUT_MS})
+
+// Zero values keep sqlite defaults
+typedef enum DbJournalMode {
+    DB_JOURNAL_DEFAULT = 0,
+    DB_JOURNAL_DELETE,
+    DB_JOURNAL_TRUNCATE,
+    DB_JOURNAL_PERSIST,
+    DB_JOURNAL_MEMORY,
+    DB_JOURNAL_WAL,
+    DB_JOURNAL_OFF
+} DbJournalMode;
+
+typedef enum DbSynchronous {
+    DB_SYNC_DEFAULT = 0,
+    DB_SYNC_OFF,
+    DB_SYNC_NORMAL,
+    DB_SYNC_FULL,
+    DB_SYNC_EXTRA
+} DbSynchronous;
+
+typedef enum DbTempStore {
+    DB_TEMP_STORE_DEFAULT = 0,
+    DB_TEMP_STORE_FILE,
+    DB_TEMP_STORE_MEMORY
+} DbTempStore;
+
+typedef struct SqliteOpenOptions {
+    int openFlags;              // sqlite3_open_v2() flags, 0 - read/write and create
+    DbJournalMode journalMode;
+    DbSynchronous synchronous;
+    DbTempStore tempStore;
+    int64_t mmapSize;           // bytes
+    int32_t cacheSize;          // pages, negative value is size in KiB
+    uint32_t pageSize;          // applied only for new db, before journal mode
+    uint32_t busyTimeoutMs;
+} SqliteOpenOptions;
+
+
+// Open flags without read/write mode get SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE
+int sqliteOpenFlags(const SqliteOpenOptions *options);
+// Sets busy timeout and pragmas, stops on first error
+int sqliteApplyOpenOptions(sqlite3 *db, const SqliteOpenOptions *options);
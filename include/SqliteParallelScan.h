@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SqlitePool.h"
+#include "SqliteColumnBatch.h"
+
+#ifndef SQLITE_PARALLEL_SCAN_MAX_PARTITIONS
+    #define SQLITE_PARALLEL_SCAN_MAX_PARTITIONS 64
+#endif
+
+#ifndef SQLITE_PARALLEL_SCAN_BATCH_ROWS
+    #define SQLITE_PARALLEL_SCAN_BATCH_ROWS 1024
+#endif
+
+// Partition bounds are bound to these named parameters as inclusive range, e.g. "WHERE rowid BETWEEN :scan_from AND :scan_to"
+#define SQLITE_SCAN_FROM_PARAM "scan_from"
+#define SQLITE_SCAN_TO_PARAM "scan_to"
+
+typedef struct ParallelScanOptions {
+    const char *table;          // key range is taken from min() and max() of key column
+    const char *keyColumn;      // integer primary key or indexed integer column, NULL - rowid
+    uint32_t partitionCount;    // 0 or more than pool readers - one partition per reader
+    uint32_t batchRows;         // column batch capacity, 0 - SQLITE_PARALLEL_SCAN_BATCH_ROWS
+} ParallelScanOptions;
+
+// Called on partition thread, result set is deleted after return. Non SQLITE_OK result stops other partitions
+typedef int (*PartitionScanCallback)(void *context, uint32_t partition, ResultSet *resultSet);
+// Calls are serialized, so batches of all partitions are merged to single stream. Batch is valid until return
+typedef int (*ColumnBatchScanCallback)(void *context, uint32_t partition, ColumnBatch *batch);
+
+
+// Splits key range of table to partitions and runs 'sql' for each range on own reader connection and thread.
+// Caller thread runs first partition. With SQLITE_ENABLE_SNAPSHOT all partitions read the same WAL snapshot,
+// otherwise each partition starts own read transaction. Returns first error of partitions or callbacks
+int poolParallelScan(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams, const ParallelScanOptions *options,
+                     PartitionScanCallback callback, void *context);
+int poolParallelScanBatches(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams, const ParallelScanOptions *options,
+                            ColumnBatchScanCallback callback, void *context);
@@ -17,10 +17,13 @@
 #define DB_DOUBLE_VALUE(value) ((DbValue) {.type = DB_VALUE_REAL, .as.doubleValue = (value)})
 #define DB_NULL_VALUE(value) ((DbValue) {.type = DB_VALUE_NULL})
 #define DB_STR_VALUE(value) ((DbValue) {.type = DB_VALUE_TEXT, .as.strValue = (value)})
+// NULL pointer binds zero filled blob of given size, it can be filled later with incremental blob write
+#define DB_BLOB_VALUE(value, size) ((DbValue) {.type = DB_VALUE_BLOB, .length = (size), .as.blobValue = (void *) (value)})
 
 #define DB_VALUE_AS_INT(value) ((value).as.intValue)
 #define DB_VALUE_AS_DOUBLE(value) ((value).as.doubleValue)
 #define DB_VALUE_AS_STR(value) ((value).as.strValue)
+#define DB_VALUE_AS_BLOB(value) ((value).as.blobValue)
 
 typedef enum DbValueType {
     DB_VALUE_NULL = 1,    // Value is NULL (or a pointer)
@@ -32,6 +35,7 @@ typedef enum DbValueType {
 
 typedef struct DbValue {
     DbValueType type;
+    uint32_t length;    // blob size in bytes
     union {
         int64_t intValue;
         double doubleValue;
@@ -57,6 +61,10 @@ static inline DbValue doubleDbValue(double value) {
     return DB_DOUBLE_VALUE(value);
 }
 
+static inline DbValue dbValueOf(DbValue value) {
+    return value;
+}
+
 #define DB_VALUE(X)              \
     _Generic((X),                \
         int: intDbValue,         \
@@ -64,7 +72,8 @@ static inline DbValue doubleDbValue(double value) {
         default: nullDbValue,    \
         char*: strDbValue,       \
         float: doubleDbValue,    \
-        double: doubleDbValue    \
+        double: doubleDbValue,   \
+        DbValue: dbValueOf       \
     )(X)
 
 
@@ -199,4 +208,31 @@ CREATE_HASH_MAP_TYPE(str, DbValue); // creates: 'str_DbValueMap'
                         CREATE_SQL_PARAM_MAP_1,                   \
                         ERROR)(str, DbValue, __VA_ARGS__)
 
-#define NEW_SQL_PARAM_MAP(CAPACITY)  NEW_HASH_MAP_1(str, DbValue, CAPACITY)
\ No newline at end of file
+#define NEW_SQL_PARAM_MAP(CAPACITY)  NEW_HASH_MAP_1(str, DbValue, CAPACITY)
+
+// Stack parameter lists without count limit and hashing, arrays are compound literals valid in enclosing block
+typedef struct SqlParam {
+    const char *name;
+    DbValue value;
+} SqlParam;
+
+typedef struct SqlParamList {
+    const SqlParam *params;
+    uint32_t count;
+} SqlParamList;
+
+// Values by distinct parameter order of first appearance in sql, e.g. ":a, :b, :a" takes 2 values
+typedef struct SqlValueList {
+    const DbValue *values;
+    uint32_t count;
+} SqlValueList;
+
+#define SQL_PARAM(NAME, VALUE) ((SqlParam) {.name = (NAME), .value = DB_VALUE(VALUE)})
+// SQL_PARAMS(SQL_PARAM("id", 1), SQL_PARAM("name", "text"), ...)
+#define SQL_PARAMS(...) (&(SqlParamList) {      \
+    .params = (SqlParam[]) {__VA_ARGS__},       \
+    .count = sizeof((SqlParam[]) {__VA_ARGS__}) / sizeof(SqlParam)})
+// SQL_VALUES(DB_VALUE(1), DB_VALUE("text"), ...)
+#define SQL_VALUES(...) (&(SqlValueList) {      \
+    .values = (DbValue[]) {__VA_ARGS__},        \
+    .count = sizeof((DbValue[]) {__VA_ARGS__}) / sizeof(DbValue)})
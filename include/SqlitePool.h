@@ -0,0 +1,39 @@
+#pragma once
+
+#include <pthread.h>
+#include "SqliteResultSet.h"
+#include "SqliteConnection.h"
+#include "SqliteOpenOptions.h"
+
+typedef struct SqlitePoolSlot {
+    sqlite3 *db;
+    volatile int isBusy;
+} SqlitePoolSlot;
+
+// Single writer and N reader connections to the same db file in WAL mode
+typedef struct SqlitePool {
+    SqlitePoolSlot *slots;  // writer slot is first, readers follow
+    uint32_t readerCount;
+    volatile uint32_t nextReader;
+    volatile int waiterCount;
+    pthread_mutex_t waitMutex;
+    pthread_cond_t slotReleased;
+} SqlitePool;
+
+
+// Writer and readers are counted in SQLITE_MAX_CONNECTIONS, NULL is returned when they don't fit
+SqlitePool *newSqlitePool(const char *dbName, uint32_t readerCount);
+// Writer is always opened in WAL mode, readers are read only. Connections are opened with SQLITE_OPEN_NOMUTEX,
+// because each one is used by single thread at a time
+SqlitePool *newSqlitePoolWithOptions(const char *dbName, uint32_t readerCount, const SqliteOpenOptions *options);
+
+sqlite3 *sqlitePoolAcquireReader(SqlitePool *pool);
+sqlite3 *sqlitePoolAcquireWriter(SqlitePool *pool);
+void sqlitePoolRelease(SqlitePool *pool, sqlite3 *db);
+
+// Reader connection is returned to the pool on resultSetDelete()
+ResultSet *poolExecuteQuery(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams);
+ResultSet *poolExecuteCallbackQuery(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams);
+int poolExecuteUpdate(SqlitePool *pool, const char *sql, str_DbValueMap *queryParams);
+
+void deleteSqlitePool(SqlitePool *pool);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SqliteParameter.h"
+#include "SqliteArena.h"
 
 #ifndef DEFAULT_SQLITE_QUERY_STRING_SIZE
     #define DEFAULT_SQLITE_QUERY_STRING_SIZE 128
@@ -11,20 +12,25 @@
 #endif
 
 typedef struct QueryString {
-    char *value;
+    char *value;        // always null terminated
     uint32_t size;
     uint32_t capacity;
+    SqliteArena *arena; // NULL for heap allocated string
 } QueryString;
 
 
 QueryString *newQueryString();
 QueryString *newQueryStringWithSize(uint32_t capacity);
+// String is released with arena reset, deleteQueryString() is not required
+QueryString *newQueryStringWithArena(SqliteArena *arena, uint32_t capacity);
 
 QueryString *queryStringAppend(QueryString *str, const char* value, uint32_t valueLength);
 QueryString *queryStringAppendChar(QueryString *str, char charValue);
 
 QueryString *queryStringOf(const char* format, ...);
 QueryString *namedQueryString(const char* sql, str_DbValueMap *queryParams);
+QueryString *namedQueryStringWithArena(SqliteArena *arena, const char* sql, str_DbValueMap *queryParams);
+QueryString *nativeQueryString(const char* sql, Vector paramNames);
 
 const char *queryStringGetValue(QueryString *str);
 void deleteQueryString(QueryString *str);
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "SqliteStatement.h"
+
+#ifndef SQLITE_QUERY_STATS_MAX_TEMPLATES
+    #define SQLITE_QUERY_STATS_MAX_TEMPLATES 256
+#endif
+
+#ifndef SQLITE_QUERY_STATS_MAX_ACTIVE
+    #define SQLITE_QUERY_STATS_MAX_ACTIVE 16     // concurrently executed statements per connection
+#endif
+
+// Aggregated per distinct named sql template
+typedef struct QueryStats {
+    const char *sql;
+    const char *queryPlan;          // EXPLAIN QUERY PLAN detail lines from first execution, NULL if not captured
+    uint64_t callCount;
+    uint64_t prepareCount;          // statement cache misses
+    uint64_t totalPrepareMicros;
+    uint64_t maxPrepareMicros;
+    uint64_t totalStepNanos;        // from first step to reset, reported by SQLITE_TRACE_PROFILE
+    uint64_t maxStepNanos;
+    uint64_t rowsReturned;
+    uint64_t rowsChanged;
+    uint64_t bytesBound;
+    uint64_t fullScanSteps;         // SQLITE_STMTSTATUS_FULLSCAN_STEP
+    uint64_t sortCount;             // SQLITE_STMTSTATUS_SORT
+    uint64_t totalBusyWaitMicros;   // lock waits of wrapper busy handler
+    uint64_t maxBusyWaitMicros;
+} QueryStats;
+
+// Single statement execution, passed to sink when statement is released
+typedef struct QueryExecution {
+    const char *sql;
+    bool isPrepared;                // false when statement is taken from cache
+    uint64_t prepareMicros;
+    uint64_t stepNanos;
+    uint64_t rowsReturned;
+    uint64_t rowsChanged;
+    uint64_t bytesBound;
+    uint64_t busyWaitMicros;
+} QueryExecution;
+
+typedef void (*QueryStatsSink)(void *context, const QueryExecution *execution);
+
+typedef struct QueryStatsOptions {
+    bool captureQueryPlan;
+    QueryStatsSink sink;
+    void *sinkContext;
+} QueryStatsOptions;
+
+typedef struct QueryStatsEntry {
+    QueryStats stats;
+    uint32_t sqlHash;
+    bool isPlanCaptured;
+    struct QueryStatsEntry *bucketNext;
+    struct QueryStatsEntry *next;   // insertion order
+} QueryStatsEntry;
+
+typedef struct QueryStatsExecution {
+    sqlite3_stmt *stmt;             // NULL for free slot
+    sqlite3_stmt *tailStmt;         // following statement of multi statement sql, counted to the same execution
+    SqliteStatement *statement;     // its 'queryStats' is cleared when execution is completed
+    QueryStatsEntry *entry;
+    struct QueryStatsRegistry *registry;
+    QueryExecution values;
+    uint64_t busyWaitStartMicros;   // connection busy wait counter when execution began
+} QueryStatsExecution;
+
+typedef struct QueryStatsRegistry {
+    sqlite3 *db;
+    bool isEnabled;
+    QueryStatsOptions options;
+    QueryStatsEntry *buckets[SQLITE_QUERY_STATS_MAX_TEMPLATES];
+    QueryStatsEntry *head;
+    QueryStatsEntry *tail;
+    uint32_t templateCount;
+    uint64_t droppedExecutions;     // template limit reached or too many active statements
+    uint64_t busyWaitMicros;        // all lock waits of connection, never reset
+    QueryStatsExecution active[SQLITE_QUERY_STATS_MAX_ACTIVE];
+} QueryStatsRegistry;
+
+
+QueryStatsRegistry *newQueryStatsRegistry(sqlite3 *db);
+
+// Installs sqlite3_trace_v2() callback, so it replaces any user trace on connection
+int queryStatsEnable(QueryStatsRegistry *registry, const QueryStatsOptions *options);
+// Active executions are completed right away without remaining step time, so statements don't point to registry
+void queryStatsDisable(QueryStatsRegistry *registry);
+
+// Start tracking of acquired statement, 'isPrepared' is false for cached statement
+void queryStatsBegin(QueryStatsRegistry *registry, SqliteStatement *statement, bool isPrepared, uint64_t prepareMicros);
+void queryStatsAddBoundBytes(SqliteStatement *statement, str_DbValueMap *queryParams);
+void queryStatsAddBoundValue(SqliteStatement *statement, DbValue value);
+// Resets statement and folds execution values to template stats
+void queryStatsEnd(SqliteStatement *statement);
+// Following statements of multi statement sql, prepared separately for each execution
+void queryStatsTailBegin(SqliteStatement *statement, sqlite3_stmt *stmt);
+void queryStatsTailEnd(SqliteStatement *statement, sqlite3_stmt *stmt);
+
+// Copies up to 'maxCount' template stats, returns number of tracked templates.
+// String pointers are valid until connection is closed
+uint32_t queryStatsSnapshot(QueryStatsRegistry *registry, QueryStats *stats, uint32_t maxCount);
+// Counters are zeroed, templates and captured plans are kept
+void queryStatsReset(QueryStatsRegistry *registry);
+
+void deleteQueryStatsRegistry(QueryStatsRegistry *registry);
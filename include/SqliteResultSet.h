@@ -1,29 +1,71 @@
 #pragma once
 
-#include "SqliteQuery.h"
+#include "SqliteStatement.h"
+
+#ifndef SQLITE_RESULT_SET_ARENA_SIZE
+    #define SQLITE_RESULT_SET_ARENA_SIZE 1024
+#endif
+
+typedef void (*ResultSetReleaseCallback)(void *context, sqlite3 *db);
 
 typedef struct ResultSet {
     sqlite3 *db;    // sqlite3* db is used to print errmsg
     sqlite3_stmt *stmt;
+    SqliteStatement *statement;    // reset after the last row and released on delete instead of finalize
+    sqlite3_stmt *finishedStmt;    // not wrapped statement after the last row, finalized on delete
     HashMap columnMap;
+    bool isColumnMapShared;     // owned by statement and reused between executions
     int valueIndex;
-    Vector valueVec;
+    int stepResult;     // last sqlite3_step() result, SQLITE_DONE when all rows are read
+    bool isRowPending;  // current row is stepped, but not returned by nextResultSet() or fetched to column batch yet
+
+    // Callback result set values, all rows are stored as terminated strings with type and length prefix to the single arena
+    char **columnNames;
+    uint32_t columnCount;
+    uint32_t rowCount;
+    uint32_t *valueOffsets;     // row * columnCount + column -> arena offset
+    uint32_t offsetCapacity;
+    char *valueArena;
+    uint32_t arenaSize;
+    uint32_t arenaCapacity;
+
+    ResultSetReleaseCallback releaseCallback;   // returns borrowed connection on delete
+    void *releaseContext;
+    SqliteArena *arena;     // result set and row storage allocator, NULL for heap
 } ResultSet;
 
 
 // Create a cursor
 ResultSet *newSqliteResultSet(sqlite3 *db, sqlite3_stmt *stmt);
+ResultSet *newSqliteResultSetWithArena(sqlite3 *db, sqlite3_stmt *stmt, SqliteArena *arena);
+// Cursor over wrapper statement, column map is taken from statement
+ResultSet *newStatementResultSet(SqliteStatement *statement, SqliteArena *arena);
 bool nextResultSet(ResultSet *resultSet);
 
+// Copy row values to callback result set, all rows should have same columns. Row without columns is rejected
+bool resultSetAppendRow(ResultSet *resultSet, int valueCount, char **values, char **columnNames);
+// Same with value sizes in bytes, so blobs are copied with zeros. NULL lengths are taken with strlen()
+bool resultSetAppendRowWithLengths(ResultSet *resultSet, int valueCount, char **values, const uint32_t *lengths, char **columnNames);
+// Same with value types returned by rsGetColumnType(), values are still passed as text. NULL types - all values are text
+bool resultSetAppendTypedRow(ResultSet *resultSet, int valueCount, char **values, const uint32_t *lengths, const DbValueType *types, char **columnNames);
+
+// Resolve column name once and use index getters in loops, returns -1 if column not found.
+// Called before the first row, it steps the cursor, so index is valid after statement re-prepare
+int rsColumnIndex(ResultSet *resultSet, const char *columnName);
+
 int rsGetInt(ResultSet *resultSet, const char *columnName);
 int64_t rsGetI64(ResultSet *resultSet, const char *columnName);
 const char *rsGetString(ResultSet *resultSet, const char *columnName);
 double rsGetDouble(ResultSet *resultSet, const char *columnName);
+// Value is not copied, pointer is valid until next row. Callback result set returns text value
+const void *rsGetBlob(ResultSet *resultSet, const char *columnName, uint32_t *length);
 
 int rsGetIntByIndex(ResultSet *resultSet, int columnIndex);
 int64_t rsGetI64ByIndex(ResultSet *resultSet, int columnIndex);
 const char *rsGetStringByIndex(ResultSet *resultSet, int columnIndex);
 double rsGetDoubleByIndex(ResultSet *resultSet, int columnIndex);
+const void *rsGetBlobByIndex(ResultSet *resultSet, int columnIndex, uint32_t *length);
 
 DbValueType rsGetColumnType(ResultSet *resultSet, const char *columnName);
+DbValueType rsGetColumnTypeByIndex(ResultSet *resultSet, int columnIndex);
 void resultSetDelete(ResultSet *resultSet);
\ No newline at end of file
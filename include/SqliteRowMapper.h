@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include "SqliteResultSet.h"
+
+#ifndef SQLITE_ROW_MAPPER_MAX_FIELDS
+    #define SQLITE_ROW_MAPPER_MAX_FIELDS 64     // fields per mapping and parameters per struct binding
+#endif
+
+typedef enum RowFieldType {
+    ROW_FIELD_BOOL,
+    ROW_FIELD_INT,
+    ROW_FIELD_U32,
+    ROW_FIELD_I64,
+    ROW_FIELD_FLOAT,
+    ROW_FIELD_DOUBLE,
+    ROW_FIELD_STR,      // char *, copied to arena or heap
+    ROW_FIELD_TEXT      // char[N], copied and truncated to N - 1 chars
+} RowFieldType;
+
+typedef struct RowField {
+    const char *columnName;
+    RowFieldType type;
+    uint32_t offset;
+    uint32_t size;
+} RowField;
+
+// Field list for one struct type, built at compile time
+typedef struct RowMapping {
+    const RowField *fields;
+    uint32_t fieldCount;
+    uint32_t structSize;
+} RowMapping;
+
+// Unsupported member type fails to compile, char arrays should use ROW_TEXT_FIELD()
+#define ROW_FIELD_TYPE_OF(X)    \
+    _Generic((X),               \
+    bool: ROW_FIELD_BOOL,       \
+    int: ROW_FIELD_INT,         \
+    uint32_t: ROW_FIELD_U32,    \
+    int64_t: ROW_FIELD_I64,     \
+    float: ROW_FIELD_FLOAT,     \
+    double: ROW_FIELD_DOUBLE,   \
+    char *: ROW_FIELD_STR,      \
+    const char *: ROW_FIELD_STR)
+
+#define ROW_FIELD(STRUCT, MEMBER, COLUMN) {         \
+    .columnName = (COLUMN),                         \
+    .type = ROW_FIELD_TYPE_OF(((STRUCT *) 0)->MEMBER), \
+    .offset = offsetof(STRUCT, MEMBER),             \
+    .size = sizeof(((STRUCT *) 0)->MEMBER)}
+
+#define ROW_TEXT_FIELD(STRUCT, MEMBER, COLUMN) {    \
+    .columnName = (COLUMN),                         \
+    .type = ROW_FIELD_TEXT,                         \
+    .offset = offsetof(STRUCT, MEMBER),             \
+    .size = sizeof(((STRUCT *) 0)->MEMBER)}
+
+// Statement parameters resolved to struct fields, parameter name is matched with field column name
+typedef struct StructBinding {
+    const RowMapping *mapping;
+    uint32_t paramCount;
+    int fieldIndexes[SQLITE_ROW_MAPPER_MAX_FIELDS];   // -1 - parameter without field is bound as NULL
+} StructBinding;
+
+// static const RowMapping userMapping = ROW_MAPPING(User, userFields);
+#define ROW_MAPPING(STRUCT, FIELDS) {.fields = (FIELDS), .fieldCount = sizeof(FIELDS) / sizeof((FIELDS)[0]), .structSize = sizeof(STRUCT)}
+
+
+// Reads up to 'maxRows' next rows to 'rows' array. Column indexes are resolved once per prepared statement
+// and cached with mapping fields, they are resolved again after re-prepare.
+// NULL values are mapped to 0, NULL pointer or empty text. Returns SQLITE_RANGE when mapped column is not in result set
+int rsMapRows(ResultSet *resultSet, const RowMapping *mapping, void *rows, uint32_t maxRows, SqliteArena *arena, uint32_t *rowCount);
+// Maps current row, for single lookups after nextResultSet()
+int rsMapRow(ResultSet *resultSet, const RowMapping *mapping, void *row, SqliteArena *arena);
+
+// Releases ROW_FIELD_STR values mapped without arena
+void freeMappedRows(const RowMapping *mapping, void *rows, uint32_t rowCount);
+
+// Resolves parameter indexes once, then each struct is bound without intermediate parameter map
+int sqliteStructBindingInit(StructBinding *binding, SqliteStatement *statement, const RowMapping *mapping);
+// Text is bound without copy, so struct must be valid until statement is stepped
+int sqliteStatementBindStruct(SqliteStatement *statement, const StructBinding *binding, const void *row);
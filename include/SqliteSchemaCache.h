@@ -0,0 +1,52 @@
+#pragma once
+
+#include "SqliteParameter.h"
+
+typedef struct SchemaColumn {
+    char *name;
+    char *declaredType;     // empty string when type is not declared
+    bool isNotNull;
+    bool isPrimaryKey;
+} SchemaColumn;
+
+typedef struct SchemaTable {
+    char *name;
+    uint32_t columnCount;   // 0 when table doesn't exist
+    SchemaColumn *columns;
+    HashMap columnMap;      // column name -> index
+    uint32_t indexCount;
+    char **indexNames;
+} SchemaTable;
+
+// Schema of cached tables, version is incremented on any schema change, also by other connections
+typedef struct SchemaVersion {
+    char *schemaName;
+    sqlite3_stmt *stmt;     // 'PRAGMA <schema>.schema_version'
+    int version;            // -1 when schema is not attached
+} SchemaVersion;
+
+// Tables are loaded lazily and dropped when schema version of any cached table schema changes.
+// Unqualified names depend on 'main' and 'temp' schemas, qualified ones on their own schema
+typedef struct SchemaCache {
+    sqlite3 *db;
+    SchemaVersion *schemas;
+    uint32_t schemaCount;
+    HashMap tableMap;       // table name -> SchemaTable
+    Vector tables;
+    SchemaTable *missingTable;  // last lookup of not existing table, misses are not cached
+} SchemaCache;
+
+
+SchemaCache *newSchemaCache(sqlite3 *db);
+
+// Returned table is valid until next schema change, NULL on error. Table name can be qualified as 'schema.table'.
+// Not existing table is returned with zero columns and is valid only until next lookup of not existing table
+const SchemaTable *schemaCacheGetTable(SchemaCache *cache, const char *tableName);
+int schemaTableColumnIndex(const SchemaTable *table, const char *columnName);
+
+// Loads table without cache, for connections that are not registered by wrapper
+SchemaTable *newSchemaTable(sqlite3 *db, const char *tableName);
+void deleteSchemaTable(SchemaTable *table);
+
+void schemaCacheClear(SchemaCache *cache);
+void deleteSchemaCache(SchemaCache *cache);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SqlitePool.h"
+
+#ifndef SQLITE_SHARDS_MAX_COUNT
+    #define SQLITE_SHARDS_MAX_COUNT 64  // each shard opens readers and writer, all counted in SQLITE_MAX_CONNECTIONS
+#endif
+
+#ifndef SQLITE_SHARDS_READERS
+    #define SQLITE_SHARDS_READERS 2     // reader connections per shard file
+#endif
+
+#ifndef SQLITE_SHARDS_MAX_ORDER_TERMS
+    #define SQLITE_SHARDS_MAX_ORDER_TERMS 8
+#endif
+
+#if SQLITE_SHARDS_MAX_COUNT * (SQLITE_SHARDS_READERS + 1) > SQLITE_MAX_CONNECTIONS
+    #error "SQLITE_MAX_CONNECTIONS is too small for SQLITE_SHARDS_MAX_COUNT shards"
+#endif
+
+typedef struct ShardOptions {
+    const SqliteOpenOptions *openOptions;   // NULL - SQLITE_DEFAULT_BUSY_TIMEOUT_MS, shard files are always in WAL mode
+    uint32_t readersPerShard;               // 0 - SQLITE_SHARDS_READERS
+} ShardOptions;
+
+// Rows are distributed over shard files by hash of single key parameter, each shard has own writer and readers
+typedef struct SqliteShards {
+    SqlitePool **pools;
+    uint32_t shardCount;
+    char *keyParam;         // parameter name without ':'
+} SqliteShards;
+
+
+// Shard of a key depends on shard count and order of files, so both should stay the same for existing data.
+// NULL is returned when shard connections don't fit SQLITE_MAX_CONNECTIONS
+SqliteShards *newSqliteShards(const char *const *dbNames, uint32_t shardCount, const char *keyParam, const ShardOptions *options);
+
+// Integer, real, text and blob keys are hashed by value, so the same key should always be bound with the same type
+uint32_t shardsKeyIndex(SqliteShards *shards, DbValue key);
+
+// Routed to the shard of key parameter, SQLITE_MISUSE when key is missing or NULL
+int shardsExecuteUpdate(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams);
+// Executed on each shard in order, e.g. schema changes. Not atomic, returns first error
+int shardsExecuteUpdateAll(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams);
+
+// With key parameter query is routed to single shard and cursor is returned. Otherwise query is executed on all shards in parallel
+// and rows are merged to callback result set: by top level ORDER BY of result columns with k-way merge, or concatenated.
+// LIMIT is applied after merge. OFFSET, GROUP BY, DISTINCT, aggregate functions, UNION, INTERSECT, EXCEPT
+// and ORDER BY with collation other than BINARY can't be merged, so NULL is returned for them without querying shards.
+// The same is checked in FROM subqueries and CTEs, which also can't have LIMIT. Window functions are not supported at all.
+// Declared column collation is checked only with SQLITE_ENABLE_COLUMN_METADATA
+ResultSet *shardsExecuteQuery(SqliteShards *shards, const char *sql, str_DbValueMap *queryParams);
+
+void deleteSqliteShards(SqliteShards *shards);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "SqliteQuery.h"
+#include "SqliteDeadline.h"
+
+struct QueryStatsExecution;
+
+typedef struct SqliteStatement {
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    char *sql;          // original named query, used as statement cache key
+    uint32_t sqlHash;
+    Vector paramNames;  // named parameter for each native '?NNN' index, starting from 1
+    char *tailSql;      // native sql of following statements, NULL for single statement sql
+    HashMap columnMap;  // column name -> index, names are copied to 'columnNames' block
+    char **columnNames;
+    int columnPrepareCount; // SQLITE_STMTSTATUS_REPREPARE value when column map was built
+    const void *mappingKey; // row mapping fields resolved to 'mappingColumns' by row mapper
+    int *mappingColumns;    // field -> column index
+    uint32_t mappingFieldCount;
+    int mappingPrepareCount;
+    bool isCached;      // owned by statement cache, reset on release instead of finalize
+    bool isInUse;       // acquired by query or result set
+    struct QueryStatsExecution *queryStats;    // current execution tracking, NULL when stats are disabled
+    DeadlineState deadline;     // armed for single call or cursor, checked only while statement is stepped
+
+    struct SqliteStatement *prev;       // statement cache LRU list
+    struct SqliteStatement *next;
+    struct SqliteStatement *bucketNext; // statement cache hash bucket chain
+} SqliteStatement;
+
+
+SqliteStatement *newSqliteStatement(sqlite3 *db, const char *sql);
+
+// Text values are bound without copy when 'copyValues' is false, so statement must be completed before parameters are freed
+int sqliteStatementBind(SqliteStatement *statement, str_DbValueMap *queryParams, bool copyValues);
+int sqliteBindParams(sqlite3_stmt *stmt, Vector paramNames, str_DbValueMap *queryParams, bool copyValues);
+// List in the same order as sql parameters is matched without search, missing parameters are bound as NULL
+int sqliteStatementBindList(SqliteStatement *statement, const SqlParamList *params, bool copyValues);
+// Value count must match distinct parameter count, otherwise SQLITE_RANGE is returned
+int sqliteStatementBindValues(SqliteStatement *statement, const SqlValueList *values, bool copyValues);
+// Statement deadline is active only during step, previous active deadline is restored after it
+int sqliteStatementStep(SqliteStatement *statement);
+void sqliteStatementReset(SqliteStatement *statement);
+// Ends current execution: stats and deadline are completed and read lock is released, statement stays acquired
+void sqliteStatementFinish(SqliteStatement *statement);
+void sqliteStatementRelease(SqliteStatement *statement);
+
+// Built once per prepared statement and rebuilt only after re-prepare, NULL when statement has no columns
+HashMap sqliteStatementColumnMap(SqliteStatement *statement);
+
+uint32_t sqliteStatementHash(const char *sql);
+void deleteSqliteStatement(SqliteStatement *statement);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "SqliteStatement.h"
+
+#ifndef SQLITE_STATEMENT_CACHE_DEFAULT_CAPACITY
+    #define SQLITE_STATEMENT_CACHE_DEFAULT_CAPACITY 32
+#endif
+
+typedef struct StatementCacheStats {
+    uint32_t size;
+    uint32_t capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} StatementCacheStats;
+
+typedef struct StatementCache {
+    SqliteStatement **buckets;
+    uint32_t bucketCount;
+    SqliteStatement *head;  // most recently used
+    SqliteStatement *tail;  // least recently used, evicted first
+    StatementCacheStats stats;
+} StatementCache;
+
+
+StatementCache *newStatementCache(uint32_t capacity);
+
+SqliteStatement *statementCacheAcquire(StatementCache *cache, const char *sql);
+bool statementCachePut(StatementCache *cache, SqliteStatement *statement);
+
+void statementCacheSetCapacity(StatementCache *cache, uint32_t capacity);
+StatementCacheStats statementCacheGetStats(StatementCache *cache);
+
+void statementCacheClear(StatementCache *cache);
+void deleteStatementCache(StatementCache *cache);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "SqliteConnection.h"
+
+#ifndef SQLITE_TRANSACTION_DEFAULT_RETRIES
+    #define SQLITE_TRANSACTION_DEFAULT_RETRIES 3
+#endif
+
+#ifndef SQLITE_TRANSACTION_RETRY_DELAY_MS
+    #define SQLITE_TRANSACTION_RETRY_DELAY_MS 10     // multiplied by attempt number
+#endif
+
+typedef enum TransactionMode {
+    TRANSACTION_DEFERRED = 0,   // locks are taken by first read/write
+    TRANSACTION_IMMEDIATE,      // write lock on begin, other writers get SQLITE_BUSY before any work is done
+    TRANSACTION_EXCLUSIVE       // same as immediate in WAL mode, otherwise readers are blocked too
+} TransactionMode;
+
+typedef struct TransactionOptions {
+    TransactionMode mode;
+    uint32_t maxRetries;        // whole unit is repeated on SQLITE_BUSY, only for outer transaction
+    uint32_t retryDelayMs;
+} TransactionOptions;
+
+// Unit of work, any result other than SQLITE_OK rolls back transaction
+typedef int (*TransactionBody)(sqlite3 *db, void *context);
+
+
+// Outside of transaction starts new one with given mode, inside creates nested savepoint with generated name.
+// Connection should be opened by wrapper, as nesting level is stored in connection state
+int sqliteBeginTransaction(sqlite3 *db, TransactionMode mode);
+// Releases innermost savepoint or commits outer transaction
+int sqliteCommitTransaction(sqlite3 *db);
+// Rolls back innermost savepoint only, outer transaction stays active. Level stays open when rollback fails
+int sqliteRollbackTransaction(sqlite3 *db);
+// Open sqliteBeginTransaction() levels, 0 - no wrapper transaction
+uint32_t sqliteTransactionDepth(sqlite3 *db);
+
+// Begin, body and commit with rollback on error. NULL options - immediate mode with default retries.
+// On error all levels opened by unit are rolled back, body must close own nested levels before returning SQLITE_OK
+int sqliteRunInTransaction(sqlite3 *db, const TransactionOptions *options, TransactionBody body, void *context);
@@ -1,18 +1,75 @@
 #pragma once
 
 #include "SqliteResultSet.h"
+#include "SqliteColumnBatch.h"
+#include "SqliteRowMapper.h"
+#include "SqliteExport.h"
+#include "SqliteBlob.h"
+#include "SqliteConnection.h"
+#include "SqliteBatch.h"
+#include "SqliteTransaction.h"
+#include "SqliteImport.h"
+#include "SqliteOpenOptions.h"
+
+#ifdef SQLITE_WRAPPER_THREADS
+    #include "SqlitePool.h"
+    #include "SqliteAsync.h"
+    #include "SqliteWriteQueue.h"
+    #include "SqliteParallelScan.h"
+    #include "SqliteShards.h"
+#endif
 
 
 sqlite3 *sqliteDbInit(const char* dbName);
+// Options are applied before handle is returned, NULL is returned when open or any pragma fails
+// or SQLITE_MAX_CONNECTIONS connections are already open
+sqlite3 *sqliteDbInitWithOptions(const char* dbName, const SqliteOpenOptions *options);
 
 ResultSet *executeQuery(sqlite3 *db, const char *sql, str_DbValueMap *queryParams);
 int executeUpdate(sqlite3 *db, const char *sql, str_DbValueMap *queryParams);
+// Allocation free parameter lists without SQL_PARAM_MAP() size limit, see SQL_PARAMS() and SQL_VALUES()
+// Query result is NULL on error, 'rc' (can be NULL) receives error code, e.g. SQLITE_RANGE for wrong value count
+ResultSet *executeQueryWithList(sqlite3 *db, const char *sql, const SqlParamList *params, int *rc);
+ResultSet *executeQueryWithValues(sqlite3 *db, const char *sql, const SqlValueList *values, int *rc);
+int executeUpdateWithList(sqlite3 *db, const char *sql, const SqlParamList *params);
+int executeUpdateWithValues(sqlite3 *db, const char *sql, const SqlValueList *values);
+// Parameters are bound from struct fields with the same name as field column, see executeBatchStructUpdate() for arrays
+int executeStructUpdate(sqlite3 *db, const char *sql, const RowMapping *mapping, const void *row);
 
+// Rows of all statements are stored in single result set, so multi statement sql with different column count
+// returns NULL. executeCallbackQueryWithDeadline() reports it as SQLITE_MISMATCH
 ResultSet *executeCallbackQuery(sqlite3 *db, const char *sql, str_DbValueMap *queryParams);
+
+// Deadline and cancel token are enforced only for statement of the call, connection deadline is kept.
+// Cursor keeps deadline until all rows are read or result set is deleted, see ResultSet 'stepResult' for timeout.
+// Deadline is checked only while cursor is stepped, so other statements run while cursor is open are not interrupted.
+// Interrupted statement is reset and stays in cache, connection can be used right away
+// 'rc' is optional, set to SQLITE_QUERY_CANCELLED or sql error when NULL is returned
+ResultSet *executeQueryWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline, int *rc);
+int executeUpdateWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline);
+// 'rc' is optional, set to SQLITE_DEADLINE_EXCEEDED or SQLITE_QUERY_CANCELLED when NULL is returned on deadline
+ResultSet *executeCallbackQueryWithDeadline(sqlite3 *db, const char *sql, str_DbValueMap *queryParams, const QueryDeadline *deadline, int *rc);
+
+// Result set and row values are allocated from arena and released on arena reset.
+// resultSetDelete() is still required to return statement to cache
+ResultSet *executeQueryWithArena(sqlite3 *db, SqliteArena *arena, const char *sql, str_DbValueMap *queryParams);
+ResultSet *executeCallbackQueryWithArena(sqlite3 *db, SqliteArena *arena, const char *sql, str_DbValueMap *queryParams);
 int executeCallbackUpdate(sqlite3 *db, const char *sql, str_DbValueMap *queryParams);
 
+void sqliteSetStatementCacheCapacity(sqlite3 *db, uint32_t capacity);
+StatementCacheStats sqliteGetStatementCacheStats(sqlite3 *db);
+
+// Per sql template execution stats, disabled by default. Uses sqlite3_trace_v2() of the connection
+int sqliteEnableQueryStats(sqlite3 *db, const QueryStatsOptions *options);
+void sqliteDisableQueryStats(sqlite3 *db);
+uint32_t sqliteGetQueryStats(sqlite3 *db, QueryStats *stats, uint32_t maxCount);
+void sqliteResetQueryStats(sqlite3 *db);
+
+// Table metadata is cached per connection and reloaded after schema change
 bool idDbColumnExists(sqlite3 *db, const char *table, const char *columnName);
 Vector getDbTableColumnNames(sqlite3 *db, const char *table);
+// Columns with declared types and index names, valid until next schema change. NULL for db not opened by wrapper
+const SchemaTable *sqliteGetTableSchema(sqlite3 *db, const char *table);
 
 void deleteDbColumnNameVector(Vector columns);
 void sqliteDbClose(sqlite3 *db);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <pthread.h>
+#include "SqliteParameter.h"
+#include "SqliteOpenOptions.h"
+
+#ifndef SQLITE_WRITE_QUEUE_MAX_BATCH
+    #define SQLITE_WRITE_QUEUE_MAX_BATCH 512    // updates per transaction
+#endif
+
+typedef struct WriteQueueOptions {
+    const SqliteOpenOptions *openOptions;   // NULL - SQLITE_DURABLE_OPTIONS
+    uint32_t maxBatchItems;                 // 0 - SQLITE_WRITE_QUEUE_MAX_BATCH
+    uint32_t flushWindowMicros;             // wait for more updates after first one, 0 - flush what is already queued
+} WriteQueueOptions;
+
+typedef struct WriteQueueStats {
+    uint64_t flushCount;        // committed transactions
+    uint64_t itemCount;         // executed updates
+    uint64_t failedCount;       // updates with error result
+} WriteQueueStats;
+
+typedef struct WriteQueueItem WriteQueueItem;
+
+// Group commit: updates from many threads are executed by single writer connection, one transaction per flush
+typedef struct SqliteWriteQueue {
+    sqlite3 *db;
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t itemAdded;
+    pthread_cond_t itemDone;
+    WriteQueueItem *head;
+    WriteQueueItem *tail;
+    uint32_t queuedCount;
+    uint32_t maxBatchItems;
+    uint32_t flushWindowMicros;
+    bool isStopping;
+    WriteQueueStats stats;
+} SqliteWriteQueue;
+
+
+SqliteWriteQueue *newSqliteWriteQueue(const char *dbName, const WriteQueueOptions *options);
+
+// Blocks until transaction with this update is committed, so parameters are not copied.
+// Result is own for each caller: failed update doesn't affect others, unless error has rolled back whole transaction
+int writeQueueExecuteUpdate(SqliteWriteQueue *queue, const char *sql, str_DbValueMap *queryParams);
+
+WriteQueueStats writeQueueGetStats(SqliteWriteQueue *queue);
+
+// Queued updates are flushed before writer is stopped
+void deleteSqliteWriteQueue(SqliteWriteQueue *queue);